@@ -30,7 +30,13 @@
 #define CEREAL_ARCHIVES_BINARY_HPP_
 
 #include <cereal/cereal.hpp>
+#include <cereal/details/interning.hpp>
+#include <cereal/details/frames.hpp>
+#include <cereal/details/buffers.hpp>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 namespace cereal
 {
@@ -51,25 +57,150 @@ namespace cereal
   class BinaryOutputArchive : public OutputArchive<BinaryOutputArchive, AllowEmptyClassElision>
   {
     public:
+      //! A class containing various advanced options for the binary output archive
+      class Options
+      {
+        public:
+          //! Default options, nothing is framed
+          static Options Default(){ return Options(); }
+
+          //! Options that frame the objects of versioned classes
+          static Options Framed(){ return Options( true ); }
+
+          //! Specify specific options for the BinaryOutputArchive
+          /*! @param frameVersionedObjects Whether each object of a class with a versioned
+                                           serialize or save function is prefixed by its size.
+                                           Readers then skip whatever such an object's load
+                                           does not read, such as fields added by a newer
+                                           version, or the whole object if load returns
+                                           early for a version it does not know.  Loading
+                                           detects framing automatically.  Pointer targets,
+                                           polymorphic type names and class versions first
+                                           saved within an outermost frame are saved again
+                                           after it, so sharing between objects in different
+                                           outermost frames is not preserved.  A frame nested
+                                           in another can only be skipped if nothing was
+                                           first saved within it.  On a stream that can
+                                           seek, such as a file or string stream, each
+                                           size is patched in once its object is saved.
+                                           Any other stream receives an outermost framed
+                                           object only once it is saved completely, so it
+                                           is held in memory until then.
+              @param internStringsUpTo Strings of at most this many bytes are written in full
+                                       only the first time they are seen, and as a reference
+                                       to that first copy afterwards.  Longer strings are
+                                       always written in full, and 0 disables interning.
+                                       Loading detects interned strings automatically.
+                                       Strings first seen within an outermost frame are
+                                       written in full again after it, like pointer targets.
+              @param queuePointees Whether the target of each shared pointer is written after
+                                   the object holding the first pointer to it, rather than
+                                   within it.  This saves and loads chains of pointers of any
+                                   length without deep recursion.  Loading detects this
+                                   automatically, but load functions then see their pointers'
+                                   targets before those are loaded. */
+          explicit Options( bool frameVersionedObjects = false, std::size_t internStringsUpTo = 0,
+                            bool queuePointees = false ) :
+            itsFrameVersionedObjects( frameVersionedObjects ),
+            itsInternStringsUpTo( internStringsUpTo ),
+            itsQueuePointees( queuePointees ) { }
+
+        private:
+          friend class BinaryOutputArchive;
+          bool itsFrameVersionedObjects;
+          std::size_t itsInternStringsUpTo;
+          bool itsQueuePointees;
+      };
+
       //! Construct, outputting to the provided stream
       /*! @param stream The stream to output to.  Can be a stringstream, a file stream, or
-                        even cout! */
-      BinaryOutputArchive(std::ostream & stream) :
+                        even cout!
+          @param options The binary specific options to use.  See the Options struct
+                         for the values of default parameters */
+      BinaryOutputArchive(std::ostream & stream, Options const & options = Options::Default()) :
         OutputArchive<BinaryOutputArchive, AllowEmptyClassElision>(this),
-        itsStream(stream)
+        itsStream(stream),
+        itsFrameVersionedObjects(options.itsFrameVersionedObjects),
+        itsFrames(stream),
+        itsStrings(options.itsInternStringsUpTo),
+        itsQueuePointees(options.itsQueuePointees)
       { }
 
       //! Writes size bytes of data to the output stream
       void saveBinary( const void * data, std::size_t size )
       {
+        if( itsFrames.buffering() ) // the stream cannot seek to patch in the sizes of frames
+        {
+          itsFrames.append( reinterpret_cast<const char*>( data ), size );
+          return;
+        }
+
         auto const writtenSize = static_cast<std::size_t>( itsStream.rdbuf()->sputn( reinterpret_cast<const char*>( data ), size ) );
 
         if(writtenSize != size)
           throw Exception("Failed to write " + std::to_string(size) + " bytes to output stream! Wrote " + std::to_string(writtenSize));
       }
 
+      //! The options this archive was constructed with
+      Options options() const
+      {
+        return Options( itsFrameVersionedObjects, itsStrings.maxBytes(), itsQueuePointees );
+      }
+
+      //! Whether the objects of versioned classes are framed
+      /*! @internal */
+      bool framesVersionedObjects() const
+      {
+        return itsFrameVersionedObjects;
+      }
+
+      //! Starts the frame of a versioned object, leaving room for its size
+      /*! @internal */
+      void beginVersionedObject()
+      {
+        itsFrames.begin();
+        itsStringMarks.push_back( itsStrings.size() );
+      }
+
+      //! Writes the size of the current frame, see detail::OutputFrames
+      /*! @internal */
+      void endVersionedObject( bool pinned )
+      {
+        auto const strings = itsStringMarks.back();
+        itsStringMarks.pop_back();
+
+        // Strings interned within a frame are pinned like everything else first saved there,
+        // and forgotten along with it once the outermost frame is finished
+        pinned = pinned || itsStrings.size() != strings;
+        if( itsStringMarks.empty() )
+          itsStrings.forget( strings );
+
+        itsFrames.end( pinned );
+      }
+
+      //! Looks up a string about to be saved in the interning table
+      /*! @internal */
+      size_type internString( const void * data, std::size_t size )
+      {
+        return itsStrings.intern( data, size );
+      }
+
+      //! Whether the targets of shared pointers are queued
+      /*! Targets are never queued within a frame, since they would then be saved after
+          it, where readers that skip the frame would not expect them.
+          @internal */
+      bool queuesPointees() const
+      {
+        return itsQueuePointees && itsFrames.empty();
+      }
+
     private:
       std::ostream & itsStream;
+      bool itsFrameVersionedObjects;           //!< Whether objects of versioned classes are framed
+      detail::OutputFrames itsFrames;          //!< The open frames of versioned objects
+      std::vector<std::size_t> itsStringMarks; //!< How many strings were interned when each open frame started
+      detail::OutputStringTable itsStrings;    //!< The strings written so far, if interning
+      bool itsQueuePointees;                   //!< Whether the targets of shared pointers are queued
   };
 
   // ######################################################################
@@ -83,7 +214,7 @@ namespace cereal
       inadvertently.
 
       \ingroup Archives */
-  class BinaryInputArchive : public InputArchive<BinaryInputArchive, AllowEmptyClassElision>
+  class BinaryInputArchive : public InputArchive<BinaryInputArchive, AllowEmptyClassElision>, public detail::SharedStreamUser
   {
     public:
       //! Construct, loading from the provided stream
@@ -96,13 +227,97 @@ namespace cereal
       void loadBinary( void * const data, std::size_t size )
       {
         auto const readSize = static_cast<std::size_t>( itsStream.rdbuf()->sgetn( reinterpret_cast<char*>( data ), size ) );
+        itsPosition += readSize;
 
         if(readSize != size)
           throw Exception("Failed to read " + std::to_string(size) + " bytes from input stream! Read " + std::to_string(readSize));
       }
 
+      //! Skips size bytes of the input stream by seeking
+      /*! @return false if the stream cannot seek, in which case nothing was skipped
+          @internal */
+      bool skipBinary( std::size_t size )
+      {
+        if( itsStream.rdbuf()->pubseekoff( static_cast<std::streamoff>( size ), std::ios::cur, std::ios::in ) == std::streampos( -1 ) )
+          return false;
+
+        itsPosition += size;
+        return true;
+      }
+
+      //! The stream being read from, for types that skip over data and load it later
+      /*! @internal */
+      std::istream & stream()
+      {
+        return itsStream;
+      }
+
+      //! Reads the size of a framed object and remembers where it ends
+      /*! @internal */
+      void beginVersionedObject()
+      {
+        std::uint64_t size;
+        loadBinary( &size, sizeof(size) );
+        itsFrameEnds.push_back( ( itsPosition + ( size & ~detail::frame_pinned_flag ) ) | ( size & detail::frame_pinned_flag ) );
+        itsStringMarks.push_back( itsStrings.size() );
+      }
+
+      //! Skips whatever remains of the current framed object
+      /*! @throw Exception if the object is nested in another framed object and holds the
+                           first copy of something that may be referred to later, see
+                           detail::frame_pinned_flag
+          @internal */
+      void endVersionedObject()
+      {
+        auto const end = itsFrameEnds.back() & ~detail::frame_pinned_flag;
+        bool const pinned = ( itsFrameEnds.back() & detail::frame_pinned_flag ) != 0;
+        itsFrameEnds.pop_back();
+
+        if( itsFrameEnds.empty() ) // mirrors the output archive
+          itsStrings.forget( itsStringMarks.front() );
+        itsStringMarks.pop_back();
+
+        if( itsPosition > end )
+          throw Exception("Read " + std::to_string(itsPosition - end) + " bytes past the end of a framed object");
+
+        auto remaining = static_cast<std::size_t>( end - itsPosition );
+        if( remaining == 0 )
+          return;
+
+        if( pinned )
+          throw Exception("Cannot skip the rest of a nested framed object holding the first copy of a pointer, polymorphic type, class version or string");
+
+        if( skipBinary( remaining ) )
+          return;
+
+        char discarded[4096];
+        for( std::size_t chunk; remaining; remaining -= chunk )
+        {
+          chunk = std::min( remaining, sizeof(discarded) );
+          loadBinary( discarded, chunk );
+        }
+      }
+
+      //! Remembers a loaded string that later copies of it refer to
+      /*! @internal */
+      void internString( const void * data, std::size_t size )
+      {
+        itsStrings.intern( data, size );
+      }
+
+      //! The bytes of an earlier string that a copy refers to
+      /*! @internal */
+      std::string const & internedString( size_type id ) const
+      {
+        return itsStrings.find( id );
+      }
+
     private:
       std::istream & itsStream;
+      std::uint64_t itsPosition = 0;          //!< The number of bytes read or skipped so far
+      std::vector<std::uint64_t> itsFrameEnds; //!< Where each open frame ends, and detail::frame_pinned_flag if pinned
+      std::vector<std::size_t> itsStringMarks; //!< How many strings were interned when each open frame started
+      detail::InputStringTable itsStrings;     //!< The loaded strings that copies refer to
   };
 
   // ######################################################################
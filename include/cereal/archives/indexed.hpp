@@ -0,0 +1,343 @@
+/*! \file indexed.hpp
+    \brief Indexed binary archives with random access to their entries */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_ARCHIVES_INDEXED_HPP_
+#define CEREAL_ARCHIVES_INDEXED_HPP_
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/details/buffers.hpp>
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace cereal
+{
+  namespace indexed_detail
+  {
+    //! Marks the end of an indexed archive
+    inline char const * magic()
+    { return "CEREALIX"; }
+
+    //! The size of the trailer: the offset and length of the table of contents, then the magic
+    static const std::size_t trailerSize = 2 * sizeof(std::uint64_t) + 8;
+
+    //! Writes size bytes to a buffer, throwing if not everything is written
+    inline void write_bytes( std::streambuf & buffer, char const * data, std::size_t size )
+    {
+      auto const writtenSize = static_cast<std::size_t>( buffer.sputn( data, static_cast<std::streamsize>( size ) ) );
+
+      if(writtenSize != size)
+        throw Exception("Failed to write " + std::to_string(size) + " bytes to output stream! Wrote " + std::to_string(writtenSize));
+    }
+
+    //! Writes a value as little endian bytes
+    inline void write_uint64( std::streambuf & buffer, std::uint64_t value )
+    {
+      char bytes[sizeof(value)];
+      for( std::size_t i = 0; i < sizeof(value); ++i )
+        bytes[i] = static_cast<char>( ( value >> ( 8 * i ) ) & 0xff );
+      write_bytes( buffer, bytes, sizeof(bytes) );
+    }
+
+    //! Reads a value from little endian bytes
+    inline std::uint64_t read_uint64( char const * bytes )
+    {
+      std::uint64_t value = 0;
+      for( std::size_t i = 0; i < sizeof(value); ++i )
+        value |= static_cast<std::uint64_t>( static_cast<unsigned char>( bytes[i] ) ) << ( 8 * i );
+      return value;
+    }
+  } // namespace indexed_detail
+
+  // ######################################################################
+  //! An entry in the table of contents of an indexed archive
+  struct IndexedEntry
+  {
+    std::string name;     //!< The name of the entry, empty if it was added without one
+    std::uint64_t offset; //!< Where the entry starts, relative to the start of the indexed archive
+    std::uint64_t length; //!< The number of bytes in the entry
+
+    template <class Archive>
+    void serialize( Archive & ar )
+    {
+      ar( CEREAL_NVP(name), CEREAL_NVP(offset), CEREAL_NVP(length) );
+    }
+  };
+
+  // ######################################################################
+  //! An output archive that writes independent entries followed by a table of contents
+  /*! Each entry is written by a new archive of type ArchiveType, so it shares no pointers,
+      polymorphic type names or class versions with other entries and can be loaded on its
+      own.  Entries are numbered in the order they are added and may also be named.  A table
+      of contents holding the offset and length of each entry is written by finish or on
+      destruction, followed by a fixed size trailer locating it.
+
+      The output stream does not need to be seekable.
+
+      @code{.cpp}
+      std::ofstream os( "snapshot.bin", std::ios::binary );
+      cereal::IndexedOutputArchive<> ar( os );
+      ar.add( "config", config );
+      ar.add( "users", users );
+      for( auto & shard : shards )
+        ar( shard ); // numbered entries
+      @endcode
+
+      @tparam ArchiveType The archive used for entries and the table of contents, such as
+                          BinaryOutputArchive or PortableBinaryOutputArchive
+      \ingroup Archives */
+  template <class ArchiveType = BinaryOutputArchive>
+  class IndexedOutputArchive
+  {
+    public:
+      //! Construct, outputting to the provided stream
+      IndexedOutputArchive( std::ostream & stream ) :
+        itsBuffer( stream.rdbuf() ),
+        itsStream( &itsBuffer ),
+        itsFinished( false )
+      { }
+
+      //! Writes the table of contents if finish was not called
+      ~IndexedOutputArchive()
+      {
+        try
+        {
+          finish();
+        }
+        catch( ... )
+        { }
+      }
+
+      IndexedOutputArchive( IndexedOutputArchive const & ) = delete;
+      IndexedOutputArchive & operator=( IndexedOutputArchive const & ) = delete;
+
+      //! Writes an unnamed entry holding all of the passed in data
+      template <class ... Types> inline
+      IndexedOutputArchive & operator()( Types && ... args )
+      {
+        write( std::string(), std::forward<Types>( args )... );
+        return *this;
+      }
+
+      //! Writes a named entry holding all of the passed in data
+      /*! Names must be unique and not empty */
+      template <class ... Types> inline
+      IndexedOutputArchive & add( std::string const & name, Types && ... args )
+      {
+        if( name.empty() )
+          throw Exception("Indexed archive entry names cannot be empty");
+        if( !itsNames.insert( name ).second )
+          throw Exception("Duplicate indexed archive entry name: " + name);
+
+        write( name, std::forward<Types>( args )... );
+        return *this;
+      }
+
+      //! The entries written so far
+      std::vector<IndexedEntry> const & entries() const
+      { return itsEntries; }
+
+      //! Writes the table of contents and trailer, after which no more entries can be written
+      /*! This is called on destruction if it was not called before, where errors are ignored.
+          @throws Exception if the stream does not accept the whole table of contents or trailer */
+      void finish()
+      {
+        if( itsFinished )
+          return;
+        itsFinished = true;
+
+        auto const tocOffset = itsBuffer.count();
+        {
+          ArchiveType ar( itsStream );
+          ar( make_size_tag( static_cast<size_type>( itsEntries.size() ) ) );
+          for( auto const & entry : itsEntries )
+            ar( entry );
+        }
+        auto const tocLength = itsBuffer.count() - tocOffset;
+
+        indexed_detail::write_uint64( itsBuffer, tocOffset );
+        indexed_detail::write_uint64( itsBuffer, tocLength );
+        indexed_detail::write_bytes( itsBuffer, indexed_detail::magic(), 8 );
+        itsBuffer.pubsync();
+      }
+
+    private:
+      template <class ... Types> inline
+      void write( std::string const & name, Types && ... args )
+      {
+        if( itsFinished )
+          throw Exception("Cannot add entries to a finished indexed archive");
+
+        IndexedEntry entry;
+        entry.name = name;
+        entry.offset = itsBuffer.count();
+        {
+          ArchiveType ar( itsStream );
+          ar( std::forward<Types>( args )... );
+        }
+        entry.length = itsBuffer.count() - entry.offset;
+        itsEntries.push_back( std::move( entry ) );
+      }
+
+      detail::CountingBuffer itsBuffer; //!< Counts the offset of each entry
+      std::ostream itsStream;           //!< Writes to itsBuffer
+      std::vector<IndexedEntry> itsEntries;
+      std::unordered_set<std::string> itsNames;
+      bool itsFinished;
+  };
+
+  // ######################################################################
+  //! An input archive that loads single entries of an indexed archive without reading the others
+  /*! The table of contents is read on construction, after which entries can be listed and
+      loaded in any order, any number of times.  Loading an entry seeks directly to it and
+      only reads its own bytes.
+
+      The stream must be seekable and the indexed archive must end the stream.
+
+      @code{.cpp}
+      std::ifstream is( "snapshot.bin", std::ios::binary );
+      cereal::IndexedInputArchive<> ar( is );
+      for( auto const & entry : ar.entries() )
+        std::cout << entry.name << ": " << entry.length << " bytes\n";
+      ar.load( "users", users );
+      ar.load( 3, shard );
+      @endcode
+
+      @tparam ArchiveType The archive matching the IndexedOutputArchive that wrote the data
+      \ingroup Archives */
+  template <class ArchiveType = BinaryInputArchive>
+  class IndexedInputArchive
+  {
+    public:
+      //! Construct, reading the table of contents from the provided stream
+      IndexedInputArchive( std::istream & stream ) :
+        itsSource( stream.rdbuf() )
+      {
+        auto const end = itsSource->pubseekoff( 0, std::ios::end, std::ios::in );
+        if( end == std::streampos( -1 ) || static_cast<std::uint64_t>( std::streamoff( end ) ) < indexed_detail::trailerSize )
+          throw Exception("Indexed archive stream is not seekable or too short");
+
+        auto const trailerPosition = static_cast<std::uint64_t>( std::streamoff( end ) ) - indexed_detail::trailerSize;
+        char trailer[indexed_detail::trailerSize];
+        seek( trailerPosition );
+        if( itsSource->sgetn( trailer, sizeof(trailer) ) != static_cast<std::streamsize>( sizeof(trailer) ) ||
+            std::memcmp( trailer + 16, indexed_detail::magic(), 8 ) != 0 )
+          throw Exception("Stream does not end with an indexed archive");
+
+        auto const tocOffset = indexed_detail::read_uint64( trailer );
+        auto const tocLength = indexed_detail::read_uint64( trailer + 8 );
+        if( tocOffset + tocLength > trailerPosition )
+          throw Exception("Invalid indexed archive trailer");
+
+        itsBase = trailerPosition - tocLength - tocOffset;
+
+        read( tocOffset, tocLength, [this, tocOffset]( ArchiveType & ar )
+        {
+          size_type count;
+          ar( make_size_tag( count ) );
+          for( size_type i = 0; i < count; ++i )
+          {
+            IndexedEntry entry;
+            ar( entry );
+            if( entry.offset + entry.length > tocOffset )
+              throw Exception("Invalid indexed archive entry: " + entry.name);
+            itsEntries.push_back( std::move( entry ) );
+          }
+        } );
+      }
+
+      //! The entries in the order they were written
+      std::vector<IndexedEntry> const & entries() const
+      { return itsEntries; }
+
+      //! The number of entries
+      std::size_t size() const
+      { return itsEntries.size(); }
+
+      //! The index of the entry with the given name, or size() if there is none
+      std::size_t find( std::string const & name ) const
+      {
+        for( std::size_t i = 0; i < itsEntries.size(); ++i )
+          if( !name.empty() && itsEntries[i].name == name )
+            return i;
+        return itsEntries.size();
+      }
+
+      //! Loads the passed in data from the entry with the given index
+      template <class ... Types> inline
+      void load( std::size_t index, Types && ... args )
+      {
+        if( index >= itsEntries.size() )
+          throw Exception("Indexed archive entry " + std::to_string( index ) + " does not exist");
+
+        auto const & entry = itsEntries[index];
+        read( entry.offset, entry.length, [&]( ArchiveType & ar ){ ar( std::forward<Types>( args )... ); } );
+      }
+
+      //! Loads the passed in data from the entry with the given name
+      template <class ... Types> inline
+      void load( std::string const & name, Types && ... args )
+      {
+        auto const index = find( name );
+        if( index == itsEntries.size() )
+          throw Exception("Indexed archive entry " + name + " does not exist");
+
+        load( index, std::forward<Types>( args )... );
+      }
+
+    private:
+      //! Seeks the stream to an absolute position
+      void seek( std::uint64_t position )
+      {
+        if( itsSource->pubseekpos( static_cast<std::streamoff>( position ), std::ios::in ) == std::streampos( -1 ) )
+          throw Exception("Failed to seek in indexed archive stream");
+      }
+
+      //! Loads a region of the indexed archive with a new archive, which must not read past the region
+      template <class F> inline
+      void read( std::uint64_t offset, std::uint64_t length, F const & f )
+      {
+        seek( itsBase + offset );
+        detail::RangeBuffer range( itsSource, length );
+        std::istream stream( &range );
+        ArchiveType ar( stream );
+        f( ar );
+      }
+
+      std::streambuf * itsSource;           //!< The stream being read
+      std::uint64_t itsBase;                //!< The stream position of the start of the indexed archive
+      std::vector<IndexedEntry> itsEntries; //!< The table of contents
+  };
+} // namespace cereal
+
+#endif // CEREAL_ARCHIVES_INDEXED_HPP_
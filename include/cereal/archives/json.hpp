@@ -31,6 +31,7 @@
 
 #include <cereal/cereal.hpp>
 #include <cereal/details/util.hpp>
+#include <cereal/details/buffers.hpp>
 
 namespace cereal
 {
@@ -51,15 +52,146 @@ namespace cereal
 #include <cereal/external/rapidjson/reader.h>
 #include <cereal/external/rapidjson/document.h>
 #include <cereal/external/base64.hpp>
+#include <cereal/details/parallel.hpp>
 
 #include <limits>
 #include <sstream>
 #include <stack>
 #include <vector>
 #include <string>
+#include <cstring>
 
 namespace cereal
 {
+  class JSONOutputArchive;
+  class JSONInputArchive;
+  class JSONLinesOutputArchive;
+  class JSONLinesInputArchive;
+
+  // ######################################################################
+  //! Reusable memory for JSON archives
+  /*! Without a context, every JSON archive allocates the stack of its writer or the
+      pool of its document, along with a parser stack, from scratch and frees them again
+      on destruction.  Archives constructed against a JSONContext take all of that memory,
+      plus the buffer the input text is read into, from the context instead.  When the
+      archive is destroyed the memory is cleared but kept, and grown to the high-water mark
+      if the archive needed more, so that serializing a stream of similar messages quickly
+      stops allocating altogether.
+
+      A context can be used by one archive at a time, and must outlive it.
+
+      @code{cpp}
+      cereal::JSONContext context;
+      for( auto & request : requests )
+      {
+        std::istringstream is( request );
+        cereal::JSONInputArchive ar( is, context );
+        ar( message );
+      }
+      @endcode
+
+      \ingroup Archives */
+  class JSONContext
+  {
+    public:
+      //! Construct a context
+      /*! @param capacity The number of bytes initially reserved for the writer stack or document */
+      explicit JSONContext( std::size_t capacity = 64 * 1024 ) :
+        itsPool( capacity < minimumCapacity ? minimumCapacity : capacity ),
+        itsInUse( false )
+      { }
+
+      JSONContext( JSONContext const & ) = delete;
+      JSONContext & operator=( JSONContext const & ) = delete;
+
+      ~JSONContext()
+      {
+        if( itsInUse )
+          allocator()->~Allocator();
+      }
+
+      //! The number of bytes currently reserved for the writer stack or document
+      std::size_t capacity() const { return itsPool.size(); }
+
+    private:
+      friend class JSONOutputArchive;
+      friend class JSONInputArchive;
+
+      typedef rapidjson::MemoryPoolAllocator<> Allocator;
+
+      //! Makes the memory of a context, if any, available for the lifetime of one archive
+      class Lease
+      {
+        public:
+          Lease( JSONContext * context ) : itsContext( context )
+          {
+            if( itsContext )
+              itsContext->acquire();
+          }
+
+          ~Lease()
+          {
+            if( itsContext )
+              itsContext->release();
+          }
+
+          //! The allocator to construct rapidjson objects with, or nullptr to let them allocate their own
+          Allocator * allocator() const { return itsContext ? itsContext->allocator() : nullptr; }
+
+          JSONContext * context() const { return itsContext; }
+
+        private:
+          JSONContext * itsContext;
+      };
+
+      Allocator * allocator()
+      {
+        return reinterpret_cast<Allocator *>( &itsAllocator );
+      }
+
+      //! Starts handing out memory from the pool
+      void acquire()
+      {
+        if( itsInUse )
+          throw Exception("A JSONContext can only be used by one archive at a time");
+
+        new (&itsAllocator) Allocator( itsPool.data(), itsPool.size(), chunkCapacity, &itsBaseAllocator );
+        itsInUse = true;
+      }
+
+      //! Clears the pool, growing it if the last archive overflowed it
+      void release()
+      {
+        // The allocator reports the capacity of every chunk it used, including the pool itself
+        auto const needed = allocator()->Capacity() + headerSize;
+        allocator()->~Allocator();
+        itsInUse = false;
+
+        if( needed > itsPool.size() )
+          std::vector<char>( needed ).swap( itsPool );
+      }
+
+      //! Reads the entire remaining contents of a stream into the parse buffer
+      /*! @return The null terminated text, which may be modified in place */
+      char * read( std::istream & stream )
+      {
+        return detail::read_stream( stream, itsText );
+      }
+
+      //! Bytes the allocator uses to track a chunk
+      static const std::size_t headerSize = 3 * sizeof(void *);
+      //! Smallest useful pool
+      static const std::size_t minimumCapacity = 1024;
+      //! Size of chunks allocated once the pool is exhausted
+      static const std::size_t chunkCapacity = 64 * 1024;
+
+      std::vector<char> itsPool;                 //!< Memory for the writer stack or document
+      std::vector<char> itsText;                 //!< Buffer the input text is read into
+      rapidjson::CrtAllocator itsBaseAllocator;  //!< Allocates chunks beyond the pool
+      typename std::aligned_storage<sizeof(Allocator), alignof(Allocator)>::type itsAllocator; //!< Pool allocator of the current archive
+      bool itsInUse;                             //!< Whether an archive is using the context
+  };
+
   // ######################################################################
   //! An output archive designed to save data to JSON
   /*! This archive uses RapidJSON to build serialie data to JSON.
@@ -72,10 +204,11 @@ namespace cereal
       of the output will be given an automatically generated delimited name.
 
       The precision of the output archive controls the number of decimals output
-      for floating point numbers and should be sufficiently large (i.e. at least 20)
-      if there is a desire to have binary equality between the numbers output and
-      those read in.  In general you should expect a loss of precision when going
-      from floating point to text and back.
+      for floating point numbers.  At the default precision (max_digits10 for double)
+      or above, floats and doubles are written using the shortest representation that
+      reads back to exactly the same value, so there is no loss of precision when going
+      from floating point to text and back.  Lower precisions trade exactness for
+      fewer digits.
 
       JSON archives do not output the size information for any dynamically sized structure
       and instead infer it from the number of children for a node.  This means that data
@@ -85,7 +218,7 @@ namespace cereal
       that the container is variable sized and may be edited.
 
       \ingroup Archives */
-  class JSONOutputArchive : public OutputArchive<JSONOutputArchive>, public traits::TextArchive
+  class JSONOutputArchive : public OutputArchive<JSONOutputArchive>, public traits::TextArchive, public detail::ThreadPoolUser
   {
     enum class NodeType { StartObject, InObject, StartArray, InArray };
 
@@ -120,19 +253,26 @@ namespace cereal
           /*! @param precision The precision used for floating point numbers
               @param indentChar The type of character to indent with
               @param indentLength The number of indentChar to use for indentation
-                             (0 corresponds to no indentation) */
+                             (0 corresponds to no indentation)
+              @param compactArithmetic Whether std::vectors of arithmetic types (other than bool)
+                                       are saved as a single base64 encoded block of their
+                                       little endian bytes instead of one value per element.
+                                       Loading detects either form automatically. */
           explicit Options( int precision = std::numeric_limits<double>::max_digits10,
                             IndentChar indentChar = IndentChar::space,
-                            unsigned int indentLength = 4 ) :
+                            unsigned int indentLength = 4,
+                            bool compactArithmetic = false ) :
             itsPrecision( precision ),
             itsIndentChar( static_cast<char>(indentChar) ),
-            itsIndentLength( indentLength ) { }
+            itsIndentLength( indentLength ),
+            itsCompactArithmetic( compactArithmetic ) { }
 
         private:
           friend class JSONOutputArchive;
           int itsPrecision;
           char itsIndentChar;
           unsigned int itsIndentLength;
+          bool itsCompactArithmetic;
       };
 
       //! Construct, outputting to the provided stream
@@ -140,23 +280,59 @@ namespace cereal
           @param options The JSON specific options to use.  See the Options struct
                          for the values of default parameters */
       JSONOutputArchive(std::ostream & stream, Options const & options = Options::Default() ) :
+        JSONOutputArchive(stream, nullptr, options)
+      { }
+
+      //! Construct, outputting to the provided stream and taking working memory from a context
+      /*! @param stream The stream to output to.
+          @param context The context to take memory from.  It must outlive the archive.
+          @param options The JSON specific options to use.  See the Options struct
+                         for the values of default parameters */
+      JSONOutputArchive(std::ostream & stream, JSONContext & context, Options const & options = Options::Default() ) :
+        JSONOutputArchive(stream, &context, options)
+      { }
+
+      //! Destructor, flushes the JSON
+      ~JSONOutputArchive()
+      {
+        if (itsNodeStack.top() == NodeType::InObject)
+          itsWriter.EndObject();
+      }
+
+    private:
+      friend class JSONLinesOutputArchive;
+
+      //! @param singleLine Whether to write everything on one line, ignoring the indentation options
+      JSONOutputArchive(std::ostream & stream, JSONContext * context, Options const & options, bool singleLine = false) :
         OutputArchive<JSONOutputArchive>(this),
+        itsLease(context),
         itsWriteStream(stream),
-        itsWriter(itsWriteStream, options.itsPrecision),
-        itsNextName(nullptr)
+        itsWriter(itsWriteStream, options.itsPrecision, itsLease.allocator()),
+        itsNextName(nullptr),
+        itsCompactArithmetic(options.itsCompactArithmetic)
       {
         itsWriter.SetIndent( options.itsIndentChar, options.itsIndentLength );
+        itsWriter.SetSingleLine( singleLine );
         itsNameCounter.push(0);
         itsNodeStack.push(NodeType::StartObject);
       }
 
-      //! Destructor, flushes the JSON
-      ~JSONOutputArchive()
+      //! Ends the root object, followed by a line break, so that what follows starts a new, independent one
+      /*! An empty root object is written if nothing was saved since the last call */
+      void finishRecord()
       {
-        if (itsNodeStack.top() == NodeType::InObject)
-          itsWriter.EndObject();
+        if (itsNodeStack.top() != NodeType::InObject)
+          itsWriter.StartObject();
+        itsWriter.EndObject();
+        itsWriteStream.Put('\n');
+
+        itsNodeStack.top() = NodeType::StartObject;
+        itsNameCounter.top() = 0;
+        resetTracking();
       }
 
+    public:
+
       //! Saves some binary data, encoded as a base64 string, with an optional name
       /*! This will create a new node, optionally named, and insert a value that consists of
           the data encoded as a base64 string */
@@ -165,7 +341,7 @@ namespace cereal
         setNextName( name );
         writeName();
 
-        auto base64string = base64::encode( reinterpret_cast<const unsigned char *>( data ), size );
+        auto base64string = parallel_detail::encode_base64( itsPool, itsChunkSize, reinterpret_cast<const unsigned char *>( data ), size );
         saveValue( base64string );
       };
 
@@ -175,6 +351,34 @@ namespace cereal
           the JSONOutputArchive */
       //! @{
 
+      //! Saves an array of arithmetic values as a compact block into the current node, if enabled
+      /*! The node becomes an object holding the encoding and the base64 encoded little endian
+          bytes of the values.
+          @return false, without saving anything, if compact blocks are disabled in the Options */
+      template <class T> inline
+      bool saveArithmeticBlock( T const * data, size_t count )
+      {
+        static_assert( std::is_arithmetic<T>::value, "Only arithmetic types can be saved as a block" );
+
+        if( !itsCompactArithmetic )
+          return false;
+
+        setNextName( "encoding" );
+        writeName();
+        saveValue( "base64" );
+
+        if( detail::is_little_endian() || sizeof(T) == 1 )
+          saveBinaryValue( data, count * sizeof(T), "data" );
+        else
+        {
+          std::vector<T> swapped( data, data + count );
+          detail::swap_bytes( swapped.data(), sizeof(T), count );
+          saveBinaryValue( swapped.data(), count * sizeof(T), "data" );
+        }
+
+        return true;
+      }
+
       //! Starts a new node in the JSON output
       /*! The node can optionally be given a name by calling setNextName prior
           to creating the node
@@ -182,6 +386,11 @@ namespace cereal
           Nodes only need to be started for types that are themselves objects or arrays */
       void startNode()
       {
+        #ifdef CEREAL_ENABLE_TRACING
+        if( tracer() )
+          tracer()->beginNode( itsNextName );
+        #endif // CEREAL_ENABLE_TRACING
+
         writeName();
         itsNodeStack.push(NodeType::StartObject);
         itsNameCounter.push(0);
@@ -211,6 +420,11 @@ namespace cereal
 
         itsNodeStack.pop();
         itsNameCounter.pop();
+
+        #ifdef CEREAL_ENABLE_TRACING
+        if( tracer() )
+          tracer()->endNode();
+        #endif // CEREAL_ENABLE_TRACING
       }
 
       //! Sets the name for the next node created with startNode
@@ -229,10 +443,13 @@ namespace cereal
       void saveValue(int64_t i64)           { itsWriter.Int64(i64);                                                      }
       //! Saves a uint64 to the current node
       void saveValue(uint64_t u64)          { itsWriter.Uint64(u64);                                                     }
+      //! Saves a float to the current node
+      void saveValue(float f)               { itsWriter.Float(f);                                                        }
       //! Saves a double to the current node
       void saveValue(double d)              { itsWriter.Double(d);                                                       }
       //! Saves a string to the current node
-      void saveValue(std::string const & s) { itsWriter.String(s.c_str(), static_cast<rapidjson::SizeType>( s.size() )); }
+      template <class Traits, class Alloc>
+      void saveValue(std::basic_string<char, Traits, Alloc> const & s) { itsWriter.String(s.c_str(), static_cast<rapidjson::SizeType>( s.size() )); }
       //! Saves a const char * to the current node
       void saveValue(char const * s)        { itsWriter.String(s);                                                       }
 
@@ -346,11 +563,13 @@ namespace cereal
       //! @}
 
     private:
+      JSONContext::Lease itsLease;         //!< Memory from the context, if any; must precede the writer
       WriteStream itsWriteStream;          //!< Rapidjson write stream
       JSONWriter itsWriter;                //!< Rapidjson writer
       char const * itsNextName;            //!< The next name
       std::stack<uint32_t> itsNameCounter; //!< Counter for creating unique names for unnamed nodes
       std::stack<NodeType> itsNodeStack;
+      bool itsCompactArithmetic;           //!< Whether arithmetic vectors are saved as compact blocks
   }; // JSONOutputArchive
 
   // ######################################################################
@@ -388,7 +607,7 @@ namespace cereal
       @endcode
 
       \ingroup Archives */
-  class JSONInputArchive : public InputArchive<JSONInputArchive>, public traits::TextArchive
+  class JSONInputArchive : public InputArchive<JSONInputArchive>, public traits::TextArchive, public detail::ThreadPoolUser
   {
     private:
       typedef rapidjson::GenericReadStream ReadStream;
@@ -406,6 +625,7 @@ namespace cereal
       /*! @param stream The stream to read from */
       JSONInputArchive(std::istream & stream) :
         InputArchive<JSONInputArchive>(this),
+        itsLease( nullptr ),
         itsNextName( nullptr ),
         itsReadStream(stream)
       {
@@ -413,6 +633,40 @@ namespace cereal
         itsIteratorStack.emplace_back(itsDocument.MemberBegin(), itsDocument.MemberEnd());
       }
 
+      //! Construct, reading from the provided stream and taking working memory from a context
+      /*! The remainder of the stream is read into the buffer of the context at once and
+          parsed in place, so strings in the document are not copied.
+
+          @param stream The stream to read from
+          @param context The context to take memory from.  It must outlive the archive. */
+      JSONInputArchive(std::istream & stream, JSONContext & context) :
+        InputArchive<JSONInputArchive>(this),
+        itsLease( &context ),
+        itsNextName( nullptr ),
+        itsReadStream(stream),
+        itsDocument( itsLease.allocator() )
+      {
+        itsDocument.ParseInsitu<0>( context.read( stream ) );
+        itsIteratorStack.emplace_back(itsDocument.MemberBegin(), itsDocument.MemberEnd());
+      }
+
+    private:
+      friend class JSONLinesInputArchive;
+
+      //! Construct, parsing text that was already read from the stream in place
+      JSONInputArchive(std::istream & stream, char * text, JSONContext & context) :
+        InputArchive<JSONInputArchive>(this),
+        itsLease( &context ),
+        itsNextName( nullptr ),
+        itsReadStream(stream),
+        itsDocument( itsLease.allocator() )
+      {
+        itsDocument.ParseInsitu<0>( text );
+        itsIteratorStack.emplace_back(itsDocument.MemberBegin(), itsDocument.MemberEnd());
+      }
+
+    public:
+
       //! Loads some binary data, encoded as a base64 string
       /*! This will automatically start and finish a node to load the data, and can be called directly by
           users.
@@ -422,16 +676,17 @@ namespace cereal
       void loadBinaryValue( void * data, size_t size, const char * name = nullptr )
       {
         itsNextName = name;
+        search();
 
-        std::string encoded;
-        loadValue( encoded );
-        auto decoded = base64::decode( encoded );
+        // Decode straight from the document into the destination
+        auto const & value = itsIteratorStack.back().value();
+        auto const encoded = value.GetString();
+        auto const length = value.GetStringLength();
 
-        if( size != decoded.size() )
+        if( !parallel_detail::decode_base64( itsPool, itsChunkSize, encoded, length, static_cast<unsigned char *>( data ), size ) )
           throw Exception("Decoded binary data size does not match specified size");
 
-        std::memcpy( data, decoded.data(), decoded.size() );
-        itsNextName = nullptr;
+        ++itsIteratorStack.back();
       };
 
     private:
@@ -549,8 +804,17 @@ namespace cereal
           that would normally be loaded.  This functionality is provided by search(). */
       void startNode()
       {
+        #ifdef CEREAL_ENABLE_TRACING
+        auto const name = itsNextName; // search() consumes the name
+        #endif // CEREAL_ENABLE_TRACING
+
         search();
 
+        #ifdef CEREAL_ENABLE_TRACING
+        if( tracer() )
+          tracer()->beginNode( name );
+        #endif // CEREAL_ENABLE_TRACING
+
         if(itsIteratorStack.back().value().IsArray())
           itsIteratorStack.emplace_back(itsIteratorStack.back().value().Begin(), itsIteratorStack.back().value().End());
         else
@@ -562,6 +826,11 @@ namespace cereal
       {
         itsIteratorStack.pop_back();
         ++itsIteratorStack.back();
+
+        #ifdef CEREAL_ENABLE_TRACING
+        if( tracer() )
+          tracer()->endNode();
+        #endif // CEREAL_ENABLE_TRACING
       }
 
       //! Retrieves the current node name
@@ -611,7 +880,8 @@ namespace cereal
       //! Loads a value from the current node - double overload
       void loadValue(double & val)      { search(); val = itsIteratorStack.back().value().GetDouble(); ++itsIteratorStack.back(); }
       //! Loads a value from the current node - string overload
-      void loadValue(std::string & val) { search(); val = itsIteratorStack.back().value().GetString(); ++itsIteratorStack.back(); }
+      template <class Traits, class Alloc>
+      void loadValue(std::basic_string<char, Traits, Alloc> & val) { search(); val = itsIteratorStack.back().value().GetString(); ++itsIteratorStack.back(); }
 
       // Special cases to handle various flavors of long, which tend to conflict with
       // the int32_t or int64_t on various compiler/OS combinations.  MSVC doesn't need any of this.
@@ -682,9 +952,48 @@ namespace cereal
         size = (itsIteratorStack.rbegin() + 1)->value().Size();
       }
 
+      //! Loads a vector of arithmetic values if the current node holds them as a compact block
+      /*! See JSONOutputArchive::saveArithmeticBlock
+          @return false, without loading anything, if the node holds its values individually */
+      template <class T, class A> inline
+      bool loadArithmeticBlock( std::vector<T, A> & vector )
+      {
+        auto const name = itsIteratorStack.back().name();
+        if( !name || std::strcmp( name, "encoding" ) != 0 )
+          return false;
+
+        std::string encoding;
+        loadValue( encoding );
+        if( encoding != "base64" )
+          throw Exception("Unknown encoding for a block of arithmetic values: " + encoding);
+
+        setNextName( "data" );
+        search();
+
+        auto const & value = itsIteratorStack.back().value();
+        auto const encoded = value.GetString();
+        auto const length = value.GetStringLength();
+
+        auto const size = base64::decoded_size( encoded, length );
+        if( size % sizeof(T) != 0 )
+          throw Exception("Decoded block size is not a multiple of the value size");
+
+        vector.resize( size / sizeof(T) );
+        if( !parallel_detail::decode_base64( itsPool, itsChunkSize, encoded, length, reinterpret_cast<unsigned char *>( vector.data() ), size ) )
+          throw Exception("Invalid base64 data in a block of arithmetic values");
+
+        ++itsIteratorStack.back();
+
+        if( !detail::is_little_endian() )
+          detail::swap_bytes( vector.data(), sizeof(T), vector.size() );
+
+        return true;
+      }
+
       //! @}
 
     private:
+      JSONContext::Lease itsLease;            //!< Memory from the context, if any; must precede the document
       const char * itsNextName;               //!< Next name set by NVP
       ReadStream itsReadStream;               //!< Rapidjson write stream
       std::vector<Iterator> itsIteratorStack; //!< 'Stack' of rapidJSON iterators
@@ -883,6 +1192,7 @@ namespace cereal
   template<class CharT, class Traits, class Alloc> inline
   void CEREAL_LOAD_FUNCTION_NAME(JSONInputArchive & ar, std::basic_string<CharT, Traits, Alloc> & str)
   {
+    detail::adopt_memory_resource( ar, str );
     ar.loadValue( str );
   }
 
@@ -0,0 +1,152 @@
+/*! \file json_lines.hpp
+    \brief JSON Lines input and output archives */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_ARCHIVES_JSON_LINES_HPP_
+#define CEREAL_ARCHIVES_JSON_LINES_HPP_
+
+#include <cereal/archives/json.hpp>
+
+#include <string>
+
+namespace cereal
+{
+  // ######################################################################
+  //! An output archive that writes a stream of independent JSON records, one per line
+  /*! Each call writes one record: a JSON object holding everything passed to the call,
+      named exactly as a JSONOutputArchive would name it, on a line of its own.  Records
+      do not share pointers, polymorphic type names or class versions, so each one can
+      be loaded on its own by a JSONLinesInputArchive or any JSON parser.
+
+      Unlike creating a JSONOutputArchive per record, a single writer is reused for the
+      whole stream, and each record is written to the stream as soon as it is complete.
+
+      @code{cpp}
+      std::ofstream os( "audit.jsonl" );
+      cereal::JSONLinesOutputArchive ar( os );
+      for( auto & event : events )
+        ar( cereal::make_nvp( "event", event ) ); // {"event":{...}}
+      @endcode
+
+      \ingroup Archives */
+  class JSONLinesOutputArchive
+  {
+    public:
+      //! Construct, outputting to the provided stream
+      /*! @param stream The stream to output to.
+          @param options The JSON specific options to use.  Indentation options are ignored,
+                         as records are always written on a single line. */
+      JSONLinesOutputArchive( std::ostream & stream,
+                              JSONOutputArchive::Options const & options = JSONOutputArchive::Options::Default() ) :
+        itsArchive( stream, nullptr, options, true )
+      { }
+
+      //! Writes one record containing all of the passed in data
+      /*! If serialization throws, the record is left incomplete and the archive
+          cannot be used further */
+      template <class ... Types> inline
+      JSONLinesOutputArchive & operator()( Types && ... args )
+      {
+        itsArchive( std::forward<Types>( args )... );
+        itsArchive.finishRecord();
+        return *this;
+      }
+
+      //! Writes an empty record
+      JSONLinesOutputArchive & operator()()
+      {
+        itsArchive.finishRecord();
+        return *this;
+      }
+
+    private:
+      JSONOutputArchive itsArchive; //!< Writes the records, reset after each one
+  };
+
+  // ######################################################################
+  //! An input archive that reads a stream of JSON records, one per line
+  /*! Each call reads the next non-empty line and loads the passed in data from
+      it, as a JSONInputArchive would from a document holding just that line.  Only
+      one line is held in memory at a time, and the line buffer and the memory for
+      its document are reused from record to record.
+
+      @code{cpp}
+      std::ifstream is( "audit.jsonl" );
+      cereal::JSONLinesInputArchive ar( is );
+      Event event;
+      while( ar( cereal::make_nvp( "event", event ) ) )
+        process( event );
+      @endcode
+
+      \ingroup Archives */
+  class JSONLinesInputArchive
+  {
+    public:
+      //! Construct, reading from the provided stream
+      /*! @param stream The stream to read from */
+      JSONLinesInputArchive( std::istream & stream ) :
+        itsStream( stream )
+      { }
+
+      //! Loads the passed in data from the next record
+      /*! @return false, without loading anything, if there are no more records */
+      template <class ... Types> inline
+      bool operator()( Types && ... args )
+      {
+        if( !nextLine() )
+          return false;
+
+        JSONInputArchive ar( itsStream, &itsLine[0], itsContext );
+        ar( std::forward<Types>( args )... );
+        return true;
+      }
+
+      //! Skips the next record
+      /*! @return false if there are no more records */
+      bool operator()()
+      {
+        return nextLine();
+      }
+
+    private:
+      //! Reads the next line holding anything besides whitespace
+      bool nextLine()
+      {
+        while( std::getline( itsStream, itsLine ) )
+          if( itsLine.find_first_not_of( " \t\r" ) != std::string::npos )
+            return true;
+
+        return false;
+      }
+
+      std::istream & itsStream; //!< The stream records are read from
+      std::string itsLine;      //!< The current record, parsed in place
+      JSONContext itsContext;   //!< Memory for the document of each record
+  };
+} // namespace cereal
+
+#endif // CEREAL_ARCHIVES_JSON_LINES_HPP_
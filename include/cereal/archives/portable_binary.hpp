@@ -30,30 +30,32 @@
 #define CEREAL_ARCHIVES_PORTABLE_BINARY_HPP_
 
 #include <cereal/cereal.hpp>
+#include <cereal/details/interning.hpp>
+#include <cereal/details/frames.hpp>
+#include <cereal/details/buffers.hpp>
+#include <cereal/details/parallel.hpp>
 #include <sstream>
 #include <limits>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 namespace cereal
 {
   namespace portable_binary_detail
   {
-    //! Returns true if the current machine is little endian
+    //! Returns true if the current machine is little endian, see detail::is_little_endian
     /*! @ingroup Internal */
-    inline bool is_little_endian()
-    {
-      static std::int32_t test = 1;
-      return *reinterpret_cast<std::int8_t*>( &test ) == 1;
-    }
+    using detail::is_little_endian;
 
-    //! Swaps the order of bytes for some chunk of memory
+    //! Swaps the order of bytes for some chunk of memory, see detail::swap_bytes
     /*! @param data The data as a uint8_t pointer
         @tparam DataSize The true size of the data
         @ingroup Internal */
     template <std::size_t DataSize>
     inline void swap_bytes( std::uint8_t * data )
     {
-      for( std::size_t i = 0, end = DataSize / 2; i < end; ++i )
-        std::swap( data[i], data[DataSize - i - 1] );
+      detail::swap_bytes( data, DataSize, 1 );
     }
   } // end namespace portable_binary_detail
 
@@ -78,12 +80,55 @@ namespace cereal
   class PortableBinaryOutputArchive : public OutputArchive<PortableBinaryOutputArchive, AllowEmptyClassElision>
   {
     public:
+      //! A class containing various advanced options for the portable binary output archive
+      class Options
+      {
+        public:
+          //! Default options, nothing is framed
+          static Options Default(){ return Options(); }
+
+          //! Options that frame the objects of versioned classes
+          static Options Framed(){ return Options( true ); }
+
+          //! Specify specific options for the PortableBinaryOutputArchive
+          /*! @param frameVersionedObjects Whether each object of a class with a versioned
+                                           serialize or save function is prefixed by its size,
+                                           so that readers can skip whatever they do not load.
+                                           Unless the stream can seek, each outermost framed
+                                           object is held in memory until it is saved.
+                                           See BinaryOutputArchive::Options.
+              @param internStringsUpTo Strings of at most this many bytes are written in full
+                                       only the first time they are seen, and as a reference
+                                       afterwards.  See BinaryOutputArchive::Options.
+              @param queuePointees Whether the target of each shared pointer is written after
+                                   the object holding the first pointer to it, so that long
+                                   chains of pointers are handled without deep recursion.
+                                   See BinaryOutputArchive::Options. */
+          explicit Options( bool frameVersionedObjects = false, std::size_t internStringsUpTo = 0,
+                            bool queuePointees = false ) :
+            itsFrameVersionedObjects( frameVersionedObjects ),
+            itsInternStringsUpTo( internStringsUpTo ),
+            itsQueuePointees( queuePointees ) { }
+
+        private:
+          friend class PortableBinaryOutputArchive;
+          bool itsFrameVersionedObjects;
+          std::size_t itsInternStringsUpTo;
+          bool itsQueuePointees;
+      };
+
       //! Construct, outputting to the provided stream
       /*! @param stream The stream to output to.  Can be a stringstream, a file stream, or
-        even cout! */
-      PortableBinaryOutputArchive(std::ostream & stream) :
+        even cout!
+          @param options The portable binary specific options to use.  See the Options struct
+                         for the values of default parameters */
+      PortableBinaryOutputArchive(std::ostream & stream, Options const & options = Options::Default()) :
         OutputArchive<PortableBinaryOutputArchive, AllowEmptyClassElision>(this),
-        itsStream(stream)
+        itsStream(stream),
+        itsFrameVersionedObjects(options.itsFrameVersionedObjects),
+        itsFrames(stream),
+        itsStrings(options.itsInternStringsUpTo),
+        itsQueuePointees(options.itsQueuePointees)
       {
         this->operator()( portable_binary_detail::is_little_endian() );
       }
@@ -91,14 +136,79 @@ namespace cereal
       //! Writes size bytes of data to the output stream
       void saveBinary( const void * data, std::size_t size )
       {
+        if( itsFrames.buffering() ) // the stream cannot seek to patch in the sizes of frames
+        {
+          itsFrames.append( reinterpret_cast<const char*>( data ), size );
+          return;
+        }
+
         auto const writtenSize = static_cast<std::size_t>( itsStream.rdbuf()->sputn( reinterpret_cast<const char*>( data ), size ) );
 
         if(writtenSize != size)
           throw Exception("Failed to write " + std::to_string(size) + " bytes to output stream! Wrote " + std::to_string(writtenSize));
       }
 
+      //! The options this archive was constructed with
+      Options options() const
+      {
+        return Options( itsFrameVersionedObjects, itsStrings.maxBytes(), itsQueuePointees );
+      }
+
+      //! Whether the objects of versioned classes are framed
+      /*! @internal */
+      bool framesVersionedObjects() const
+      {
+        return itsFrameVersionedObjects;
+      }
+
+      //! Starts the frame of a versioned object, leaving room for its size
+      /*! @internal */
+      void beginVersionedObject()
+      {
+        itsFrames.begin();
+        itsStringMarks.push_back( itsStrings.size() );
+      }
+
+      //! Writes the size of the current frame, see detail::OutputFrames
+      /*! Sizes are written in the endianness of this machine, like everything else.
+          @internal */
+      void endVersionedObject( bool pinned )
+      {
+        auto const strings = itsStringMarks.back();
+        itsStringMarks.pop_back();
+
+        // Strings interned within a frame are pinned like everything else first saved there,
+        // and forgotten along with it once the outermost frame is finished
+        pinned = pinned || itsStrings.size() != strings;
+        if( itsStringMarks.empty() )
+          itsStrings.forget( strings );
+
+        itsFrames.end( pinned );
+      }
+
+      //! Looks up a string about to be saved in the interning table
+      /*! @internal */
+      size_type internString( const void * data, std::size_t size )
+      {
+        return itsStrings.intern( data, size );
+      }
+
+      //! Whether the targets of shared pointers are queued
+      /*! Targets are never queued within a frame, since they would then be saved after
+          it, where readers that skip the frame would not expect them.
+          @internal */
+      bool queuesPointees() const
+      {
+        return itsQueuePointees && itsFrames.empty();
+      }
+
     private:
       std::ostream & itsStream;
+      bool itsFrameVersionedObjects;           //!< Whether objects of versioned classes are framed
+      detail::OutputFrames itsFrames;          //!< The open frames of versioned objects
+      std::vector<std::size_t> itsStringMarks; //!< How many strings were interned when each open frame started
+      detail::OutputStringTable itsStrings;    //!< The strings written so far, if interning
+      bool itsQueuePointees;                   //!< Whether the targets of shared pointers are queued
   };
 
   // ######################################################################
@@ -127,7 +237,8 @@ namespace cereal
                <a href="www.github.com/USCiLab/cereal">the project github</a>.
 
     \ingroup Archives */
-  class PortableBinaryInputArchive : public InputArchive<PortableBinaryInputArchive, AllowEmptyClassElision>
+  class PortableBinaryInputArchive : public InputArchive<PortableBinaryInputArchive, AllowEmptyClassElision>, public detail::ThreadPoolUser,
+                                     public detail::SharedStreamUser
   {
     public:
       //! Construct, loading from the provided stream
@@ -151,6 +262,7 @@ namespace cereal
       {
         // load data
         auto const readSize = static_cast<std::size_t>( itsStream.rdbuf()->sgetn( reinterpret_cast<char*>( data ), size ) );
+        itsPosition += readSize;
 
         if(readSize != size)
           throw Exception("Failed to read " + std::to_string(size) + " bytes from input stream! Read " + std::to_string(readSize));
@@ -159,14 +271,100 @@ namespace cereal
         if( itsConvertEndianness )
         {
           std::uint8_t * ptr = reinterpret_cast<std::uint8_t*>( data );
-          for( std::size_t i = 0; i < size; i += DataSize )
-            portable_binary_detail::swap_bytes<DataSize>( ptr );
+          std::size_t const chunkSize = std::max<std::size_t>( itsChunkSize / DataSize, 1 ) * DataSize;
+          parallel_detail::for_each_chunk( itsPool, size, chunkSize, [ptr]( std::size_t begin, std::size_t end )
+          {
+            detail::swap_bytes( ptr + begin, DataSize, ( end - begin ) / DataSize );
+          } );
         }
       }
 
+      //! Skips size bytes of the input stream by seeking
+      /*! @return false if the stream cannot seek, in which case nothing was skipped
+          @internal */
+      bool skipBinary( std::size_t size )
+      {
+        if( itsStream.rdbuf()->pubseekoff( static_cast<std::streamoff>( size ), std::ios::cur, std::ios::in ) == std::streampos( -1 ) )
+          return false;
+
+        itsPosition += size;
+        return true;
+      }
+
+      //! The stream being read from, for types that skip over data and load it later
+      /*! @internal */
+      std::istream & stream()
+      {
+        return itsStream;
+      }
+
+      //! Reads the size of a framed object and remembers where it ends
+      /*! @internal */
+      void beginVersionedObject()
+      {
+        std::uint64_t size;
+        loadBinary<sizeof(size)>( &size, sizeof(size) );
+        itsFrameEnds.push_back( ( itsPosition + ( size & ~detail::frame_pinned_flag ) ) | ( size & detail::frame_pinned_flag ) );
+        itsStringMarks.push_back( itsStrings.size() );
+      }
+
+      //! Skips whatever remains of the current framed object
+      /*! @throw Exception if the object is nested in another framed object and holds the
+                           first copy of something that may be referred to later, see
+                           detail::frame_pinned_flag
+          @internal */
+      void endVersionedObject()
+      {
+        auto const end = itsFrameEnds.back() & ~detail::frame_pinned_flag;
+        bool const pinned = ( itsFrameEnds.back() & detail::frame_pinned_flag ) != 0;
+        itsFrameEnds.pop_back();
+
+        if( itsFrameEnds.empty() ) // mirrors the output archive
+          itsStrings.forget( itsStringMarks.front() );
+        itsStringMarks.pop_back();
+
+        if( itsPosition > end )
+          throw Exception("Read " + std::to_string(itsPosition - end) + " bytes past the end of a framed object");
+
+        auto remaining = static_cast<std::size_t>( end - itsPosition );
+        if( remaining == 0 )
+          return;
+
+        if( pinned )
+          throw Exception("Cannot skip the rest of a nested framed object holding the first copy of a pointer, polymorphic type, class version or string");
+
+        if( skipBinary( remaining ) )
+          return;
+
+        char discarded[4096];
+        for( std::size_t chunk; remaining; remaining -= chunk )
+        {
+          chunk = std::min( remaining, sizeof(discarded) );
+          loadBinary<1>( discarded, chunk );
+        }
+      }
+
+      //! Remembers a loaded string that later copies of it refer to
+      /*! @internal */
+      void internString( const void * data, std::size_t size )
+      {
+        itsStrings.intern( data, size );
+      }
+
+      //! The bytes of an earlier string that a copy refers to
+      /*! @internal */
+      std::string const & internedString( size_type id ) const
+      {
+        return itsStrings.find( id );
+      }
+
     private:
       std::istream & itsStream;
       bool itsConvertEndianness; //!< If set to true, we will need to swap bytes upon loading
+      std::uint64_t itsPosition = 0;          //!< The number of bytes read or skipped so far
+      std::vector<std::uint64_t> itsFrameEnds; //!< Where each open frame ends, and detail::frame_pinned_flag if pinned
+      std::vector<std::size_t> itsStringMarks; //!< How many strings were interned when each open frame started
+      detail::InputStringTable itsStrings;     //!< The loaded strings that copies refer to
   };
 
   // ######################################################################
@@ -0,0 +1,296 @@
+/*! \file sizing.hpp
+    \brief An archive that computes the size of binary output without writing it */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_ARCHIVES_SIZING_HPP_
+#define CEREAL_ARCHIVES_SIZING_HPP_
+
+#include <cereal/cereal.hpp>
+#include <cereal/details/interning.hpp>
+
+#include <array>
+#include <complex>
+#include <tuple>
+#include <utility>
+
+namespace cereal
+{
+  // ######################################################################
+  //! An output archive that counts the bytes a binary archive would write, without writing anything
+  /*! This archive runs the same serialization functions as BinaryOutputArchive and
+      PortableBinaryOutputArchive, including pointer tracking, polymorphic type names and
+      class versions, but only accumulates the number of bytes that would have been written.
+      The result can be used to reserve an output buffer or size a network frame exactly
+      before serializing for real.
+
+      Sizes are only exact if the same data is then saved, in the same order, to a newly
+      constructed binary archive, since the binary archives only write pointer data,
+      polymorphic type names and versions the first time they are seen.
+
+      @code{.cpp}
+      cereal::SizingOutputArchive sizer;
+      sizer( header, payload );
+
+      std::string frame;
+      frame.reserve( sizer.size() );
+      @endcode
+
+      \ingroup Archives */
+  class SizingOutputArchive : public OutputArchive<SizingOutputArchive, AllowEmptyClassElision>
+  {
+    public:
+      //! The binary archive whose output is being sized
+      enum class Format
+      {
+        Binary,        //!< BinaryOutputArchive
+        PortableBinary //!< PortableBinaryOutputArchive, which writes its endianness first
+      };
+
+      //! Construct, counting the output of the given format
+      /*! @param format The binary archive being sized
+          @param framed Whether that archive frames the objects of versioned classes,
+                        see BinaryOutputArchive::Options
+          @param internStringsUpTo The longest string that archive interns, see
+                                   BinaryOutputArchive::Options */
+      explicit SizingOutputArchive( Format format = Format::Binary, bool framed = false, std::size_t internStringsUpTo = 0 ) :
+        OutputArchive<SizingOutputArchive, AllowEmptyClassElision>(this),
+        itsSize( format == Format::PortableBinary ? sizeof(bool) : 0 ),
+        itsFormat( format ),
+        itsFramed( framed ),
+        itsStrings( internStringsUpTo )
+      { }
+
+      //! Counts size bytes of data without writing them
+      void saveBinary( const void *, std::size_t size )
+      {
+        itsSize += size;
+      }
+
+      //! The binary archive whose output is being sized
+      Format format() const
+      {
+        return itsFormat;
+      }
+
+      //! Whether the objects of versioned classes are framed
+      /*! @internal */
+      bool framesVersionedObjects() const
+      {
+        return itsFramed;
+      }
+
+      //! The longest string that is interned
+      std::size_t internStringsUpTo() const
+      {
+        return itsStrings.maxBytes();
+      }
+
+      //! Counts the size written before a framed object
+      /*! @internal */
+      void beginVersionedObject()
+      {
+        itsSize += sizeof(std::uint64_t);
+        itsStringMarks.push_back( itsStrings.size() );
+      }
+
+      //! Forgets the strings interned within the outermost frame once it is finished, as the binary archives do
+      /*! @internal */
+      void endVersionedObject( bool )
+      {
+        auto const strings = itsStringMarks.back();
+        itsStringMarks.pop_back();
+
+        if( itsStringMarks.empty() )
+          itsStrings.forget( strings );
+      }
+
+      //! The number of bytes the binary archive would have written so far
+      std::size_t size() const
+      {
+        return itsSize;
+      }
+
+      //! Looks up a string about to be saved in the interning table
+      /*! @internal */
+      size_type internString( const void * data, std::size_t size )
+      {
+        return itsStrings.intern( data, size );
+      }
+
+    private:
+      std::size_t itsSize;
+      Format itsFormat;
+      bool itsFramed;
+      std::vector<std::size_t> itsStringMarks; //!< How many strings were interned when each open frame started
+      detail::OutputStringTable itsStrings;    //!< The strings counted so far, if interning
+  };
+
+  // ######################################################################
+  //! The size a type always has when saved to a binary archive, if it has one
+  /*! Types whose binary size does not depend on their value provide the size as
+      value, allowing it to be known at compile time.  All other types have no value.
+      Arithmetic types, enums, and std::array, std::pair, std::tuple and std::complex
+      of such types are covered.
+
+      This can be specialized for user types, but the size must then exactly match
+      what the type's serialization functions write; types with a class version
+      never qualify, since the version is written on first use only.
+
+      @code{.cpp}
+      static_assert( cereal::fixed_binary_size<std::pair<int32_t, double>>::value == 12, "" );
+      @endcode
+
+      @ingroup Utility */
+  template <class T, class SFINAE = void>
+  struct fixed_binary_size {};
+
+  namespace sizing_detail
+  {
+    //! Checks whether fixed_binary_size provides a value for T
+    template <class T>
+    struct has_fixed_binary_size
+    {
+      template <class U> static auto test(int) -> decltype( fixed_binary_size<U>::value, std::true_type() );
+      template <class>   static std::false_type test(...);
+      static const bool value = std::is_same<decltype(test<T>(0)), std::true_type>::value;
+    };
+
+    //! Sums the fixed sizes of several types, if they all have one
+    template <class ... Types>
+    struct sum_fixed_binary_size : std::integral_constant<std::size_t, 0> {};
+
+    template <class T, class ... Types>
+    struct sum_fixed_binary_size<T, Types...> :
+      std::integral_constant<std::size_t, fixed_binary_size<T>::value + sum_fixed_binary_size<Types...>::value> {};
+
+    //! Checks whether all of the types have a fixed size
+    template <class ... Types>
+    struct all_fixed_binary_size : std::true_type {};
+
+    template <class T, class ... Types>
+    struct all_fixed_binary_size<T, Types...> : std::integral_constant<bool,
+      has_fixed_binary_size<typename std::decay<T>::type>::value && all_fixed_binary_size<Types...>::value> {};
+
+    //! Sizes values that all have a fixed size, without serializing them
+    template <class ... Types> inline
+    std::size_t serialized_size( std::true_type, Types const & ... )
+    {
+      return sum_fixed_binary_size<typename std::decay<Types>::type...>::value;
+    }
+
+    //! Sizes values by running their serialization functions
+    template <class ... Types> inline
+    std::size_t serialized_size( std::false_type, Types const & ... args )
+    {
+      SizingOutputArchive ar;
+      ar( args... );
+      return ar.size();
+    }
+  } // namespace sizing_detail
+
+  //! Arithmetic types are saved as their bytes
+  template <class T>
+  struct fixed_binary_size<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> :
+    std::integral_constant<std::size_t, sizeof(T)> {};
+
+  //! Enums are saved as their underlying type, which has the same size
+  template <class T>
+  struct fixed_binary_size<T, typename std::enable_if<std::is_enum<T>::value>::type> :
+    std::integral_constant<std::size_t, sizeof(T)> {};
+
+  //! std::array saves its elements without a size
+  template <class T, std::size_t N>
+  struct fixed_binary_size<std::array<T, N>, typename std::enable_if<sizing_detail::has_fixed_binary_size<T>::value>::type> :
+    std::integral_constant<std::size_t, N * fixed_binary_size<T>::value> {};
+
+  //! std::pair saves both of its members
+  template <class T1, class T2>
+  struct fixed_binary_size<std::pair<T1, T2>, typename std::enable_if<sizing_detail::all_fixed_binary_size<T1, T2>::value>::type> :
+    sizing_detail::sum_fixed_binary_size<T1, T2> {};
+
+  //! std::tuple saves each of its members
+  template <class ... Types>
+  struct fixed_binary_size<std::tuple<Types...>, typename std::enable_if<sizing_detail::all_fixed_binary_size<Types...>::value>::type> :
+    sizing_detail::sum_fixed_binary_size<Types...> {};
+
+  //! std::complex saves its real and imaginary parts
+  template <class T>
+  struct fixed_binary_size<std::complex<T>, typename std::enable_if<sizing_detail::has_fixed_binary_size<T>::value>::type> :
+    std::integral_constant<std::size_t, 2 * fixed_binary_size<T>::value> {};
+
+  // ######################################################################
+  //! Computes the number of bytes a new BinaryOutputArchive would write for the given values
+  /*! When every value has a fixed_binary_size the result is computed at compile time
+      without touching the values; otherwise they are serialized to a SizingOutputArchive.
+      For a PortableBinaryOutputArchive, add sizeof(bool) for its endianness flag.
+
+      @ingroup Utility */
+  template <class ... Types> inline
+  std::size_t serialized_size( Types const & ... args )
+  {
+    return sizing_detail::serialized_size( sizing_detail::all_fixed_binary_size<Types...>{}, args... );
+  }
+
+  // ######################################################################
+  // SizingOutputArchive serialization functions
+
+  //! Sizing arithmetic types
+  template<class T> inline
+  typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+  CEREAL_SAVE_FUNCTION_NAME(SizingOutputArchive & ar, T const &)
+  {
+    ar.saveBinary(nullptr, sizeof(T));
+  }
+
+  //! Sizing NVP types, which are saved without their name
+  template <class Archive, class T> inline
+  typename std::enable_if<traits::is_same_archive<Archive, SizingOutputArchive>::value, void>::type
+  CEREAL_SERIALIZE_FUNCTION_NAME( Archive & ar, NameValuePair<T> & t )
+  {
+    ar( t.value );
+  }
+
+  //! Sizing SizeTags
+  template <class Archive, class T> inline
+  typename std::enable_if<traits::is_same_archive<Archive, SizingOutputArchive>::value, void>::type
+  CEREAL_SERIALIZE_FUNCTION_NAME( Archive & ar, SizeTag<T> & t )
+  {
+    ar( t.size );
+  }
+
+  //! Sizing binary data
+  template <class T> inline
+  void CEREAL_SAVE_FUNCTION_NAME(SizingOutputArchive & ar, BinaryData<T> const & bd)
+  {
+    ar.saveBinary( nullptr, static_cast<std::size_t>( bd.size ) );
+  }
+} // namespace cereal
+
+// register archives for polymorphic support
+CEREAL_REGISTER_ARCHIVE(cereal::SizingOutputArchive)
+
+#endif // CEREAL_ARCHIVES_SIZING_HPP_
@@ -30,17 +30,24 @@
 #define CEREAL_ARCHIVES_XML_HPP_
 #include <cereal/cereal.hpp>
 #include <cereal/details/util.hpp>
+#include <cereal/details/buffers.hpp>
 
 #include <cereal/external/rapidxml/rapidxml.hpp>
 #include <cereal/external/rapidxml/rapidxml_print.hpp>
 #include <cereal/external/base64.hpp>
+#include <cereal/details/parallel.hpp>
+#include <cereal/external/rapidjson/internal/dtoa.h>
 
 #include <sstream>
 #include <stack>
 #include <vector>
 #include <limits>
+#include <memory>
 #include <string>
 #include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cmath>
 
 namespace cereal
@@ -57,13 +64,392 @@ namespace cereal
     //! The name given to the root node in a cereal xml archive
     static const char * CEREAL_XML_STRING = CEREAL_XML_STRING_VALUE;
 
+    //! A string buffer whose contents can be read in place
+    /*! Values are formatted into a buffer that is reused between values, and copying
+        them out with str() would allocate for every value once the buffer has grown
+        past the small string optimization. */
+    class ValueBuffer : public std::stringbuf
+    {
+      public:
+        //! The start of the formatted value
+        const char * data() const { return pbase(); }
+    };
+
     //! Returns true if the character is whitespace
     inline bool isWhitespace( char c )
     {
       return c == ' ' || c == '\t' || c == '\n' || c == '\r';
     }
+
+    //! Returns true if the character is a decimal digit, independent of the locale
+    inline bool isDigit( char c )
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    //! Case insensitive comparison of [begin, end) against a lower case literal
+    inline bool equalsLowerCase( const char * begin, const char * end, const char * literal )
+    {
+      for( ; begin != end; ++begin, ++literal )
+        if( *literal == '\0' || ( *begin | 0x20 ) != *literal )
+          return false;
+
+      return *literal == '\0';
+    }
+
+    //! Parses a bool, accepting true, false, 1 and 0
+    inline bool parseBool( const char * str, size_t size )
+    {
+      if( size == 4 && std::memcmp( str, "true", 4 ) == 0 )
+        return true;
+      if( size == 5 && std::memcmp( str, "false", 5 ) == 0 )
+        return false;
+      if( size == 1 && ( *str == '1' || *str == '0' ) )
+        return *str == '1';
+
+      throw Exception("XML Parsing failed - invalid bool value");
+    }
+
+    //! Parses an integer of type T, throwing if the string is not a number or is out of range for T
+    /*! Accepts an optional sign followed by decimal digits, nothing else.  Does not allocate and
+        does not depend on the locale. */
+    template <class T> inline
+    T parseInteger( const char * str, size_t size )
+    {
+      const char * const end = str + size;
+
+      bool negative = false;
+      if( str != end && ( *str == '-' || *str == '+' ) )
+        negative = *str++ == '-';
+
+      if( str == end )
+        throw Exception("XML Parsing failed - invalid integer value");
+
+      // accumulate the magnitude, the most negative value has a magnitude of max + 1
+      const std::uint64_t limit = negative ? static_cast<std::uint64_t>( std::numeric_limits<T>::max() ) + ( std::is_signed<T>::value ? 1 : 0 )
+                                           : static_cast<std::uint64_t>( std::numeric_limits<T>::max() );
+      std::uint64_t magnitude = 0;
+      for( ; str != end; ++str )
+      {
+        if( !isDigit( *str ) )
+          throw Exception("XML Parsing failed - invalid integer value");
+
+        const unsigned digit = static_cast<unsigned>( *str - '0' );
+        if( magnitude > ( limit - digit ) / 10 )
+          throw Exception("XML Parsing failed - integer value out of range");
+
+        magnitude = magnitude * 10 + digit;
+      }
+
+      if( negative && !std::is_signed<T>::value && magnitude != 0 )
+        throw Exception("XML Parsing failed - integer value out of range");
+
+      // negate in unsigned arithmetic, which converts back without overflowing
+      return negative ? static_cast<T>( 0 - magnitude ) : static_cast<T>( magnitude );
+    }
+
+    //! Exactly representable powers of ten, used for the fast floating point path
+    template <class T> inline
+    T exactPowerOfTen( int exponent )
+    {
+      static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+      return static_cast<T>( powers[exponent] );
+    }
+
+    //! Converts significand * 10^exponent to T using the C library, without depending on the locale
+    /*! The number is formatted without a decimal point, which is the only locale dependent part */
+    inline float convertDecimal( const char * str, float ) { return std::strtof( str, nullptr ); }
+    inline double convertDecimal( const char * str, double ) { return std::strtod( str, nullptr ); }
+    inline long double convertDecimal( const char * str, long double ) { return std::strtold( str, nullptr ); }
+
+    //! Parses a floating point number of type T, throwing if it is invalid or out of range
+    /*! Accepts the formats produced by the XMLOutputArchive: an optional sign, digits with an
+        optional fraction and exponent, or inf and nan.  The result is correctly rounded as long as
+        the number has at most 19 significant digits.
+
+        When both the significand and the power of ten are exactly representable in T, the
+        result is computed with a single rounded operation (Clinger's fast path).  Everything
+        else is reformatted as digits and an exponent on the stack and handed to strtod. */
+    template <class T> inline
+    T parseFloatingPoint( const char * str, size_t size )
+    {
+      const char * const end = str + size;
+
+      bool negative = false;
+      if( str != end && ( *str == '-' || *str == '+' ) )
+        negative = *str++ == '-';
+
+      if( equalsLowerCase( str, end, "inf" ) || equalsLowerCase( str, end, "infinity" ) )
+        return negative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+      if( equalsLowerCase( str, end, "nan" ) )
+        return negative ? -std::numeric_limits<T>::quiet_NaN() : std::numeric_limits<T>::quiet_NaN();
+
+      // keep as many leading digits as fit in 64 bits, remembering whether anything non-zero was dropped
+      static const std::uint64_t maxSignificand = ( std::numeric_limits<std::uint64_t>::max() - 9 ) / 10;
+      std::uint64_t significand = 0;
+      int exponent = 0;
+      bool truncated = false;
+      bool anyDigits = false;
+
+      for( ; str != end && isDigit( *str ); ++str, anyDigits = true )
+      {
+        if( significand <= maxSignificand )
+          significand = significand * 10 + static_cast<unsigned>( *str - '0' );
+        else
+        {
+          truncated = truncated || *str != '0';
+          ++exponent;
+        }
+      }
+
+      if( str != end && *str == '.' )
+      {
+        for( ++str; str != end && isDigit( *str ); ++str, anyDigits = true )
+        {
+          if( significand <= maxSignificand )
+          {
+            significand = significand * 10 + static_cast<unsigned>( *str - '0' );
+            --exponent;
+          }
+          else
+            truncated = truncated || *str != '0';
+        }
+      }
+
+      if( !anyDigits )
+        throw Exception("XML Parsing failed - invalid floating point value");
+
+      if( str != end && ( *str == 'e' || *str == 'E' ) )
+      {
+        ++str;
+        bool negativeExponent = false;
+        if( str != end && ( *str == '-' || *str == '+' ) )
+          negativeExponent = *str++ == '-';
+
+        if( str == end )
+          throw Exception("XML Parsing failed - invalid floating point value");
+
+        int explicitExponent = 0;
+        for( ; str != end && isDigit( *str ); ++str )
+          if( explicitExponent < 100000 ) // saturate, anything beyond is zero or infinity anyway
+            explicitExponent = explicitExponent * 10 + ( *str - '0' );
+
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+      }
+
+      if( str != end )
+        throw Exception("XML Parsing failed - invalid floating point value");
+
+      T value;
+      const int digits = std::numeric_limits<T>::digits;
+      const int maxExactExponent = digits >= 53 ? 22 : 10;
+      if( !truncated && ( digits >= 64 || significand <= ( std::uint64_t( 1 ) << ( digits < 64 ? digits : 0 ) ) ) &&
+          exponent >= -maxExactExponent && exponent <= maxExactExponent )
+      {
+        value = static_cast<T>( significand );
+        value = exponent < 0 ? value / exactPowerOfTen<T>( -exponent ) : value * exactPowerOfTen<T>( exponent );
+      }
+      else
+      {
+        // a trailing sticky digit stands in for the dropped ones when rounding
+        char buffer[48];
+        #ifdef _MSC_VER
+        sprintf_s( buffer, sizeof(buffer), truncated ? "%llu1e%d" : "%llue%d",
+                   static_cast<unsigned long long>( significand ), truncated ? exponent - 1 : exponent );
+        #else
+        std::snprintf( buffer, sizeof(buffer), truncated ? "%llu1e%d" : "%llue%d",
+                       static_cast<unsigned long long>( significand ), truncated ? exponent - 1 : exponent );
+        #endif
+        value = convertDecimal( buffer, T() );
+
+        if( std::isinf( value ) )
+          throw Exception("XML Parsing failed - floating point value out of range");
+      }
+
+      return negative ? -value : value;
+    }
+
+    //! Keeps a single copy of every distinct name it is given
+    /*! Nodes can refer to the interned copy for as long as the table lives,
+        instead of each getting a copy of its name */
+    class NameTable
+    {
+      public:
+        NameTable() : itsSlots( 64, nullptr ), itsCount( 0 ), itsFree( nullptr ), itsFreeSize( 0 )
+        { }
+
+        //! Returns the interned copy of a name, storing it the first time it is seen
+        /*! @param name The name, which does not need to be null terminated
+            @param size The length of the name
+            @return A null terminated copy of the name that lives as long as the table */
+        const char * intern( const char * name, size_t size )
+        {
+          auto const mask = itsSlots.size() - 1;
+          for( size_t i = hash( name, size ) & mask; ; i = ( i + 1 ) & mask )
+          {
+            auto const slot = itsSlots[i];
+            if( !slot )
+            {
+              auto const stored = store( name, size );
+              itsSlots[i] = stored;
+              if( ++itsCount * 2 > itsSlots.size() )
+                grow();
+              return stored;
+            }
+
+            if( std::strncmp( slot, name, size ) == 0 && slot[size] == '\0' )
+              return slot;
+          }
+        }
+
+      private:
+        //! FNV-1a
+        static size_t hash( const char * name, size_t size )
+        {
+          std::uint32_t h = 2166136261u;
+          for( size_t i = 0; i < size; ++i )
+            h = ( h ^ static_cast<unsigned char>( name[i] ) ) * 16777619u;
+          return h;
+        }
+
+        //! Copies a name into the blocks owned by the table
+        const char * store( const char * name, size_t size )
+        {
+          if( itsFreeSize < size + 1 )
+          {
+            itsFreeSize = size + 1 > 4096 ? size + 1 : 4096;
+            itsBlocks.emplace_back( new char[itsFreeSize] );
+            itsFree = itsBlocks.back().get();
+          }
+
+          auto const stored = itsFree;
+          std::memcpy( stored, name, size );
+          stored[size] = '\0';
+
+          itsFree += size + 1;
+          itsFreeSize -= size + 1;
+          return stored;
+        }
+
+        //! Doubles the number of slots
+        void grow()
+        {
+          std::vector<const char *> slots( itsSlots.size() * 2, nullptr );
+          auto const mask = slots.size() - 1;
+          for( auto name : itsSlots )
+            if( name )
+            {
+              size_t i = hash( name, std::strlen( name ) ) & mask;
+              while( slots[i] )
+                i = ( i + 1 ) & mask;
+              slots[i] = name;
+            }
+
+          itsSlots.swap( slots );
+        }
+
+        std::vector<const char *> itsSlots;           //!< Open addressed table of the interned names
+        size_t itsCount;                              //!< Number of interned names
+        std::vector<std::unique_ptr<char[]>> itsBlocks; //!< Storage for the interned names
+        char * itsFree;                               //!< Unused space in the last block
+        size_t itsFreeSize;                           //!< Size of the unused space in the last block
+    };
   }
 
+  class XMLOutputArchive;
+  class XMLInputArchive;
+
+  // ######################################################################
+  //! Reusable memory for XML archives
+  /*! Without a context, every XML archive builds its document in a fresh rapidxml
+      memory pool, copies the name of every node into it, and frees it all again on
+      destruction.  Archives constructed against an XMLContext instead use the document
+      of the context, whose memory is kept when it is cleared after each archive, and
+      the buffer of the context to read input into.  Names of the nodes and attributes
+      an output archive creates are interned in the context, so each distinct name is
+      copied once for the lifetime of the context rather than once per node.
+
+      A context can be used by one archive at a time, and must outlive it.
+
+      @code{cpp}
+      cereal::XMLContext context;
+      for( auto & message : messages )
+      {
+        std::ostringstream os;
+        {
+          cereal::XMLOutputArchive ar( os, context );
+          ar( message );
+        }
+        send( os.str() );
+      }
+      @endcode
+
+      \ingroup Archives */
+  class XMLContext
+  {
+    public:
+      XMLContext() : itsInUse( false )
+      { }
+
+      XMLContext( XMLContext const & ) = delete;
+      XMLContext & operator=( XMLContext const & ) = delete;
+
+    private:
+      friend class XMLOutputArchive;
+      friend class XMLInputArchive;
+
+      //! Makes a context, if any, available for the lifetime of one archive
+      class Lease
+      {
+        public:
+          Lease( XMLContext * context ) : itsContext( context )
+          {
+            if( itsContext )
+              itsContext->acquire();
+          }
+
+          ~Lease()
+          {
+            if( itsContext )
+              itsContext->release();
+          }
+
+          //! The document of the context, or the given one if there is no context
+          rapidxml::xml_document<> & document( rapidxml::xml_document<> & own ) const
+          {
+            return itsContext ? itsContext->itsXML : own;
+          }
+
+          XMLContext * context() const { return itsContext; }
+
+        private:
+          XMLContext * itsContext;
+      };
+
+      void acquire()
+      {
+        if( itsInUse )
+          throw Exception("An XMLContext can only be used by one archive at a time");
+
+        itsInUse = true;
+      }
+
+      //! Clears the document, keeping its memory for the next archive
+      void release()
+      {
+        itsXML.remove_all_nodes();
+        itsXML.remove_all_attributes();
+        itsXML.reset();
+        itsInUse = false;
+      }
+
+      rapidxml::xml_document<> itsXML;  //!< The document used by the current archive
+      std::vector<char> itsText;        //!< Buffer the input text is read into
+      xml_detail::NameTable itsNames;   //!< Interned node and attribute names
+      bool itsInUse;                    //!< Whether an archive is using the context
+  };
+
   // ######################################################################
   //! An output archive designed to save data to XML
   /*! This archive uses RapidXML to build an in memory XML tree of the
@@ -71,6 +457,10 @@ namespace cereal
       The envisioned way of using this archive is in an RAII fashion, letting
       the automatic destruction of the object cause the flush to its stream.
 
+      For large outputs, the archive can instead stream elements directly as they
+      are serialized (see Options), producing the same text without holding the
+      document in memory.  The root element is still only closed upon destruction.
+
       XML archives provides a human readable output but at decreased
       performance (both in time and space) compared to binary archives.
 
@@ -79,10 +469,11 @@ namespace cereal
       of the output tree will be given an automatically generated delimited name.
 
       The precision of the output archive controls the number of decimals output
-      for floating point numbers and should be sufficiently large (i.e. at least 20)
-      if there is a desire to have binary equality between the numbers output and
-      those read in.  In general you should expect a loss of precision when going
-      from floating point to text and back.
+      for floating point numbers.  At the default precision (max_digits10 for double)
+      or above, floats and doubles are written using the shortest representation that
+      reads back to exactly the same value, so there is no loss of precision when going
+      from floating point to text and back.  Lower precisions trade exactness for
+      fewer digits.
 
       XML archives can optionally print the type of everything they serialize, which
       adds an attribute to each node.
@@ -93,7 +484,7 @@ namespace cereal
       is accomplished through the cereal::SizeTag object, which will also add an attribute
       to its parent field.
       \ingroup Archives */
-  class XMLOutputArchive : public OutputArchive<XMLOutputArchive>, public traits::TextArchive
+  class XMLOutputArchive : public OutputArchive<XMLOutputArchive>, public traits::TextArchive, public detail::ThreadPoolUser
   {
     public:
       /*! @name Common Functionality
@@ -113,19 +504,34 @@ namespace cereal
           //! Specify specific options for the XMLOutputArchive
           /*! @param precision The precision used for floating point numbers
               @param indent Whether to indent each line of XML
-              @param outputType Whether to output the type of each serialized object as an attribute */
+              @param outputType Whether to output the type of each serialized object as an attribute
+              @param streaming Whether to write elements to the stream as they are serialized instead
+                               of building a document in memory and writing it upon destruction.
+                               Memory use then depends on the nesting depth rather than the size of
+                               the output.  Attributes can only be added to a node before any of
+                               its contents.
+              @param compactArithmetic Whether std::vectors of arithmetic types (other than bool)
+                                       are saved as a single base64 encoded block of their
+                                       little endian bytes instead of one node per element.
+                                       Loading detects either form automatically. */
           explicit Options( int precision = std::numeric_limits<double>::max_digits10,
                             bool indent = true,
-                            bool outputType = false ) :
+                            bool outputType = false,
+                            bool streaming = false,
+                            bool compactArithmetic = false ) :
             itsPrecision( precision ),
             itsIndent( indent ),
-            itsOutputType( outputType ) { }
+            itsOutputType( outputType ),
+            itsStreaming( streaming ),
+            itsCompactArithmetic( compactArithmetic ) { }
 
         private:
           friend class XMLOutputArchive;
           int itsPrecision;
           bool itsIndent;
           bool itsOutputType;
+          bool itsStreaming;
+          bool itsCompactArithmetic;
       };
 
       //! Construct, outputting to the provided stream upon destruction
@@ -134,21 +540,54 @@ namespace cereal
           @param options The XML specific options to use.  See the Options struct
                          for the values of default parameters */
       XMLOutputArchive( std::ostream & stream, Options const & options = Options::Default() ) :
+        XMLOutputArchive( stream, nullptr, options )
+      { }
+
+      //! Construct, outputting to the provided stream and building the document in a context
+      /*! @param stream  The stream to output to.  Note that XML is only guaranteed to flush
+                         its output to the stream upon destruction.
+          @param context The context to take memory from.  It must outlive the archive.
+          @param options The XML specific options to use.  See the Options struct
+                         for the values of default parameters */
+      XMLOutputArchive( std::ostream & stream, XMLContext & context, Options const & options = Options::Default() ) :
+        XMLOutputArchive( stream, &context, options )
+      { }
+
+    private:
+      XMLOutputArchive( std::ostream & stream, XMLContext * context, Options const & options ) :
         OutputArchive<XMLOutputArchive>(this),
+        itsLease(context),
         itsStream(stream),
+        itsXML( itsLease.document( itsOwnXML ) ),
+        itsOS( &itsValueBuffer ),
         itsOutputType( options.itsOutputType ),
-        itsIndent( options.itsIndent )
+        itsIndent( options.itsIndent ),
+        itsShortestFloat( options.itsPrecision >= std::numeric_limits<double>::max_digits10 ),
+        itsStreaming( options.itsStreaming ),
+        itsCompactArithmetic( options.itsCompactArithmetic )
       {
-        // rapidxml will delete all allocations when xml_document is cleared
-        auto node = itsXML.allocate_node( rapidxml::node_declaration );
-        node->append_attribute( itsXML.allocate_attribute( "version", "1.0" ) );
-        node->append_attribute( itsXML.allocate_attribute( "encoding", "utf-8" ) );
-        itsXML.append_node( node );
+        if( itsStreaming )
+        {
+          write( "<?xml version=\"1.0\" encoding=\"utf-8\"?>" );
+          if( itsIndent )
+            write( "\n" );
 
-        // allocate root node
-        auto root = itsXML.allocate_node( rapidxml::node_element, xml_detail::CEREAL_XML_STRING );
-        itsXML.append_node( root );
-        itsNodes.emplace( root );
+          itsNodes.emplace();
+          openElement( xml_detail::CEREAL_XML_STRING );
+        }
+        else
+        {
+          // rapidxml will delete all allocations when xml_document is cleared
+          auto node = itsXML.allocate_node( rapidxml::node_declaration );
+          node->append_attribute( itsXML.allocate_attribute( "version", "1.0" ) );
+          node->append_attribute( itsXML.allocate_attribute( "encoding", "utf-8" ) );
+          itsXML.append_node( node );
+
+          // allocate root node
+          auto root = itsXML.allocate_node( rapidxml::node_element, xml_detail::CEREAL_XML_STRING );
+          itsXML.append_node( root );
+          itsNodes.emplace( root );
+        }
 
         // set attributes on the streams
         itsStream << std::boolalpha;
@@ -157,12 +596,25 @@ namespace cereal
         itsOS.precision( options.itsPrecision );
       }
 
+    public:
       //! Destructor, flushes the XML
       ~XMLOutputArchive()
       {
-        const int flags = itsIndent ? 0x0 : rapidxml::print_no_indenting;
-        rapidxml::print( itsStream, itsXML, flags );
-        itsXML.clear();
+        if( itsStreaming )
+        {
+          // close everything that is still open, including the root
+          while( !itsNodes.empty() )
+            closeElement();
+
+          // rapidxml::print ends the document itself with a line break too
+          if( itsIndent )
+            write( "\n" );
+        }
+        else
+        {
+          const int flags = itsIndent ? 0x0 : rapidxml::print_no_indenting;
+          rapidxml::print( itsStream, itsXML, flags );
+        }
       }
 
       //! Saves some binary data, encoded as a base64 string, with an optional name
@@ -175,11 +627,11 @@ namespace cereal
 
         startNode();
 
-        auto base64string = base64::encode( reinterpret_cast<const unsigned char *>( data ), size );
-        saveValue( base64string );
-
         if( itsOutputType )
-          itsNodes.top().node->append_attribute( itsXML.allocate_attribute( "type", "cereal binary data" ) );
+          appendAttribute( "type", "cereal binary data" );
+
+        auto base64string = parallel_detail::encode_base64( itsPool, itsChunkSize, reinterpret_cast<const unsigned char *>( data ), size );
+        saveValue( base64string );
 
         finishNode();
       };
@@ -198,14 +650,32 @@ namespace cereal
           The node will then be pushed onto the node stack. */
       void startNode()
       {
-        // generate a name for this new node
-        const auto nameString = itsNodes.top().getValueName();
+        #ifdef CEREAL_ENABLE_TRACING
+        if( tracer() )
+          tracer()->beginNode( itsNodes.top().name );
+        #endif // CEREAL_ENABLE_TRACING
 
-        // allocate strings for all of the data in the XML object
-        auto namePtr = itsXML.allocate_string( nameString.data(), nameString.length() + 1 );
+        if( itsStreaming )
+        {
+          // generate a name for this new node
+          const auto nameString = itsNodes.top().getValueName();
+
+          auto & parent = itsNodes.top();
+          closeStartTag( parent );
+          if( itsIndent && !parent.hasElements )
+            write( "\n" );
+          parent.hasElements = true;
+
+          itsNodes.emplace();
+          openElement( nameString );
+          return;
+        }
+
+        size_t nameSize;
+        const auto namePtr = nextNodeName( nameSize );
 
         // insert into the XML
-        auto node = itsXML.allocate_node( rapidxml::node_element, namePtr, nullptr, nameString.size() );
+        auto node = itsXML.allocate_node( rapidxml::node_element, namePtr, nullptr, nameSize );
         itsNodes.top().node->append_node( node );
         itsNodes.emplace( node );
       }
@@ -213,7 +683,15 @@ namespace cereal
       //! Designates the most recently added node as finished
       void finishNode()
       {
-        itsNodes.pop();
+        if( itsStreaming )
+          closeElement();
+        else
+          itsNodes.pop();
+
+        #ifdef CEREAL_ENABLE_TRACING
+        if( tracer() )
+          tracer()->endNode();
+        #endif // CEREAL_ENABLE_TRACING
       }
 
       //! Sets the name for the next node created with startNode
@@ -232,22 +710,18 @@ namespace cereal
         itsOS.clear(); itsOS.seekp( 0, std::ios::beg );
         itsOS << value << std::ends;
 
-        const auto strValue = itsOS.str();
+        // The buffer is read in place and reused, so the value ends at the '\0' added by
+        // std::ends rather than at the end of the buffer
+        const auto strValue = itsValueBuffer.data();
+        const auto len = std::strlen( strValue );
 
         // If the first or last character is a whitespace, add xml:space attribute
-        // the string always contains a '\0' added by std::ends, so the last character is at len-2 and an 'empty' 
-        // string has a length of 1 or lower
-        const auto len = strValue.length();
-        if ( len > 1 && ( xml_detail::isWhitespace( strValue[0] ) || xml_detail::isWhitespace( strValue[len - 2] ) ) )
+        if ( len > 0 && ( xml_detail::isWhitespace( strValue[0] ) || xml_detail::isWhitespace( strValue[len - 1] ) ) )
         {
-          itsNodes.top().node->append_attribute( itsXML.allocate_attribute( "xml:space", "preserve" ) );
+          appendAttribute( "xml:space", "preserve" );
         }
 
-        // allocate strings for all of the data in the XML object
-        auto dataPtr = itsXML.allocate_string( itsOS.str().c_str(), itsOS.str().length() + 1 );
-
-        // insert into the XML
-        itsNodes.top().node->append_node( itsXML.allocate_node( rapidxml::node_data, nullptr, dataPtr ) );
+        insertValue( strValue, len );
       }
 
       //! Overload for uint8_t prevents them from being serialized as characters
@@ -262,6 +736,46 @@ namespace cereal
         saveValue( static_cast<int32_t>( value ) );
       }
 
+      //! Overload for float, see saveFloatingPoint
+      void saveValue( float const & value )
+      {
+        saveFloatingPoint( value );
+      }
+
+      //! Overload for double, see saveFloatingPoint
+      void saveValue( double const & value )
+      {
+        saveFloatingPoint( value );
+      }
+
+      //! Saves an array of arithmetic values as a compact block into the current node, if enabled
+      /*! The node gets an encoding attribute and holds the base64 encoded little endian
+          bytes of the values as its value.
+          @return false, without saving anything, if compact blocks are disabled in the Options */
+      template <class T> inline
+      bool saveArithmeticBlock( T const * data, size_t count )
+      {
+        static_assert( std::is_arithmetic<T>::value, "Only arithmetic types can be saved as a block" );
+
+        if( !itsCompactArithmetic )
+          return false;
+
+        appendAttribute( "encoding", "base64" );
+
+        std::string encoded;
+        if( detail::is_little_endian() || sizeof(T) == 1 )
+          encoded = parallel_detail::encode_base64( itsPool, itsChunkSize, reinterpret_cast<const unsigned char *>( data ), count * sizeof(T) );
+        else
+        {
+          std::vector<T> swapped( data, data + count );
+          detail::swap_bytes( swapped.data(), sizeof(T), count );
+          encoded = parallel_detail::encode_base64( itsPool, itsChunkSize, reinterpret_cast<const unsigned char *>( swapped.data() ), count * sizeof(T) );
+        }
+
+        insertValue( encoded.c_str(), encoded.size() );
+        return true;
+      }
+
       //! Causes the type to be appended as an attribute to the most recently made node if output type is set to true
       template <class T> inline
       void insertType()
@@ -272,16 +786,30 @@ namespace cereal
         // generate a name for this new node
         const auto nameString = util::demangledName<T>();
 
-        // allocate strings for all of the data in the XML object
-        auto namePtr = itsXML.allocate_string( nameString.data(), nameString.length() + 1 );
-
-        itsNodes.top().node->append_attribute( itsXML.allocate_attribute( "type", namePtr ) );
+        appendAttribute( "type", nameString.c_str() );
       }
 
       //! Appends an attribute to the current top level node
+      /*! When streaming, attributes must be added before any contents of the node */
       void appendAttribute( const char * name, const char * value )
       {
-        auto namePtr =  itsXML.allocate_string( name );
+        if( itsStreaming )
+        {
+          if( !itsNodes.top().tagOpen )
+            throw Exception("XML attributes must be added before any node contents when streaming");
+
+          write( " " );
+          write( name );
+          const auto valueSize = std::strlen( value );
+          const bool useApostrophe = std::memchr( value, '"', valueSize ) != nullptr;
+          write( useApostrophe ? "='" : "=\"" );
+          writeEscaped( value, valueSize, useApostrophe ? '"' : '\'' );
+          write( useApostrophe ? "'" : "\"" );
+          return;
+        }
+
+        auto namePtr = itsLease.context() ? itsLease.context()->itsNames.intern( name, std::strlen( name ) )
+                                          : itsXML.allocate_string( name );
         auto valuePtr = itsXML.allocate_string( value );
         itsNodes.top().node->append_attribute( itsXML.allocate_attribute( namePtr, valuePtr ) );
       }
@@ -294,12 +822,17 @@ namespace cereal
                   const char * nm = nullptr ) :
           node( n ),
           counter( 0 ),
-          name( nm )
+          name( nm ),
+          tagOpen( false ),
+          hasElements( false )
         { }
 
-        rapidxml::xml_node<> * node; //!< A pointer to this node
+        rapidxml::xml_node<> * node; //!< A pointer to this node, unless streaming
         size_t counter;              //!< The counter for naming child nodes
         const char * name;           //!< The name for the next child node
+        std::string elementName;     //!< The name of this node, used to close it when streaming
+        bool tagOpen;                //!< Whether the start tag is still open for attributes when streaming
+        bool hasElements;            //!< Whether child elements were written when streaming
 
         //! Gets the name for the next child node created from this node
         /*! The name will be automatically generated using the counter if
@@ -321,12 +854,186 @@ namespace cereal
       //! @}
 
     private:
-      std::ostream & itsStream;        //!< The output stream
-      rapidxml::xml_document<> itsXML; //!< The XML document
+      //! Saves a float or double using the shortest representation that reads back exactly
+      /*! Falls back to the stream formatting at the requested precision if that is lower
+          than max_digits10, or for infinities and NaN */
+      template <class T> inline
+      void saveFloatingPoint( T const & value )
+      {
+        if( !itsShortestFloat || !std::isfinite( value ) )
+          return saveValue<T>( value );
+
+        char buffer[rapidjson::internal::kMaxDtoaLength + 1];
+        char * end = rapidjson::internal::dtoa( value, buffer );
+        *end = '\0';
+
+        insertValue( buffer, static_cast<size_t>( end - buffer ) );
+      }
+
+      //! Gets the name for the next child of the top node, stored so that it lives as long as the document
+      /*! With a context the name is interned in it, otherwise it is copied into the document
+          @param size Set to the length of the name */
+      const char * nextNodeName( size_t & size )
+      {
+        auto const context = itsLease.context();
+        if( !context )
+        {
+          const auto nameString = itsNodes.top().getValueName();
+          size = nameString.size();
+          return itsXML.allocate_string( nameString.data(), size + 1 );
+        }
+
+        auto & parent = itsNodes.top();
+        if( parent.name )
+        {
+          auto const name = parent.name;
+          parent.name = nullptr;
+          size = std::strlen( name );
+          return context->itsNames.intern( name, size );
+        }
+
+        // same as NodeInfo::getValueName, without building a string
+        char buffer[32] = "value";
+        char digits[24];
+        size_t count = 0;
+        for( auto counter = parent.counter++; count == 0 || counter != 0; counter /= 10 )
+          digits[count++] = static_cast<char>( '0' + counter % 10 );
+
+        size = 5;
+        while( count )
+          buffer[size++] = digits[--count];
+
+        return context->itsNames.intern( buffer, size );
+      }
+
+      //! Inserts the formatted text of a value into the current top level node
+      void insertValue( const char * data, size_t size )
+      {
+        if( itsStreaming )
+        {
+          closeStartTag( itsNodes.top() );
+          writeEscaped( data, size, '\0' );
+          return;
+        }
+
+        // allocate strings for all of the data in the XML object
+        auto dataPtr = itsXML.allocate_string( data, size + 1 );
+
+        // insert into the XML
+        itsNodes.top().node->append_node( itsXML.allocate_node( rapidxml::node_data, nullptr, dataPtr, 0, size ) );
+      }
+
+      //! Writes the start of an element for the node at the top of the stack when streaming
+      void openElement( std::string const & name )
+      {
+        auto & node = itsNodes.top();
+        node.elementName = name;
+        node.tagOpen = true;
+
+        writeIndent( itsNodes.size() - 1 );
+        write( "<" );
+        write( node.elementName.c_str() );
+      }
+
+      //! Ends the start tag of a node once it gets contents when streaming
+      void closeStartTag( NodeInfo & node )
+      {
+        if( node.tagOpen )
+        {
+          write( ">" );
+          node.tagOpen = false;
+        }
+      }
+
+      //! Writes the end of the element at the top of the stack and pops it when streaming
+      /*! Mirrors the formatting of rapidxml::print */
+      void closeElement()
+      {
+        auto & node = itsNodes.top();
+        if( node.tagOpen )
+          write( "/>" );
+        else
+        {
+          if( node.hasElements )
+            writeIndent( itsNodes.size() - 1 );
+
+          write( "</" );
+          write( node.elementName.c_str() );
+          write( ">" );
+        }
+
+        if( itsIndent )
+          write( "\n" );
+
+        itsNodes.pop();
+      }
+
+      //! Writes characters to the output stream, setting its badbit if they could not all be written
+      /*! The stream is written from the destructor as well, so failures are reported
+          through the stream, as they are when the document is printed */
+      void write( const char * data, size_t size )
+      {
+        auto const written = itsStream.rdbuf()->sputn( data, static_cast<std::streamsize>( size ) );
+        if( written != static_cast<std::streamsize>( size ) )
+          itsStream.setstate( std::ios::badbit );
+      }
+
+      //! Writes a null terminated string to the output stream
+      void write( const char * str )
+      {
+        write( str, std::strlen( str ) );
+      }
+
+      //! Writes one tab per level of depth to the output stream, if indenting
+      void writeIndent( size_t depth )
+      {
+        if( itsIndent )
+          for( size_t i = 0; i < depth; ++i )
+            if( std::char_traits<char>::eq_int_type( itsStream.rdbuf()->sputc( '\t' ), std::char_traits<char>::eof() ) )
+              itsStream.setstate( std::ios::badbit );
+      }
+
+      //! Writes characters to the output stream, replacing the XML special characters with references
+      /*! @param noexpand A character that is written as is, as rapidxml does for the quote
+                          that is not used to delimit attribute values */
+      void writeEscaped( const char * data, size_t size, char noexpand )
+      {
+        auto run = data;
+        for( auto end = data + size; data != end; ++data )
+        {
+          const char * reference;
+          switch( *data )
+          {
+            case '<': reference = "&lt;"; break;
+            case '>': reference = "&gt;"; break;
+            case '\'': reference = "&apos;"; break;
+            case '"': reference = "&quot;"; break;
+            case '&': reference = "&amp;"; break;
+            default: continue;
+          }
+
+          if( *data == noexpand )
+            continue;
+
+          write( run, static_cast<size_t>( data - run ) );
+          write( reference );
+          run = data + 1;
+        }
+        write( run, static_cast<size_t>( data - run ) );
+      }
+
+      XMLContext::Lease itsLease;        //!< The context in use, if any
+      std::ostream & itsStream;          //!< The output stream
+      rapidxml::xml_document<> itsOwnXML; //!< The XML document when not using a context
+      rapidxml::xml_document<> & itsXML; //!< The XML document, unless streaming
       std::stack<NodeInfo> itsNodes;   //!< A stack of nodes added to the document
-      std::ostringstream itsOS;        //!< Used to format strings internally
+      xml_detail::ValueBuffer itsValueBuffer; //!< Storage for itsOS
+      std::ostream itsOS;              //!< Used to format strings internally
       bool itsOutputType;              //!< Controls whether type information is printed
       bool itsIndent;                  //!< Controls whether indenting is used
+      bool itsShortestFloat;           //!< Whether floats are written in their shortest exact form
+      bool itsStreaming;               //!< Whether elements are written as they are serialized
+      bool itsCompactArithmetic;       //!< Whether arithmetic vectors are saved as compact blocks
   }; // XMLOutputArchive
 
   // ######################################################################
@@ -365,7 +1072,7 @@ namespace cereal
       @endcode
 
       \ingroup Archives */
-  class XMLInputArchive : public InputArchive<XMLInputArchive>, public traits::TextArchive
+  class XMLInputArchive : public InputArchive<XMLInputArchive>, public traits::TextArchive, public detail::ThreadPoolUser
   {
     public:
       /*! @name Common Functionality
@@ -379,31 +1086,50 @@ namespace cereal
           @param stream The stream to read from.  Can be a stringstream or a file. */
       XMLInputArchive( std::istream & stream ) :
         InputArchive<XMLInputArchive>( this ),
-        itsData( std::istreambuf_iterator<char>( stream ), std::istreambuf_iterator<char>() )
+        itsLease( nullptr ),
+        itsXML( itsOwnXML )
       {
-        try
-        {
+        parse( detail::read_stream( stream, itsData ) );
+      }
+
+      //! Construct, reading in from the provided stream into the buffer and document of a context
+      /*! @param stream The stream to read from
+          @param context The context to take memory from.  It must outlive the archive. */
+      XMLInputArchive( std::istream & stream, XMLContext & context ) :
+        InputArchive<XMLInputArchive>( this ),
+        itsLease( &context ),
+        itsXML( context.itsXML )
+      {
+        parse( detail::read_stream( stream, context.itsText ) );
+      }
+
+      //! Construct, taking ownership of a buffer holding an XML document
+      /*! The document is parsed in place, without being copied.
+
+          @param data The XML document.  A terminating null character is appended if not already present. */
+      XMLInputArchive( std::vector<char> && data ) :
+        InputArchive<XMLInputArchive>( this ),
+        itsLease( nullptr ),
+        itsData( std::move( data ) ),
+        itsXML( itsOwnXML )
+      {
+        if( itsData.empty() || itsData.back() != '\0' )
           itsData.push_back('\0'); // rapidxml will do terrible things without the data being null terminated
-          itsXML.parse<rapidxml::parse_trim_whitespace | rapidxml::parse_no_data_nodes | rapidxml::parse_declaration_node>( reinterpret_cast<char *>( itsData.data() ) );
-        }
-        catch( rapidxml::parse_error const & )
-        {
-          //std::cerr << "-----Original-----" << std::endl;
-          //stream.seekg(0);
-          //std::cout << std::string( std::istreambuf_iterator<char>( stream ), std::istreambuf_iterator<char>() ) << std::endl;
 
-          //std::cerr << "-----Error-----" << std::endl;
-          //std::cerr << e.what() << std::endl;
-          //std::cerr << e.where<char>() << std::endl;
-          throw Exception("XML Parsing failed - likely due to invalid characters or invalid naming");
-        }
+        parse( itsData.data() );
+      }
 
-        // Parse the root
-        auto root = itsXML.first_node( xml_detail::CEREAL_XML_STRING );
-        if( root == nullptr )
-          throw Exception("Could not detect cereal root node - likely due to empty or invalid input");
-        else
-          itsNodes.emplace( root );
+      //! Construct, parsing a caller owned buffer in place
+      /*! The buffer is modified during parsing and values are read directly out of it,
+          so it must outlive the archive.
+
+          @param data A null terminated XML document */
+      XMLInputArchive( char * data ) :
+        InputArchive<XMLInputArchive>( this ),
+        itsLease( nullptr ),
+        itsXML( itsOwnXML )
+      {
+        parse( data );
       }
 
       //! Loads some binary data, encoded as a base64 string, optionally specified by some name
@@ -417,16 +1143,12 @@ namespace cereal
         setNextName( name );
         startNode();
 
-        std::string encoded;
-        loadValue( encoded );
-
-        auto decoded = base64::decode( encoded );
+        // Decode straight from the node into the destination
+        auto const node = itsNodes.top().node;
 
-        if( size != decoded.size() )
+        if( !parallel_detail::decode_base64( itsPool, itsChunkSize, node->value(), node->value_size(), static_cast<unsigned char *>( data ), size ) )
           throw Exception("Decoded binary data size does not match specified size");
 
-        std::memcpy( data, decoded.data(), decoded.size() );
-
         finishNode();
       };
 
@@ -462,6 +1184,11 @@ namespace cereal
             throw Exception("XML Parsing failed - provided NVP not found");
         }
 
+        #ifdef CEREAL_ENABLE_TRACING
+        if( tracer() )
+          tracer()->beginNode( expectedName );
+        #endif // CEREAL_ENABLE_TRACING
+
         itsNodes.emplace( next );
       }
 
@@ -476,6 +1203,11 @@ namespace cereal
 
         // Reset name
         itsNodes.top().name = nullptr;
+
+        #ifdef CEREAL_ENABLE_TRACING
+        if( tracer() )
+          tracer()->endNode();
+        #endif // CEREAL_ENABLE_TRACING
       }
 
       //! Retrieves the current node name
@@ -496,9 +1228,7 @@ namespace cereal
                                           std::is_same<T, bool>::value> = traits::sfinae> inline
       void loadValue( T & value )
       {
-        std::istringstream is( itsNodes.top().node->value() );
-        is.setf( std::ios::boolalpha );
-        is >> value;
+        value = xml_detail::parseBool( itsNodes.top().node->value(), itsNodes.top().node->value_size() );
       }
 
       //! Loads a char (signed or unsigned) from the current top node
@@ -522,111 +1252,47 @@ namespace cereal
         uint32_t val; loadValue( val ); value = static_cast<uint8_t>( val );
       }
 
-      //! Loads a type best represented as an unsigned long from the current top node
+      //! Loads an unsigned integer from the current top node
       template <class T, traits::EnableIf<std::is_unsigned<T>::value,
                                           !std::is_same<T, bool>::value,
-                                          !std::is_same<T, unsigned char>::value,
-                                          sizeof(T) < sizeof(long long)> = traits::sfinae> inline
-      void loadValue( T & value )
-      {
-        value = static_cast<T>( std::stoul( itsNodes.top().node->value() ) );
-      }
-
-      //! Loads a type best represented as an unsigned long long from the current top node
-      template <class T, traits::EnableIf<std::is_unsigned<T>::value,
-                                          !std::is_same<T, bool>::value,
-                                          sizeof(T) >= sizeof(long long)> = traits::sfinae> inline
-      void loadValue( T & value )
-      {
-        value = static_cast<T>( std::stoull( itsNodes.top().node->value() ) );
-      }
-
-      //! Loads a type best represented as an int from the current top node
-      template <class T, traits::EnableIf<std::is_signed<T>::value,
-                                          !std::is_same<T, char>::value,
-                                          sizeof(T) <= sizeof(int)> = traits::sfinae> inline
-      void loadValue( T & value )
-      {
-        value = static_cast<T>( std::stoi( itsNodes.top().node->value() ) );
-      }
-
-      //! Loads a type best represented as a long from the current top node
-      template <class T, traits::EnableIf<std::is_signed<T>::value,
-                                          (sizeof(T) > sizeof(int)),
-                                          sizeof(T) <= sizeof(long)> = traits::sfinae> inline
+                                          !std::is_same<T, unsigned char>::value> = traits::sfinae> inline
       void loadValue( T & value )
       {
-        value = static_cast<T>( std::stol( itsNodes.top().node->value() ) );
+        value = xml_detail::parseInteger<T>( itsNodes.top().node->value(), itsNodes.top().node->value_size() );
       }
 
-      //! Loads a type best represented as a long long from the current top node
+      //! Loads a signed integer from the current top node
       template <class T, traits::EnableIf<std::is_signed<T>::value,
-                                          (sizeof(T) > sizeof(long)),
-                                          sizeof(T) <= sizeof(long long)> = traits::sfinae> inline
+                                          std::is_integral<T>::value,
+                                          !std::is_same<T, char>::value> = traits::sfinae> inline
       void loadValue( T & value )
       {
-        value = static_cast<T>( std::stoll( itsNodes.top().node->value() ) );
+        value = xml_detail::parseInteger<T>( itsNodes.top().node->value(), itsNodes.top().node->value_size() );
       }
 
       //! Loads a type best represented as a float from the current top node
       void loadValue( float & value )
       {
-        try
-        {
-          value = std::stof( itsNodes.top().node->value() );
-        }
-        catch( std::out_of_range const & )
-        {
-          // special case for denormalized values
-          std::istringstream is( itsNodes.top().node->value() );
-          is >> value;
-          if( std::fpclassify( value ) != FP_SUBNORMAL )
-            throw;
-        }
+        value = xml_detail::parseFloatingPoint<float>( itsNodes.top().node->value(), itsNodes.top().node->value_size() );
       }
 
       //! Loads a type best represented as a double from the current top node
       void loadValue( double & value )
       {
-        try
-        {
-          value = std::stod( itsNodes.top().node->value() );
-        }
-        catch( std::out_of_range const & )
-        {
-          // special case for denormalized values
-          std::istringstream is( itsNodes.top().node->value() );
-          is >> value;
-          if( std::fpclassify( value ) != FP_SUBNORMAL )
-            throw;
-        }
+        value = xml_detail::parseFloatingPoint<double>( itsNodes.top().node->value(), itsNodes.top().node->value_size() );
       }
 
       //! Loads a type best represented as a long double from the current top node
       void loadValue( long double & value )
       {
-        try
-        {
-          value = std::stold( itsNodes.top().node->value() );
-        }
-        catch( std::out_of_range const & )
-        {
-          // special case for denormalized values
-          std::istringstream is( itsNodes.top().node->value() );
-          is >> value;
-          if( std::fpclassify( value ) != FP_SUBNORMAL )
-            throw;
-        }
+        value = xml_detail::parseFloatingPoint<long double>( itsNodes.top().node->value(), itsNodes.top().node->value_size() );
       }
 
       //! Loads a string from the current node from the current top node
       template<class CharT, class Traits, class Alloc> inline
       void loadValue( std::basic_string<CharT, Traits, Alloc> & str )
       {
-        std::basic_istringstream<CharT, Traits> is( itsNodes.top().node->value() );
-
-        str.assign( std::istreambuf_iterator<CharT, Traits>( is ),
-                    std::istreambuf_iterator<CharT, Traits>() );
+        str.assign( itsNodes.top().node->value(), itsNodes.top().node->value_size() );
       }
 
       //! Loads the size of the current top node
@@ -636,7 +1302,55 @@ namespace cereal
         value = getNumChildren( itsNodes.top().node );
       }
 
+      //! Loads a vector of arithmetic values if the current node holds them as a compact block
+      /*! See XMLOutputArchive::saveArithmeticBlock
+          @return false, without loading anything, if the node holds its values individually */
+      template <class T, class A> inline
+      bool loadArithmeticBlock( std::vector<T, A> & vector )
+      {
+        auto const node = itsNodes.top().node;
+        auto const encoding = node->first_attribute( "encoding" );
+        if( !encoding )
+          return false;
+
+        if( std::strcmp( encoding->value(), "base64" ) != 0 )
+          throw Exception( std::string("Unknown encoding for a block of arithmetic values: ") + encoding->value() );
+
+        auto const size = base64::decoded_size( node->value(), node->value_size() );
+        if( size % sizeof(T) != 0 )
+          throw Exception("Decoded block size is not a multiple of the value size");
+
+        vector.resize( size / sizeof(T) );
+        if( !parallel_detail::decode_base64( itsPool, itsChunkSize, node->value(), node->value_size(), reinterpret_cast<unsigned char *>( vector.data() ), size ) )
+          throw Exception("Invalid base64 data in a block of arithmetic values");
+
+        if( !detail::is_little_endian() )
+          detail::swap_bytes( vector.data(), sizeof(T), vector.size() );
+
+        return true;
+      }
+
     protected:
+      //! Parses a null terminated document in place and locates the cereal root node
+      void parse( char * data )
+      {
+        try
+        {
+          itsXML.parse<rapidxml::parse_trim_whitespace | rapidxml::parse_no_data_nodes | rapidxml::parse_declaration_node>( data );
+        }
+        catch( rapidxml::parse_error const & )
+        {
+          throw Exception("XML Parsing failed - likely due to invalid characters or invalid naming");
+        }
+
+        // Parse the root
+        auto root = itsXML.first_node( xml_detail::CEREAL_XML_STRING );
+        if( root == nullptr )
+          throw Exception("Could not detect cereal root node - likely due to empty or invalid input");
+        else
+          itsNodes.emplace( root );
+      }
+
       //! Gets the number of children (usually interpreted as size) for the specified node
       static size_t getNumChildren( rapidxml::xml_node<> * node )
       {
@@ -710,8 +1424,10 @@ namespace cereal
       //! @}
 
     private:
-      std::vector<char> itsData;       //!< The raw data loaded
-      rapidxml::xml_document<> itsXML; //!< The XML document
+      XMLContext::Lease itsLease;         //!< The context in use, if any
+      std::vector<char> itsData;          //!< The raw data loaded, unless parsing a caller owned buffer or using a context
+      rapidxml::xml_document<> itsOwnXML; //!< The XML document when not using a context
+      rapidxml::xml_document<> & itsXML;  //!< The XML document
       std::stack<NodeInfo> itsNodes;   //!< A stack of nodes read from the document
   };
 
@@ -868,6 +1584,7 @@ namespace cereal
   template<class CharT, class Traits, class Alloc> inline
   void CEREAL_LOAD_FUNCTION_NAME(XMLInputArchive & ar, std::basic_string<CharT, Traits, Alloc> & str)
   {
+    detail::adopt_memory_resource( ar, str );
     ar.loadValue( str );
   }
 } // namespace cereal
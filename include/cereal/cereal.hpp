@@ -42,10 +42,25 @@
 #include <cereal/macros.hpp>
 #include <cereal/details/traits.hpp>
 #include <cereal/details/helpers.hpp>
+#include <cereal/details/memory_resource.hpp>
 #include <cereal/types/base_class.hpp>
 
+#ifdef CEREAL_ENABLE_STATISTICS
+#include <cereal/details/statistics.hpp>
+#endif // CEREAL_ENABLE_STATISTICS
+
+#ifdef CEREAL_ENABLE_TRACING
+#include <cereal/details/trace.hpp>
+#endif // CEREAL_ENABLE_TRACING
+
 namespace cereal
 {
+  // Archives keep pointers to these whether or not the hooks recording into them are
+  // compiled in, so that their layout does not depend on CEREAL_ENABLE_STATISTICS or
+  // CEREAL_ENABLE_TRACING
+  class Statistics;
+  class Tracer;
+
   // ######################################################################
   //! Creates a name value pair
   /*! @relates NameValuePair
@@ -279,6 +294,22 @@ namespace cereal
 
       //! @}
 
+      //! Records statistics for everything serialized from now on, or stops recording if null
+      /*! Nothing is recorded unless CEREAL_ENABLE_STATISTICS is defined.  The statistics
+          must outlive the archive or be detached first. */
+      void setStatistics( Statistics * statistics )
+      {
+        itsStatistics = statistics;
+      }
+
+      //! Traces everything serialized from now on, or stops tracing if null
+      /*! Nothing is traced unless CEREAL_ENABLE_TRACING is defined.  The tracer must
+          outlive the archive or be detached first. */
+      void setTracer( Tracer * tracer )
+      {
+        itsTracer = tracer;
+      }
+
       //! Registers a shared pointer with the archive
       /*! This function is used to track shared pointer targets to prevent
           unnecessary saves from taking place if multiple shared pointers
@@ -297,12 +328,30 @@ namespace cereal
         {
           auto ptrId = itsCurrentPointerId++;
           itsSharedPointerMap.insert( {addr, ptrId} );
+          if( !itsFrameMarks.empty() )
+            itsFramedPointers.push_back( addr );
           return ptrId | detail::msb_32bit; // mask MSB to be 1
         }
         else
           return id->second;
       }
 
+      //! Checks whether a shared pointer target has already been saved by this archive
+      /*! @internal */
+      inline bool isSharedPointerRegistered( void const * addr ) const
+      {
+        return itsSharedPointerMap.count( addr ) != 0;
+      }
+
+      //! Calls f( addr ) for the address of every shared pointer target saved so far
+      /*! @internal */
+      template <class F> inline
+      void forEachSharedPointer( F && f ) const
+      {
+        for( auto const & entry : itsSharedPointerMap )
+          f( entry.first );
+      }
+
       //! Registers a polymorphic type name with the archive
       /*! This function is used to track polymorphic types to prevent
           unnecessary saves of identifying strings used by the polymorphic
@@ -318,17 +367,59 @@ namespace cereal
         {
           auto polyId = itsCurrentPolymorphicTypeId++;
           itsPolymorphicTypeMap.insert( {name, polyId} );
+          if( !itsFrameMarks.empty() )
+            itsFramedPolymorphicTypes.push_back( name );
           return polyId | detail::msb_32bit; // mask MSB to be 1
         }
         else
           return id->second;
       }
 
+      //! Whether this archive frames the objects of versioned classes
+      /*! Archives that frame objects prefix each of them with its size, written by
+          beginVersionedObject and endVersionedObject, so that readers can skip
+          whatever they do not understand.  By default nothing is framed.
+
+          @internal */
+      bool framesVersionedObjects() const { return false; }
+
+      //! Starts the frame of a versioned object
+      /*! @internal */
+      void beginVersionedObject() { }
+
+      //! Finishes the frame of a versioned object
+      /*! @param pinned Whether the frame holds the first copy of a pointer target, polymorphic
+                        type name or class version, see detail::frame_pinned_flag
+          @internal */
+      void endVersionedObject( bool /*pinned*/ ) { }
+
+      //! Whether this archive queues the targets of shared pointers
+      /*! Archives that queue targets save each one after the object holding the first
+          pointer to it, instead of where that pointer is saved, which keeps the depth of
+          recursion constant for long chains of pointers.  By default nothing is queued.
+
+          @internal */
+      bool queuesPointees() const { return false; }
+
+      //! Saves the target of a shared pointer once the queue of targets reaches it
+      /*! @internal */
+      void queuePointee( std::function<void()> save )
+      {
+        itsPointees.push( std::move( save ) );
+      }
+
     private:
       //! Serializes data after calling prologue, then calls epilogue
       template <class T> inline
       void process( T && head )
       {
+        #ifdef CEREAL_ENABLE_STATISTICS
+        statistics_detail::Scope<T> const statisticsScope( itsStatistics );
+        #endif // CEREAL_ENABLE_STATISTICS
+        #ifdef CEREAL_ENABLE_TRACING
+        trace_detail::Scope<T> const traceScope( itsTracer );
+        #endif // CEREAL_ENABLE_TRACING
+
         prologue( *self, head );
         self->processImpl( head );
         epilogue( *self, head );
@@ -470,9 +561,11 @@ namespace cereal
           version number and serialize that.
 
           @tparam T The type of the class being serialized
-          @param version The version number associated with it */
+          @param framed Whether every object of the class will be framed, which is
+                        recorded alongside the version
+          @return The version number associated with it */
       template <class T> inline
-      std::uint32_t registerClassVersion()
+      std::uint32_t registerClassVersion( bool framed = false )
       {
         static const auto hash = std::type_index(typeid(T)).hash_code();
         const auto insertResult = itsVersionedTypes.insert( hash );
@@ -480,17 +573,86 @@ namespace cereal
           detail::StaticObject<detail::Versions>::getInstance().find( hash, detail::Version<T>::version );
 
         if( insertResult.second ) // insertion took place, serialize the version number
-          process( make_nvp<ArchiveType>("cereal_class_version", version) );
+        {
+          if( !itsFrameMarks.empty() )
+            itsFramedVersionedTypes.push_back( hash );
+
+          if( !framed )
+            process( make_nvp<ArchiveType>("cereal_class_version", version) );
+          else if( version & detail::framed_version_flag )
+            throw Exception("Class versions of framed objects must be below 2^31");
+          else
+            process( make_nvp<ArchiveType>("cereal_class_version", version | detail::framed_version_flag) );
+        }
 
         return version;
       }
 
+      //! Serializes a versioned object, within a frame if the archive frames objects
+      /*! @param save Called with the class version to serialize the object itself */
+      template <class T, class Save> inline
+      void saveVersioned( Save && save )
+      {
+        if( self->framesVersionedObjects() )
+        {
+          const auto version = registerClassVersion<T>( true );
+          self->beginVersionedObject();
+          beginFrameTracking();
+          save( version );
+          self->endVersionedObject( endFrameTracking() );
+        }
+        else
+          save( registerClassVersion<T>() );
+      }
+
+      //! Starts recording what is first saved within a frame
+      void beginFrameTracking()
+      {
+        itsFrameMarks.push_back( { itsFramedPointers.size(), itsFramedPolymorphicTypes.size(), itsFramedVersionedTypes.size() } );
+      }
+
+      //! Stops recording what is first saved within a frame, forgetting all of it after the outermost frame
+      /*! Forgetting makes each outermost frame self-contained: anything first saved within it
+          is saved in full again the next time it is seen, so readers that skip the frame stay
+          in step.  The input archive forgets the same things when it finishes the frame.
+
+          @return Whether anything was first saved within the frame */
+      bool endFrameTracking()
+      {
+        auto const mark = itsFrameMarks.back();
+        itsFrameMarks.pop_back();
+
+        bool const pinned = mark.pointers != itsFramedPointers.size() ||
+                            mark.polymorphicTypes != itsFramedPolymorphicTypes.size() ||
+                            mark.versionedTypes != itsFramedVersionedTypes.size();
+
+        if( itsFrameMarks.empty() )
+        {
+          for( auto addr : itsFramedPointers )
+            itsSharedPointerMap.erase( addr );
+          for( auto name : itsFramedPolymorphicTypes )
+            itsPolymorphicTypeMap.erase( name );
+          for( auto hash : itsFramedVersionedTypes )
+            itsVersionedTypes.erase( hash );
+
+          // ids are handed out in order, so those given out within the frame are the newest
+          itsCurrentPointerId -= static_cast<std::uint32_t>( itsFramedPointers.size() );
+          itsCurrentPolymorphicTypeId -= static_cast<std::uint32_t>( itsFramedPolymorphicTypes.size() );
+
+          itsFramedPointers.clear();
+          itsFramedPolymorphicTypes.clear();
+          itsFramedVersionedTypes.clear();
+        }
+
+        return pinned;
+      }
+
       //! Member serialization
       /*! Versioning implementation */
       template <class T, PROCESS_IF(member_versioned_serialize)> inline
       ArchiveType & processImpl(T const & t)
       {
-        access::member_serialize(*self, const_cast<T &>(t), registerClassVersion<T>());
+        saveVersioned<T>( [&]( std::uint32_t version ){ access::member_serialize(*self, const_cast<T &>(t), version); } );
         return *self;
       }
 
@@ -499,7 +661,7 @@ namespace cereal
       template <class T, PROCESS_IF(non_member_versioned_serialize)> inline
       ArchiveType & processImpl(T const & t)
       {
-        CEREAL_SERIALIZE_FUNCTION_NAME(*self, const_cast<T &>(t), registerClassVersion<T>());
+        saveVersioned<T>( [&]( std::uint32_t version ){ CEREAL_SERIALIZE_FUNCTION_NAME(*self, const_cast<T &>(t), version); } );
         return *self;
       }
 
@@ -508,7 +670,7 @@ namespace cereal
       template <class T, PROCESS_IF(member_versioned_save)> inline
       ArchiveType & processImpl(T const & t)
       {
-        access::member_save(*self, t, registerClassVersion<T>());
+        saveVersioned<T>( [&]( std::uint32_t version ){ access::member_save(*self, t, version); } );
         return *self;
       }
 
@@ -517,7 +679,7 @@ namespace cereal
       template <class T, PROCESS_IF(non_member_versioned_save)> inline
       ArchiveType & processImpl(T const & t)
       {
-        CEREAL_SAVE_FUNCTION_NAME(*self, t, registerClassVersion<T>());
+        saveVersioned<T>( [&]( std::uint32_t version ){ CEREAL_SAVE_FUNCTION_NAME(*self, t, version); } );
         return *self;
       }
 
@@ -541,6 +703,20 @@ namespace cereal
 
     #undef PROCESS_IF
 
+    protected:
+      //! Forgets the pointers, polymorphic types, base classes and class versions serialized so far
+      /*! Archives that write several independent documents to one stream call this between
+          documents, so that each of them can be loaded on its own */
+      void resetTracking()
+      {
+        itsBaseClassSet.clear();
+        itsSharedPointerMap.clear();
+        itsCurrentPointerId = 1;
+        itsPolymorphicTypeMap.clear();
+        itsCurrentPolymorphicTypeId = 1;
+        itsVersionedTypes.clear();
+      }
+
     private:
       ArchiveType * const self;
 
@@ -561,6 +737,34 @@ namespace cereal
 
       //! Keeps track of classes that have versioning information associated with them
       std::unordered_set<size_type> itsVersionedTypes;
+
+      //! How much had been first saved within frames when each open frame started
+      struct FrameMark
+      {
+        std::size_t pointers;
+        std::size_t polymorphicTypes;
+        std::size_t versionedTypes;
+      };
+
+      //! The marks of the open frames, innermost last
+      std::vector<FrameMark> itsFrameMarks;
+
+      //! The shared pointer targets, polymorphic type names and classes first saved within open frames
+      std::vector<void const *> itsFramedPointers;
+      std::vector<char const *> itsFramedPolymorphicTypes;
+      std::vector<size_type> itsFramedVersionedTypes;
+
+      //! The targets of shared pointers waiting to be saved
+      detail::PointeeQueue itsPointees;
+
+      Statistics * itsStatistics = nullptr; //!< Where statistics are recorded, if anywhere
+
+    protected:
+      //! The tracer attached to this archive, for archives that trace their own nodes
+      Tracer * tracer() const { return itsTracer; }
+
+    private:
+      Tracer * itsTracer = nullptr; //!< Where events are traced, if anywhere
   }; // class OutputArchive
 
   // ######################################################################
@@ -634,6 +838,37 @@ namespace cereal
 
       //! @}
 
+      //! Records statistics for everything loaded from now on, or stops recording if null
+      /*! Nothing is recorded unless CEREAL_ENABLE_STATISTICS is defined.  The statistics
+          must outlive the archive or be detached first. */
+      void setStatistics( Statistics * statistics )
+      {
+        itsStatistics = statistics;
+      }
+
+      //! Traces everything serialized from now on, or stops tracing if null
+      /*! Nothing is traced unless CEREAL_ENABLE_TRACING is defined.  The tracer must
+          outlive the archive or be detached first. */
+      void setTracer( Tracer * tracer )
+      {
+        itsTracer = tracer;
+      }
+
+      //! Allocates loaded pointers and containers from the given resource, or from the heap if null
+      /*! The targets of shared pointers are allocated from the resource together with
+          their reference counts.  The resource must outlive everything loaded from it. */
+      void setMemoryResource( MemoryResource * resource )
+      {
+        itsMemoryResource = resource;
+      }
+
+      //! The resource loaded pointers and containers are allocated from, if any
+      /*! @internal */
+      MemoryResource * memoryResource() const
+      {
+        return itsMemoryResource;
+      }
+
       //! Retrieves a shared pointer given a unique key for it
       /*! This is used to retrieve a previously registered shared_ptr
           which has already been loaded.
@@ -660,8 +895,10 @@ namespace cereal
           @param ptr The actual shared pointer */
       inline void registerSharedPointer(std::uint32_t const id, std::shared_ptr<void> ptr)
       {
-        std::uint32_t const stripped_id = id & ~detail::msb_32bit;
+        std::uint32_t const stripped_id = id & ~( detail::msb_32bit | detail::msb2_32bit );
         itsSharedPointerMap[stripped_id] = ptr;
+        if( itsFrameDepth )
+          itsFramedPointers.push_back( stripped_id );
       }
 
       //! Retrieves the string for a polymorphic type given a unique key for it
@@ -690,6 +927,32 @@ namespace cereal
       {
         std::uint32_t const stripped_id = id & ~detail::msb_32bit;
         itsPolymorphicTypeMap.insert( {stripped_id, name} );
+        if( itsFrameDepth )
+          itsFramedPolymorphicTypes.push_back( stripped_id );
+      }
+
+      //! Starts loading the frame of a versioned object
+      /*! Only called for classes whose objects were saved framed.  Archives that
+          support framing replace this.
+
+          @internal */
+      void beginVersionedObject()
+      {
+        throw Exception("This archive cannot load framed objects");
+      }
+
+      //! Finishes loading the frame of a versioned object, skipping whatever was not loaded
+      /*! @internal */
+      void endVersionedObject() { }
+
+      //! Loads the target of a shared pointer once the queue of targets reaches it
+      /*! Targets are queued for pointers that were saved by an archive that queues them,
+          and are loaded in the order they were saved.
+
+          @internal */
+      void queuePointee( std::function<void()> load )
+      {
+        itsPointees.push( std::move( load ) );
       }
 
     private:
@@ -697,6 +960,13 @@ namespace cereal
       template <class T> inline
       void process( T && head )
       {
+        #ifdef CEREAL_ENABLE_STATISTICS
+        statistics_detail::Scope<T> const statisticsScope( itsStatistics );
+        #endif // CEREAL_ENABLE_STATISTICS
+        #ifdef CEREAL_ENABLE_TRACING
+        trace_detail::Scope<T> const traceScope( itsTracer );
+        #endif // CEREAL_ENABLE_TRACING
+
         prologue( *self, head );
         self->processImpl( head );
         epilogue( *self, head );
@@ -847,21 +1117,68 @@ namespace cereal
           @param version The version number associated with it */
       template <class T> inline
       std::uint32_t loadClassVersion()
+      {
+        return loadClassVersion<T>( nullptr );
+      }
+
+      //! Loads a class version, reporting whether objects of that class were saved framed
+      template <class T> inline
+      std::uint32_t loadClassVersion( bool * framed )
       {
         static const auto hash = std::type_index(typeid(T)).hash_code();
         auto lookupResult = itsVersionedTypes.find( hash );
 
+        std::uint32_t version;
         if( lookupResult != itsVersionedTypes.end() ) // already exists
-          return lookupResult->second;
+          version = lookupResult->second;
         else // need to load
         {
-          std::uint32_t version;
-
           process( make_nvp<ArchiveType>("cereal_class_version", version) );
           itsVersionedTypes.emplace_hint( lookupResult, hash, version );
+          if( itsFrameDepth )
+            itsFramedVersionedTypes.push_back( hash );
+        }
 
-          return version;
+        if( framed )
+          *framed = ( version & detail::framed_version_flag ) != 0;
+        return version & ~detail::framed_version_flag;
+      }
+
+      //! Loads a versioned object, within its frame if it was saved framed
+      /*! @param load Called with the class version to load the object itself */
+      template <class T, class Load> inline
+      void loadVersioned( Load && load )
+      {
+        bool framed;
+        const auto version = loadClassVersion<T>( &framed );
+        if( framed )
+        {
+          self->beginVersionedObject();
+          ++itsFrameDepth;
+          load( version );
+          self->endVersionedObject();
+          if( --itsFrameDepth == 0 )
+            forgetFramed();
         }
+        else
+          load( version );
+      }
+
+      //! Forgets everything first loaded within the outermost frame just finished
+      /*! This mirrors the output archive, which saves anything first saved within an
+          outermost frame in full again the next time it is seen */
+      void forgetFramed()
+      {
+        for( auto id : itsFramedPointers )
+          itsSharedPointerMap.erase( id );
+        for( auto id : itsFramedPolymorphicTypes )
+          itsPolymorphicTypeMap.erase( id );
+        for( auto hash : itsFramedVersionedTypes )
+          itsVersionedTypes.erase( hash );
+
+        itsFramedPointers.clear();
+        itsFramedPolymorphicTypes.clear();
+        itsFramedVersionedTypes.clear();
       }
 
       //! Member serialization
@@ -869,8 +1186,7 @@ namespace cereal
       template <class T, PROCESS_IF(member_versioned_serialize)> inline
       ArchiveType & processImpl(T & t)
       {
-        const auto version = loadClassVersion<T>();
-        access::member_serialize(*self, t, version);
+        loadVersioned<T>( [&]( std::uint32_t version ){ access::member_serialize(*self, t, version); } );
         return *self;
       }
 
@@ -879,8 +1195,7 @@ namespace cereal
       template <class T, PROCESS_IF(non_member_versioned_serialize)> inline
       ArchiveType & processImpl(T & t)
       {
-        const auto version = loadClassVersion<T>();
-        CEREAL_SERIALIZE_FUNCTION_NAME(*self, t, version);
+        loadVersioned<T>( [&]( std::uint32_t version ){ CEREAL_SERIALIZE_FUNCTION_NAME(*self, t, version); } );
         return *self;
       }
 
@@ -889,8 +1204,7 @@ namespace cereal
       template <class T, PROCESS_IF(member_versioned_load)> inline
       ArchiveType & processImpl(T & t)
       {
-        const auto version = loadClassVersion<T>();
-        access::member_load(*self, t, version);
+        loadVersioned<T>( [&]( std::uint32_t version ){ access::member_load(*self, t, version); } );
         return *self;
       }
 
@@ -899,8 +1213,7 @@ namespace cereal
       template <class T, PROCESS_IF(non_member_versioned_load)> inline
       ArchiveType & processImpl(T & t)
       {
-        const auto version = loadClassVersion<T>();
-        CEREAL_LOAD_FUNCTION_NAME(*self, t, version);
+        loadVersioned<T>( [&]( std::uint32_t version ){ CEREAL_LOAD_FUNCTION_NAME(*self, t, version); } );
         return *self;
       }
 
@@ -946,6 +1259,29 @@ namespace cereal
 
       //! Maps from type hash codes to version numbers
       std::unordered_map<std::size_t, std::uint32_t> itsVersionedTypes;
+
+      //! The number of frames currently being loaded
+      std::size_t itsFrameDepth = 0;
+
+      //! The pointer ids, polymorphic type ids and classes first loaded within open frames
+      std::vector<std::uint32_t> itsFramedPointers;
+      std::vector<std::uint32_t> itsFramedPolymorphicTypes;
+      std::vector<std::size_t> itsFramedVersionedTypes;
+
+      //! The targets of shared pointers waiting to be loaded
+      detail::PointeeQueue itsPointees;
+
+      //! Where loaded pointers and containers are allocated, if not the heap
+      MemoryResource * itsMemoryResource = nullptr;
+
+      Statistics * itsStatistics = nullptr; //!< Where statistics are recorded, if anywhere
+
+    protected:
+      //! The tracer attached to this archive, for archives that trace their own nodes
+      Tracer * tracer() const { return itsTracer; }
+
+    private:
+      Tracer * itsTracer = nullptr; //!< Where events are traced, if anywhere
   }; // class InputArchive
 } // namespace cereal
 
@@ -0,0 +1,199 @@
+/*! \file buffers.hpp
+    \brief Stream buffers over memory and over parts of other buffers
+    \ingroup Internal */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_DETAILS_BUFFERS_HPP_
+#define CEREAL_DETAILS_BUFFERS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+namespace cereal
+{
+  namespace detail
+  {
+    //! Reads from a range of memory without copying it
+    class MemoryBuffer : public std::streambuf
+    {
+      public:
+        MemoryBuffer( char const * data, std::size_t size )
+        {
+          char * begin = const_cast<char *>( data );
+          setg( begin, begin, begin + size );
+        }
+    };
+
+    //! Forwards output to another buffer, counting the bytes written
+    class CountingBuffer : public std::streambuf
+    {
+      public:
+        CountingBuffer( std::streambuf * sink ) : itsSink( sink ), itsCount( 0 ) {}
+
+        //! The number of bytes written so far
+        std::uint64_t count() const
+        { return itsCount; }
+
+      protected:
+        std::streamsize xsputn( char const * s, std::streamsize n ) override
+        {
+          auto const written = itsSink->sputn( s, n );
+          itsCount += static_cast<std::uint64_t>( written );
+          return written;
+        }
+
+        int_type overflow( int_type c ) override
+        {
+          if( traits_type::eq_int_type( c, traits_type::eof() ) )
+            return traits_type::not_eof( c );
+          if( traits_type::eq_int_type( itsSink->sputc( traits_type::to_char_type( c ) ), traits_type::eof() ) )
+            return traits_type::eof();
+          ++itsCount;
+          return c;
+        }
+
+        int sync() override
+        { return itsSink->pubsync(); }
+
+      private:
+        std::streambuf * itsSink;
+        std::uint64_t itsCount;
+    };
+
+    //! Reads at most a given number of bytes from another buffer
+    class RangeBuffer : public std::streambuf
+    {
+      public:
+        RangeBuffer( std::streambuf * source, std::uint64_t size ) : itsSource( source ), itsRemaining( size ) {}
+
+        //! The number of bytes of the range not yet read
+        std::uint64_t remaining() const
+        { return itsRemaining; }
+
+      protected:
+        std::streamsize xsgetn( char * s, std::streamsize n ) override
+        {
+          if( static_cast<std::uint64_t>( n ) > itsRemaining )
+            n = static_cast<std::streamsize>( itsRemaining );
+          auto const read = itsSource->sgetn( s, n );
+          itsRemaining -= static_cast<std::uint64_t>( read );
+          return read;
+        }
+
+        int_type underflow() override
+        { return itsRemaining ? itsSource->sgetc() : traits_type::eof(); }
+
+        int_type uflow() override
+        {
+          if( !itsRemaining )
+            return traits_type::eof();
+          auto const c = itsSource->sbumpc();
+          if( !traits_type::eq_int_type( c, traits_type::eof() ) )
+            --itsRemaining;
+          return c;
+        }
+
+      private:
+        std::streambuf * itsSource;
+        std::uint64_t itsRemaining;
+    };
+
+    //! Base for input archives that can share ownership of the stream they read
+    /*! Types that skip over data and load it later, such as Deferred, use the shared
+        stream to do so after the archive is gone */
+    class SharedStreamUser
+    {
+      public:
+        //! Shares ownership of the stream this archive reads, so values can be loaded from it later
+        /*! Deferred values loaded from then on only record where they are in the stream,
+            and read and decode themselves when first accessed, keeping the stream alive
+            until then.  Without a shared stream, or if it is not the one the archive reads
+            or cannot seek, deferred values are read into memory when loaded.
+            @param stream The stream the archive reads, or nullptr */
+        void setSharedStream( std::shared_ptr<std::istream> stream )
+        {
+          itsSharedStream = std::move( stream );
+        }
+
+        //! The shared stream, if any
+        /*! @internal */
+        std::shared_ptr<std::istream> const & sharedStream() const
+        {
+          return itsSharedStream;
+        }
+
+      private:
+        std::shared_ptr<std::istream> itsSharedStream;
+    };
+
+    //! Reads the remainder of a stream into a null terminated buffer
+    /*! When the stream is seekable the buffer is sized up front and filled with a single
+        read, otherwise it is read in growing chunks.  Memory the buffer already holds
+        is reused, which lets text archives keep one buffer across documents.
+        @return The null terminated text, which may be modified in place */
+    inline char * read_stream( std::istream & stream, std::vector<char> & data )
+    {
+      auto buffer = stream.rdbuf();
+
+      std::streamsize chunk = 64 * 1024;
+      auto const start = buffer->pubseekoff( 0, std::ios::cur, std::ios::in );
+      if( start != std::streampos( -1 ) )
+      {
+        auto const end = buffer->pubseekoff( 0, std::ios::end, std::ios::in );
+        buffer->pubseekpos( start, std::ios::in );
+
+        // one extra character lets a single read detect the end of the stream
+        if( end != std::streampos( -1 ) && std::streamoff( end ) > std::streamoff( start ) )
+          chunk = static_cast<std::streamsize>( end - start ) + 1;
+      }
+
+      std::streamsize size = 0;
+      for( ;; )
+      {
+        if( data.size() < static_cast<std::size_t>( size + chunk ) )
+          data.resize( static_cast<std::size_t>( size + chunk ) );
+        auto const read = buffer->sgetn( data.data() + size, chunk );
+        size += read;
+
+        if( read < chunk )
+          break;
+
+        chunk = size; // grow geometrically
+      }
+
+      data.resize( static_cast<std::size_t>( size ) + 1 );
+      data.back() = '\0';
+      return data.data();
+    }
+  } // namespace detail
+} // namespace cereal
+
+#endif // CEREAL_DETAILS_BUFFERS_HPP_
@@ -0,0 +1,158 @@
+/*! \file frames.hpp
+    \brief Size prefixed frames written by the binary output archives
+    \ingroup Internal */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_DETAILS_FRAMES_HPP_
+#define CEREAL_DETAILS_FRAMES_HPP_
+
+#include <cereal/details/helpers.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cereal
+{
+  namespace detail
+  {
+    //! The open frames of a binary output archive, each prefixed by its size
+    /*! On a stream that can seek, a placeholder is written where each frame starts and
+        the size is patched in once the frame is finished, so the output goes straight
+        to the stream.  Other streams cannot be patched, so there the outermost frame and
+        everything within it are held in memory until it is finished.  Whether the stream
+        can seek is checked as each outermost frame begins. */
+    class OutputFrames
+    {
+      public:
+        explicit OutputFrames( std::ostream & stream ) : itsStream( stream ), itsInPlace( false ) {}
+
+        //! Whether no frame is open
+        bool empty() const
+        { return itsStarts.empty(); }
+
+        //! Whether output must be given to append rather than written to the stream
+        bool buffering() const
+        { return !itsInPlace && !itsStarts.empty(); }
+
+        //! Adds output to the open frames held in memory
+        void append( const char * data, std::size_t size )
+        {
+          itsBuffer.append( data, size );
+        }
+
+        //! Opens a frame, leaving room for its size
+        void begin()
+        {
+          std::streamoff position = -1;
+          if( itsStarts.empty() )
+          {
+            position = itsStream.rdbuf()->pubseekoff( 0, std::ios::cur, std::ios::out );
+            itsInPlace = position != std::streamoff( -1 );
+          }
+          else if( itsInPlace )
+            position = tell();
+
+          std::uint64_t const placeholder = 0;
+          if( itsInPlace )
+          {
+            itsStarts.push_back( static_cast<std::uint64_t>( position ) );
+            write( &placeholder, sizeof(placeholder) );
+          }
+          else
+          {
+            itsStarts.push_back( itsBuffer.size() );
+            itsBuffer.append( reinterpret_cast<const char *>( &placeholder ), sizeof(placeholder) );
+          }
+        }
+
+        //! Closes the innermost frame, writing its size
+        /*! @param pinned Whether something was first saved within the frame, which is
+                          recorded in the size of nested frames with frame_pinned_flag */
+        void end( bool pinned )
+        {
+          auto const start = itsStarts.back();
+          itsStarts.pop_back();
+
+          std::uint64_t const end = itsInPlace ? static_cast<std::uint64_t>( tell() ) : itsBuffer.size();
+          std::uint64_t size = end - start - sizeof(std::uint64_t);
+          if( pinned && !itsStarts.empty() )
+            size |= frame_pinned_flag;
+
+          if( itsInPlace )
+          {
+            seek( static_cast<std::streamoff>( start ) );
+            write( &size, sizeof(size) );
+            seek( static_cast<std::streamoff>( end ) );
+            return;
+          }
+
+          std::memcpy( &itsBuffer[static_cast<std::size_t>( start )], &size, sizeof(size) );
+          if( itsStarts.empty() )
+          {
+            write( itsBuffer.data(), itsBuffer.size() );
+            itsBuffer.clear();
+          }
+        }
+
+      private:
+        //! The current position in the stream
+        std::streamoff tell()
+        {
+          auto const position = itsStream.rdbuf()->pubseekoff( 0, std::ios::cur, std::ios::out );
+          if( position == std::streamoff( -1 ) )
+            throw Exception("Failed to find the position of a frame in the output stream");
+          return position;
+        }
+
+        //! Moves to a position in the stream
+        void seek( std::streamoff position )
+        {
+          if( itsStream.rdbuf()->pubseekpos( position, std::ios::out ) == std::streampos( -1 ) )
+            throw Exception("Failed to seek the output stream to write the size of a frame");
+        }
+
+        //! Writes to the stream, throwing if not everything is written
+        void write( const void * data, std::size_t size )
+        {
+          auto const writtenSize = static_cast<std::size_t>( itsStream.rdbuf()->sputn( reinterpret_cast<const char*>( data ), static_cast<std::streamsize>( size ) ) );
+
+          if(writtenSize != size)
+            throw Exception("Failed to write " + std::to_string(size) + " bytes to output stream! Wrote " + std::to_string(writtenSize));
+        }
+
+        std::ostream & itsStream;
+        bool itsInPlace;                      //!< Whether the open frames are patched in the stream rather than held in memory
+        std::string itsBuffer;                //!< The open frames, if held in memory
+        std::vector<std::uint64_t> itsStarts; //!< Where each open frame starts, in the stream or in itsBuffer
+    };
+  } // namespace detail
+} // namespace cereal
+
+#endif // CEREAL_DETAILS_FRAMES_HPP_
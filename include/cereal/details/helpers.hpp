@@ -36,6 +36,9 @@
 #include <memory>
 #include <unordered_map>
 #include <stdexcept>
+#include <vector>
+#include <functional>
+#include <mutex>
 
 #include <cereal/macros.hpp>
 #include <cereal/details/static_object.hpp>
@@ -235,6 +238,88 @@ namespace cereal
     // used during saving pointers
     static const int32_t msb_32bit  = 0x80000000;
     static const int32_t msb2_32bit = 0x40000000;
+
+    //! Set in a saved class version when every object of that class is framed
+    static const std::uint32_t framed_version_flag = 0x80000000;
+
+    //! Set in the saved size of a nested frame that holds the first copy of something referred to later
+    /*! Pointer targets, polymorphic type names, class versions and interned strings are only
+        saved the first time they are seen.  A frame nested in another that holds such a first
+        copy cannot be skipped, as whatever follows it in the outer frame may refer to it.
+        Outermost frames never have this set, as archives forget everything first saved within
+        them once they are finished. */
+    static const std::uint64_t frame_pinned_flag = std::uint64_t( 1 ) << 63;
+
+    // ######################################################################
+    //! A queue of pointer targets waiting to be saved or loaded
+    /*! Archives that queue the targets of shared pointers keep one of these.  A target
+        queued while the queue is idle is processed right away, along with everything
+        queued while processing it, so chains of pointers of any length are handled
+        breadth first at a constant depth of recursion.
+        @internal */
+    class PointeeQueue
+    {
+      public:
+        PointeeQueue() : itsNext( 0 ), itsProcessing( false ) {}
+
+        //! Queues a target, processing the queue if it is not already being processed
+        void push( std::function<void()> process )
+        {
+          itsPending.push_back( std::move( process ) );
+          if( itsProcessing )
+            return;
+
+          itsProcessing = true;
+          try
+          {
+            while( itsNext != itsPending.size() )
+            {
+              auto next = std::move( itsPending[itsNext++] );
+
+              // drop processed entries once they make up half of the queue
+              if( itsNext * 2 > itsPending.size() && itsNext >= 1024 )
+              {
+                itsPending.erase( itsPending.begin(), itsPending.begin() + static_cast<std::ptrdiff_t>( itsNext ) );
+                itsNext = 0;
+              }
+
+              next();
+            }
+          }
+          catch( ... )
+          {
+            itsPending.clear();
+            itsNext = 0;
+            itsProcessing = false;
+            throw;
+          }
+
+          itsPending.clear();
+          itsNext = 0;
+          itsProcessing = false;
+        }
+
+      private:
+        std::vector<std::function<void()>> itsPending; //!< Targets in the order they were queued
+        std::size_t itsNext;                           //!< The first target not yet processed
+        bool itsProcessing;
+    };
+
+    //! Returns true if the current machine is little endian
+    inline bool is_little_endian()
+    {
+      static std::int32_t test = 1;
+      return *reinterpret_cast<std::int8_t*>( &test ) == 1;
+    }
+
+    //! Reverses the byte order of count consecutive values that are each size bytes large
+    inline void swap_bytes( void * data, std::size_t size, std::size_t count )
+    {
+      auto bytes = static_cast<std::uint8_t*>( data );
+      for( std::size_t i = 0; i < count; ++i, bytes += size )
+        for( std::size_t j = 0, k = size - 1; j < k; ++j, --k )
+          std::swap( bytes[j], bytes[k] );
+    }
   }
 
   // ######################################################################
@@ -344,12 +429,16 @@ namespace cereal
     };
 
     //! Holds all registered version information
+    /*! Types without CEREAL_CLASS_VERSION are added on first use, which may happen on
+        several threads at once, for example when saving parallel containers */
     struct Versions
     {
       std::unordered_map<std::size_t, std::uint32_t> mapping;
+      std::mutex mutex;
 
       std::uint32_t find( std::size_t hash, std::uint32_t version )
       {
+        std::lock_guard<std::mutex> lock( mutex );
         const auto result = mapping.emplace( hash, version );
         return result.first->second;
       }
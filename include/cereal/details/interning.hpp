@@ -0,0 +1,143 @@
+/*! \file interning.hpp
+    \brief Tables of repeated strings for binary archives
+    \ingroup Internal */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_DETAILS_INTERNING_HPP_
+#define CEREAL_DETAILS_INTERNING_HPP_
+
+#include <cereal/details/helpers.hpp>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cereal
+{
+  namespace detail
+  {
+    //! Set in the size of a string that will be referred to by later copies of it
+    static const size_type interned_string_flag = size_type( 1 ) << ( sizeof(size_type) * 8 - 2 );
+
+    //! Set in place of the size of a string that is a copy of an earlier one, whose id follows in the other bits
+    static const size_type interned_reference_flag = size_type( 1 ) << ( sizeof(size_type) * 8 - 1 );
+
+    // ######################################################################
+    //! Remembers the strings an output archive has written, so that repeats can refer to them
+    /*! Strings are compared by their bytes, so the table serves strings of every character type.
+        Only strings up to a maximum length are remembered, which bounds the memory used
+        by each entry and keeps long, usually unique strings out of the table. */
+    class OutputStringTable
+    {
+      public:
+        //! Construct a table that remembers strings of at most maxBytes bytes, or none if 0
+        explicit OutputStringTable( std::size_t maxBytes = 0 ) : itsMaxBytes( maxBytes )
+        { }
+
+        //! Looks up a string about to be written
+        /*! @return interned_reference_flag and the id of an identical earlier string if there is one,
+                    interned_string_flag if the string was added to the table, or 0 if it is
+                    written without being remembered */
+        size_type intern( const void * data, std::size_t size )
+        {
+          if( size == 0 || size > itsMaxBytes ) // empty strings are no smaller as references
+            return 0;
+
+          auto const inserted = itsIds.emplace( std::string( static_cast<const char *>( data ), size ), itsIds.size() );
+          if( !inserted.second )
+            return interned_reference_flag | inserted.first->second;
+
+          itsStrings.push_back( &inserted.first->first );
+          return interned_string_flag;
+        }
+
+        //! The longest string remembered, in bytes
+        std::size_t maxBytes() const
+        {
+          return itsMaxBytes;
+        }
+
+        //! The number of strings remembered so far
+        std::size_t size() const
+        {
+          return itsStrings.size();
+        }
+
+        //! Forgets every string remembered after the first count
+        void forget( std::size_t count )
+        {
+          for( auto i = count; i < itsStrings.size(); ++i )
+            itsIds.erase( itsIds.find( *itsStrings[i] ) );
+          itsStrings.resize( std::min( count, itsStrings.size() ) );
+        }
+
+      private:
+        std::size_t itsMaxBytes;
+        std::unordered_map<std::string, size_type> itsIds; //!< Maps the bytes of each remembered string to its id
+        std::vector<std::string const *> itsStrings;       //!< The keys of itsIds, indexed by id
+    };
+
+    // ######################################################################
+    //! Keeps the strings an input archive has read that later copies may refer to
+    class InputStringTable
+    {
+      public:
+        //! Remembers a string that was saved with interned_string_flag, giving it the next id
+        void intern( const void * data, std::size_t size )
+        {
+          itsStrings.emplace_back( static_cast<const char *>( data ), size );
+        }
+
+        //! The bytes of the string with the given id
+        /*! @throw Exception if no string has that id */
+        std::string const & find( size_type id ) const
+        {
+          if( id >= itsStrings.size() )
+            throw Exception("Error while trying to load an interned string. Could not find id " + std::to_string( id ));
+
+          return itsStrings[static_cast<std::size_t>( id )];
+        }
+
+        //! The number of strings remembered so far
+        std::size_t size() const
+        {
+          return itsStrings.size();
+        }
+
+        //! Forgets every string remembered after the first count
+        void forget( std::size_t count )
+        {
+          itsStrings.resize( std::min( count, itsStrings.size() ) );
+        }
+
+      private:
+        std::vector<std::string> itsStrings; //!< The bytes of each remembered string, indexed by id
+    };
+  } // namespace detail
+} // namespace cereal
+
+#endif // CEREAL_DETAILS_INTERNING_HPP_
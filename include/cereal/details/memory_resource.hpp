@@ -0,0 +1,323 @@
+/*! \file memory_resource.hpp
+    \brief Sources of memory that archives load pointers and containers into
+    \ingroup Utility */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_DETAILS_MEMORY_RESOURCE_HPP_
+#define CEREAL_DETAILS_MEMORY_RESOURCE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cereal
+{
+  // ######################################################################
+  //! A source of memory that input archives can load into
+  /*! An input archive given a resource through setMemoryResource allocates the targets
+      of loaded shared pointers from it, each together with its reference count in a
+      single allocation.  The resource must outlive everything loaded from it.
+
+      @ingroup Utility */
+  class MemoryResource
+  {
+    public:
+      virtual ~MemoryResource() = default;
+
+      //! Allocates size bytes aligned to alignment, throwing std::bad_alloc on failure
+      virtual void * allocate( std::size_t size, std::size_t alignment ) = 0;
+
+      //! Returns memory obtained from allocate with the same size and alignment
+      virtual void deallocate( void * ptr, std::size_t size, std::size_t alignment ) = 0;
+  };
+
+  // ######################################################################
+  //! A memory resource that hands out memory from large blocks and frees it all at once
+  /*! Deallocation does nothing; everything is released together when the resource is
+      released or destroyed.  This suits decoding a whole message into one arena and
+      dropping it in one step.
+
+      @code{.cpp}
+      cereal::MonotonicMemoryResource arena;
+      {
+        cereal::BinaryInputArchive iar( stream );
+        iar.setMemoryResource( &arena );
+        iar( message );
+      }
+      // use message, then destroy it before arena
+      @endcode
+
+      @ingroup Utility */
+  class MonotonicMemoryResource : public MemoryResource
+  {
+    public:
+      //! Construct, allocating blocks of at least blockSize bytes as they are needed
+      explicit MonotonicMemoryResource( std::size_t blockSize = 64 * 1024 ) :
+        itsBlockSize( blockSize ),
+        itsCurrent( nullptr ),
+        itsRemaining( 0 )
+      { }
+
+      MonotonicMemoryResource( MonotonicMemoryResource const & ) = delete;
+      MonotonicMemoryResource & operator=( MonotonicMemoryResource const & ) = delete;
+
+      ~MonotonicMemoryResource()
+      {
+        release();
+      }
+
+      void * allocate( std::size_t size, std::size_t alignment ) override
+      {
+        auto const address = reinterpret_cast<std::uintptr_t>( itsCurrent );
+        auto const padding = ( alignment - address % alignment ) % alignment;
+
+        if( itsCurrent == nullptr || padding + size > itsRemaining )
+        {
+          auto const blockSize = std::max( itsBlockSize, size + alignment );
+          itsBlocks.push_back( ::operator new( blockSize ) );
+          itsCurrent = static_cast<char *>( itsBlocks.back() );
+          itsRemaining = blockSize;
+          return allocate( size, alignment );
+        }
+
+        void * ptr = itsCurrent + padding;
+        itsCurrent += padding + size;
+        itsRemaining -= padding + size;
+        return ptr;
+      }
+
+      void deallocate( void *, std::size_t, std::size_t ) override
+      { }
+
+      //! Frees every block, invalidating everything allocated so far
+      void release()
+      {
+        for( auto block : itsBlocks )
+          ::operator delete( block );
+
+        itsBlocks.clear();
+        itsCurrent = nullptr;
+        itsRemaining = 0;
+      }
+
+    private:
+      std::size_t itsBlockSize;
+      std::vector<void *> itsBlocks; //!< Every block allocated so far
+      char * itsCurrent;             //!< The next free byte of the newest block
+      std::size_t itsRemaining;      //!< The free bytes left in the newest block
+  };
+
+  // ######################################################################
+  //! The resource used by allocators not given one, which allocates from the heap
+  /*! @ingroup Utility */
+  inline MemoryResource * default_memory_resource() noexcept
+  {
+    struct HeapMemoryResource : public MemoryResource
+    {
+      void * allocate( std::size_t size, std::size_t ) override
+      {
+        return ::operator new( size );
+      }
+
+      void deallocate( void * ptr, std::size_t, std::size_t ) override
+      {
+        ::operator delete( ptr );
+      }
+    };
+
+    static HeapMemoryResource resource;
+    return &resource;
+  }
+
+  namespace detail
+  {
+    //! Whether T is constructed by passing alloc after its other constructor arguments
+    template <class T, class Alloc, class ... Args>
+    struct uses_trailing_allocator : std::integral_constant<bool,
+      std::uses_allocator<T, Alloc>::value && std::is_constructible<T, Args..., Alloc const &>::value> {};
+
+    //! Constructs a T at ptr, passing it alloc if it is allocator-aware
+    /*! @internal */
+    template <class T, class Alloc, class ... Args> inline
+    typename std::enable_if<uses_trailing_allocator<T, Alloc, Args...>::value>::type
+    construct_with_allocator( T * ptr, Alloc const & alloc, Args && ... args )
+    {
+      ::new (static_cast<void *>( ptr )) T( std::forward<Args>( args )..., alloc );
+    }
+
+    //! Constructs a T at ptr, passing it alloc if it is allocator-aware
+    /*! @internal */
+    template <class T, class Alloc, class ... Args> inline
+    typename std::enable_if<!uses_trailing_allocator<T, Alloc, Args...>::value>::type
+    construct_with_allocator( T * ptr, Alloc const &, Args && ... args )
+    {
+      ::new (static_cast<void *>( ptr )) T( std::forward<Args>( args )... );
+    }
+
+    //! Makes an empty T that allocates with alloc if it is allocator-aware
+    /*! Loaders use this for the temporaries they move into a container, so that
+        what the temporaries allocate comes from the container's resource.
+        @internal */
+    template <class T, class Alloc> inline
+    typename std::enable_if<uses_trailing_allocator<T, Alloc>::value, T>::type
+    make_with_allocator( Alloc const & alloc )
+    {
+      return T( alloc );
+    }
+
+    //! Makes an empty T that allocates with alloc if it is allocator-aware
+    /*! @internal */
+    template <class T, class Alloc> inline
+    typename std::enable_if<!uses_trailing_allocator<T, Alloc>::value, T>::type
+    make_with_allocator( Alloc const & )
+    {
+      return T();
+    }
+  } // namespace detail
+
+  // ######################################################################
+  //! A standard allocator that allocates from a MemoryResource
+  /*! This plays the role of std::pmr::polymorphic_allocator for C++11.  Containers
+      using it are loaded into the archive's memory resource, see MemoryResource.
+
+      Like polymorphic_allocator, it passes itself on to the allocator-aware elements
+      it constructs, so the strings in a vector of strings allocate from the same
+      resource as the vector.  Unlike polymorphic_allocator, it moves and swaps with
+      the container that owns it, so a container moved from one loaded from an arena
+      points into that arena.  Copies use the default resource, or the resource of the
+      container assigned to.
+
+      When an input archive has a resource, containers using this allocator that are
+      still on the default resource are switched to the archive's before loading.
+
+      @ingroup Utility */
+  template <class T>
+  class ResourceAllocator
+  {
+    public:
+      using value_type = T;
+
+      using propagate_on_container_copy_assignment = std::false_type;
+      using propagate_on_container_move_assignment = std::true_type;
+      using propagate_on_container_swap = std::true_type;
+
+      //! Construct, allocating from default_memory_resource()
+      ResourceAllocator() noexcept : itsResource( default_memory_resource() )
+      { }
+
+      //! Construct, allocating from the given resource
+      ResourceAllocator( MemoryResource * resource ) noexcept : itsResource( resource )
+      { }
+
+      template <class U>
+      ResourceAllocator( ResourceAllocator<U> const & other ) noexcept : itsResource( other.resource() )
+      { }
+
+      T * allocate( std::size_t n )
+      {
+        return static_cast<T *>( itsResource->allocate( n * sizeof(T), alignof(T) ) );
+      }
+
+      void deallocate( T * ptr, std::size_t n )
+      {
+        itsResource->deallocate( ptr, n * sizeof(T), alignof(T) );
+      }
+
+      //! Constructs a U at ptr, passing this allocator on if U is allocator-aware
+      template <class U, class ... Args>
+      void construct( U * ptr, Args && ... args )
+      {
+        detail::construct_with_allocator( ptr, *this, std::forward<Args>( args )... );
+      }
+
+      //! A container's copy keeps the default resource rather than sharing this one
+      ResourceAllocator select_on_container_copy_construction() const noexcept
+      {
+        return ResourceAllocator();
+      }
+
+      //! The resource this allocates from
+      MemoryResource * resource() const noexcept
+      {
+        return itsResource;
+      }
+
+    private:
+      MemoryResource * itsResource;
+  };
+
+  template <class T, class U> inline
+  bool operator==( ResourceAllocator<T> const & a, ResourceAllocator<U> const & b ) noexcept
+  {
+    return a.resource() == b.resource();
+  }
+
+  template <class T, class U> inline
+  bool operator!=( ResourceAllocator<T> const & a, ResourceAllocator<U> const & b ) noexcept
+  {
+    return !( a == b );
+  }
+
+  namespace detail
+  {
+    //! Whether A is a ResourceAllocator
+    template <class A>
+    struct is_resource_allocator : std::false_type {};
+
+    template <class T>
+    struct is_resource_allocator<ResourceAllocator<T>> : std::true_type {};
+
+    //! Switches a container that is about to be loaded to the archive's memory resource
+    /*! This only applies to containers using a ResourceAllocator that is still on the
+        default resource; a container given a resource of its own, including one nested
+        in a container that passed its resource on, keeps it.  The container is emptied
+        when it switches, as loading replaces its contents anyway.
+        @internal */
+    template <class Archive, class C> inline
+    typename std::enable_if<is_resource_allocator<typename C::allocator_type>::value>::type
+    adopt_memory_resource( Archive & ar, C & container )
+    {
+      auto resource = ar.memoryResource();
+      if( resource && container.get_allocator().resource() == default_memory_resource() )
+        container = C( typename C::allocator_type( resource ) );
+    }
+
+    //! Containers with other allocators keep them
+    /*! @internal */
+    template <class Archive, class C> inline
+    typename std::enable_if<!is_resource_allocator<typename C::allocator_type>::value>::type
+    adopt_memory_resource( Archive &, C & )
+    { }
+  } // namespace detail
+} // namespace cereal
+
+#endif // CEREAL_DETAILS_MEMORY_RESOURCE_HPP_
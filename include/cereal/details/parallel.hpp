@@ -0,0 +1,332 @@
+/*! \file parallel.hpp
+    \brief A thread pool for transforming large payloads in parallel chunks
+    \ingroup Utility */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_DETAILS_PARALLEL_HPP_
+#define CEREAL_DETAILS_PARALLEL_HPP_
+
+#include <cereal/external/base64.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cereal
+{
+  // ######################################################################
+  //! A fixed set of worker threads that archives can use to transform large payloads
+  /*! Archives that support it are given a pool with setThreadPool.  Contiguous payloads
+      larger than the chunk size given there, such as base64 encoded blocks in JSON and XML
+      or byte swapped arrays in portable binary archives, are then split into chunks that
+      are transformed on the pool, with the calling thread taking part.  The result is
+      identical to transforming the payload on a single thread.
+
+      A pool can be shared by any number of archives and threads.
+
+      @code{.cpp}
+      cereal::ThreadPool pool;
+      cereal::JSONOutputArchive ar( os, cereal::JSONOutputArchive::Options( 17, cereal::JSONOutputArchive::Options::IndentChar::space, 0, true ) );
+      ar.setThreadPool( &pool );
+      ar( CEREAL_NVP(samples) ); // a large std::vector<double>
+      @endcode
+
+      @ingroup Utility */
+  class ThreadPool
+  {
+    public:
+      //! The default number of bytes each chunk of a payload covers
+      static std::size_t defaultChunkSize()
+      { return 1 << 20; }
+
+      //! Starts the given number of worker threads, or one per hardware thread if zero
+      explicit ThreadPool( std::size_t threads = 0 ) :
+        itsStopping( false )
+      {
+        if( threads == 0 )
+          threads = std::max( std::thread::hardware_concurrency(), 1u );
+
+        for( std::size_t i = 0; i < threads; ++i )
+          itsThreads.emplace_back( [this](){ run(); } );
+      }
+
+      //! Finishes any queued tasks and joins the worker threads
+      ~ThreadPool()
+      {
+        {
+          std::lock_guard<std::mutex> lock( itsMutex );
+          itsStopping = true;
+        }
+        itsCondition.notify_all();
+
+        for( auto & thread : itsThreads )
+          thread.join();
+      }
+
+      ThreadPool( ThreadPool const & ) = delete;
+      ThreadPool & operator=( ThreadPool const & ) = delete;
+
+      //! The number of worker threads
+      std::size_t size() const
+      { return itsThreads.size(); }
+
+      //! Queues a task to run on some worker thread
+      /*! Tasks must not throw */
+      void submit( std::function<void()> task )
+      {
+        {
+          std::lock_guard<std::mutex> lock( itsMutex );
+          itsTasks.push_back( std::move( task ) );
+        }
+        itsCondition.notify_one();
+      }
+
+    private:
+      //! The loop run by each worker thread
+      void run()
+      {
+        for( ;; )
+        {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock( itsMutex );
+            itsCondition.wait( lock, [this](){ return itsStopping || !itsTasks.empty(); } );
+            if( itsTasks.empty() )
+              return;
+
+            task = std::move( itsTasks.front() );
+            itsTasks.pop_front();
+          }
+          task();
+        }
+      }
+
+      std::vector<std::thread> itsThreads;
+      std::deque<std::function<void()>> itsTasks;
+      std::mutex itsMutex;
+      std::condition_variable itsCondition;
+      bool itsStopping;
+  };
+
+  namespace detail
+  {
+    //! Base for archives that transform large payloads on a ThreadPool
+    class ThreadPoolUser
+    {
+      public:
+        //! Transforms large payloads in parallel chunks on the given pool
+        /*! What is transformed depends on the archive, see ThreadPool.
+            @param pool The pool to use, or nullptr to work on the calling thread.  It must
+                        outlive the archive or be detached first.
+            @param chunkSize The number of bytes transformed by each task */
+        void setThreadPool( ThreadPool * pool, std::size_t chunkSize = ThreadPool::defaultChunkSize() )
+        {
+          itsPool = pool;
+          itsChunkSize = chunkSize;
+        }
+
+      protected:
+        ThreadPool * itsPool = nullptr; //!< Where large payloads are transformed, if anywhere
+        std::size_t itsChunkSize = ThreadPool::defaultChunkSize();
+    };
+  } // namespace detail
+
+  namespace parallel_detail
+  {
+    //! Calls f( begin, end ) for consecutive chunks covering [0, size), in parallel on pool
+    /*! Chunks are claimed one at a time by the calling thread and by up to one worker
+        per thread in the pool, so uneven chunks balance out, and the call completes even
+        if every worker is busy, for example when called from a task running on the pool.
+        The first exception thrown by f is rethrown once all chunks have finished.
+
+        Without a pool, or with a single chunk, f is called once on the calling thread.
+        @internal */
+    template <class F> inline
+    void for_each_chunk( ThreadPool * pool, std::size_t size, std::size_t chunkSize, F const & f )
+    {
+      chunkSize = std::max<std::size_t>( chunkSize, 1 );
+      std::size_t const chunks = size / chunkSize + ( size % chunkSize ? 1 : 0 );
+
+      if( !pool || pool->size() == 0 || chunks < 2 )
+      {
+        if( size )
+          f( std::size_t( 0 ), size );
+        return;
+      }
+
+      // Shared so that workers that only start once everything is done can still look
+      struct State
+      {
+        std::atomic<std::size_t> next;
+        std::size_t remaining;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+      };
+
+      auto state = std::make_shared<State>();
+      state->next = 0;
+      state->remaining = chunks;
+
+      // f is only used for claimed chunks, all of which finish before this function returns
+      F const * function = &f;
+      auto const work = [state, function, chunks, chunkSize, size]()
+      {
+        for( std::size_t i; ( i = state->next++ ) < chunks; )
+        {
+          std::exception_ptr error;
+          try
+          {
+            (*function)( i * chunkSize, std::min( size, ( i + 1 ) * chunkSize ) );
+          }
+          catch( ... )
+          {
+            error = std::current_exception();
+          }
+
+          std::lock_guard<std::mutex> lock( state->mutex );
+          if( error && !state->error )
+            state->error = error;
+          if( --state->remaining == 0 )
+            state->finished.notify_all();
+        }
+      };
+
+      for( std::size_t i = 0, helpers = std::min( pool->size(), chunks - 1 ); i < helpers; ++i )
+        pool->submit( work );
+
+      work();
+
+      std::unique_lock<std::mutex> lock( state->mutex );
+      state->finished.wait( lock, [&state](){ return state->remaining == 0; } );
+
+      if( state->error )
+        std::rethrow_exception( state->error );
+    }
+
+    //! Base64 encodes size bytes into out, which must have room for base64::encoded_size( size )
+    /*! @internal */
+    inline void encode_base64( ThreadPool * pool, std::size_t chunkSize, unsigned char const * data, std::size_t size, char * out )
+    {
+      // Chunks of whole three byte groups encode independently, without padding
+      chunkSize = std::max<std::size_t>( chunkSize / 3 * 3, 3 );
+      for_each_chunk( pool, size, chunkSize, [=]( std::size_t begin, std::size_t end )
+      {
+        base64::encode( data + begin, end - begin, out + begin / 3 * 4 );
+      } );
+    }
+
+    //! Base64 encodes size bytes into a string
+    /*! @internal */
+    inline std::string encode_base64( ThreadPool * pool, std::size_t chunkSize, unsigned char const * data, std::size_t size )
+    {
+      std::string encoded( base64::encoded_size( size ), '\0' );
+      if( size )
+        encode_base64( pool, chunkSize, data, size, &encoded[0] );
+      return encoded;
+    }
+
+    //! Decodes length base64 characters into exactly size bytes
+    /*! @return false if the characters do not decode to exactly size bytes
+        @internal */
+    inline bool decode_base64( ThreadPool * pool, std::size_t chunkSize, char const * encoded, std::size_t length,
+                               unsigned char * out, std::size_t size )
+    {
+      if( base64::decoded_size( encoded, length ) != size )
+        return false;
+
+      // Chunks of whole four character groups decode independently
+      chunkSize = std::max<std::size_t>( chunkSize / 3 * 4, 4 );
+      std::atomic<bool> valid( true );
+      for_each_chunk( pool, length, chunkSize, [&]( std::size_t begin, std::size_t end )
+      {
+        std::size_t const offset = begin / 4 * 3;
+        std::size_t const expected = end == length ? size - offset : ( end - begin ) / 4 * 3;
+        if( base64::decode( encoded + begin, end - begin, out + offset, expected ) != expected )
+          valid = false;
+      } );
+
+      return valid;
+    }
+  } // namespace parallel_detail
+
+  // ######################################################################
+  //! Transforms a payload in parallel chunks and emits the results in order
+  /*! This is a building block for archives whose output is CPU bound, such as those that
+      compress or checksum their data.  The range [0, size) is split into chunks of
+      chunkSize; transform( begin, end, out ) is called for each chunk on the pool, and
+      emit( out ) is called for each transformed chunk in order on the calling thread.
+
+      Only a bounded number of chunks are held at once, and their buffers are reused,
+      so the memory needed does not grow with the size of the payload.
+
+      @param pool The pool to transform on, or nullptr to transform on the calling thread
+      @param size The size of the payload
+      @param chunkSize The size of each chunk but the last
+      @param transform Called as transform( std::size_t begin, std::size_t end, std::string & out ),
+                       with out empty, possibly concurrently with other chunks
+      @param emit Called as emit( std::string const & out ) for each chunk in order
+
+      @ingroup Utility */
+  template <class Transform, class Emit> inline
+  void transform_chunks( ThreadPool * pool, std::size_t size, std::size_t chunkSize,
+                         Transform const & transform, Emit const & emit )
+  {
+    chunkSize = std::max<std::size_t>( chunkSize, 1 );
+    std::size_t const window = pool ? 2 * pool->size() + 1 : 1;
+    std::vector<std::string> buffers( window );
+
+    for( std::size_t first = 0; first < size; first += window * chunkSize )
+    {
+      std::size_t const count = std::min( window, ( size - first + chunkSize - 1 ) / chunkSize );
+
+      parallel_detail::for_each_chunk( pool, count, 1, [&]( std::size_t begin, std::size_t end )
+      {
+        for( std::size_t i = begin; i < end; ++i )
+        {
+          std::size_t const chunkBegin = first + i * chunkSize;
+          buffers[i].clear();
+          transform( chunkBegin, std::min( size, chunkBegin + chunkSize ), buffers[i] );
+        }
+      } );
+
+      for( std::size_t i = 0; i < count; ++i )
+        emit( buffers[i] );
+    }
+  }
+} // namespace cereal
+
+#endif // CEREAL_DETAILS_PARALLEL_HPP_
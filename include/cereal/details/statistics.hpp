@@ -0,0 +1,320 @@
+/*! \file statistics.hpp
+    \brief Per type serialization statistics
+
+    Archives only record statistics when CEREAL_ENABLE_STATISTICS is defined before
+    cereal is included; otherwise the hooks are compiled out entirely.
+    \ingroup Utility */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_DETAILS_STATISTICS_HPP_
+#define CEREAL_DETAILS_STATISTICS_HPP_
+
+#include <cereal/details/helpers.hpp>
+#include <cereal/details/util.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace cereal
+{
+  namespace statistics_detail
+  {
+    //! Reports how far an archive has got through its stream
+    /*! @internal */
+    class StreamPosition
+    {
+      public:
+        //! Always reports position zero
+        StreamPosition() : itsBuffer( nullptr ), itsMode( std::ios::out ) {}
+
+        //! Follows the read or write position of stream
+        StreamPosition( std::ios & stream, std::ios::openmode which ) : itsBuffer( stream.rdbuf() ), itsMode( which ) {}
+
+        //! The current position, or zero if it is unknown
+        std::streamoff operator()() const
+        {
+          if( !itsBuffer )
+            return 0;
+
+          std::streamoff const pos = itsBuffer->pubseekoff( 0, std::ios::cur, itsMode );
+          return pos < 0 ? 0 : pos;
+        }
+
+      private:
+        std::streambuf * itsBuffer;
+        std::ios::openmode itsMode;
+    };
+  } // namespace statistics_detail
+
+  // ######################################################################
+  //! Records how often each type is serialized, and how much time and output it accounts for
+  /*! Attach an instance to an archive with setStatistics, serialize as usual, and then
+      inspect the results with entries, writeTable, or writeJSON.  Archives only support
+      this when CEREAL_ENABLE_STATISTICS is defined before any cereal header is included.
+
+      Times and bytes are inclusive, covering everything serialized beneath a type,
+      while the exclusive time leaves out time spent in nested types.  For a type that
+      contains itself, only the outermost call contributes to the inclusive totals.
+
+      Bytes are measured as the change in position of the stream given on construction,
+      so they are only meaningful for archives that write or read their stream as they
+      go, such as the binary and JSON output archives.  Finding the position means
+      seeking the stream at the start and end of the outermost call for each type, which
+      for file streams also flushes them; construct without a stream to avoid this.
+      Archives that build a document in memory first, like the XML output archive, will
+      report zero bytes.
+
+      @code{.cpp}
+      #define CEREAL_ENABLE_STATISTICS
+      #include <cereal/archives/binary.hpp>
+
+      cereal::Statistics stats( os );
+      {
+        cereal::BinaryOutputArchive ar( os );
+        ar.setStatistics( &stats );
+        ar( data );
+      }
+      stats.writeTable( std::cout );
+      @endcode
+
+      @ingroup Utility */
+  class Statistics
+  {
+    public:
+      //! The totals recorded for one type
+      struct Entry
+      {
+        std::string name;        //!< The demangled name of the type
+        std::size_t count;       //!< The number of times it was serialized
+        std::size_t bytes;       //!< Bytes written or read, including nested types
+        double inclusiveSeconds; //!< Time spent, including nested types
+        double exclusiveSeconds; //!< Time spent, excluding nested types
+      };
+
+      //! Records counts and times, but not bytes
+      Statistics() {}
+
+      //! Records counts, times, and bytes written to stream
+      explicit Statistics( std::ostream & stream ) : itsPosition( stream, std::ios::out ) {}
+
+      //! Records counts, times, and bytes read from stream
+      explicit Statistics( std::istream & stream ) : itsPosition( stream, std::ios::in ) {}
+
+      //! Records counts, times, and bytes for a stream used in both directions
+      /*! @param stream The stream the archive uses
+          @param which std::ios::out to count bytes written, std::ios::in to count bytes read */
+      Statistics( std::iostream & stream, std::ios::openmode which ) : itsPosition( stream, which ) {}
+
+      //! The totals for every type seen so far, ordered by decreasing inclusive time
+      std::vector<Entry> entries() const
+      {
+        std::vector<Entry> result;
+        result.reserve( itsRecords.size() );
+        for( auto const & r : itsRecords )
+        {
+          Entry e = r.second.entry;
+          e.name = util::demangle( r.first.name() );
+          result.push_back( e );
+        }
+
+        std::sort( result.begin(), result.end(),
+                   []( Entry const & a, Entry const & b ) { return a.inclusiveSeconds > b.inclusiveSeconds; } );
+        return result;
+      }
+
+      //! Forgets everything recorded so far
+      void clear()
+      {
+        itsRecords.clear();
+        itsFrames.clear();
+      }
+
+      //! Writes the entries as a human readable table
+      void writeTable( std::ostream & os ) const
+      {
+        auto const list = entries();
+
+        std::size_t width = 4;
+        for( auto const & e : list )
+          width = std::max( width, e.name.size() );
+
+        os << std::left << std::setw( static_cast<int>( width ) ) << "type" << std::right
+           << std::setw( 12 ) << "count" << std::setw( 14 ) << "bytes"
+           << std::setw( 14 ) << "inclusive ms" << std::setw( 14 ) << "exclusive ms" << '\n';
+
+        for( auto const & e : list )
+        {
+          char inclusive[32], exclusive[32];
+          std::snprintf( inclusive, sizeof(inclusive), "%.3f", e.inclusiveSeconds * 1e3 );
+          std::snprintf( exclusive, sizeof(exclusive), "%.3f", e.exclusiveSeconds * 1e3 );
+
+          os << std::left << std::setw( static_cast<int>( width ) ) << e.name << std::right
+             << std::setw( 12 ) << e.count << std::setw( 14 ) << e.bytes
+             << std::setw( 14 ) << inclusive << std::setw( 14 ) << exclusive << '\n';
+        }
+      }
+
+      //! Writes the entries as a JSON array of objects
+      void writeJSON( std::ostream & os ) const
+      {
+        auto const list = entries();
+
+        os << '[';
+        for( std::size_t i = 0; i < list.size(); ++i )
+        {
+          auto const & e = list[i];
+          char times[96];
+          std::snprintf( times, sizeof(times), "\"inclusive_seconds\": %.9g, \"exclusive_seconds\": %.9g",
+                         e.inclusiveSeconds, e.exclusiveSeconds );
+
+          os << ( i ? ",\n " : "\n " ) << "{\"type\": \"";
+          for( char c : e.name )
+          {
+            if( c == '"' || c == '\\' )
+              os << '\\';
+            os << c;
+          }
+          os << "\", \"count\": " << e.count << ", \"bytes\": " << e.bytes << ", " << times << '}';
+        }
+        os << "\n]\n";
+      }
+
+      //! Marks the start of serializing a value of some type
+      /*! The stream position is only needed for the outermost call for a type, which is
+          the only one counted in the bytes, so nested calls avoid the seek.
+          @internal */
+      void begin( std::type_info const & type )
+      {
+        auto & record = itsRecords[std::type_index( type )];
+        std::streamoff const position = ++record.depth == 1 ? itsPosition() : 0;
+        itsFrames.push_back( { &record, position, 0.0, clock::now() } );
+      }
+
+      //! Marks the end of the value most recently begun
+      /*! @internal */
+      void end()
+      {
+        auto const now = clock::now();
+        Frame const frame = itsFrames.back();
+        itsFrames.pop_back();
+
+        double const elapsed = std::chrono::duration<double>( now - frame.start ).count();
+        auto & record = *frame.record;
+
+        ++record.entry.count;
+        record.entry.exclusiveSeconds += elapsed - frame.children;
+        if( --record.depth == 0 )
+        {
+          record.entry.inclusiveSeconds += elapsed;
+          auto const pos = itsPosition();
+          if( pos > frame.position )
+            record.entry.bytes += static_cast<std::size_t>( pos - frame.position );
+        }
+
+        if( !itsFrames.empty() )
+          itsFrames.back().children += elapsed;
+      }
+
+    private:
+      typedef std::chrono::steady_clock clock;
+
+      struct Record
+      {
+        Record() : entry{ std::string(), 0, 0, 0.0, 0.0 }, depth( 0 ) {}
+
+        Entry entry;
+        std::size_t depth; //!< How many calls for this type are in progress
+      };
+
+      struct Frame
+      {
+        Record * record;
+        std::streamoff position;
+        double children; //!< Time spent in nested types
+        clock::time_point start;
+      };
+
+      statistics_detail::StreamPosition itsPosition;
+      std::unordered_map<std::type_index, Record> itsRecords;
+      std::vector<Frame> itsFrames;
+  };
+
+  namespace statistics_detail
+  {
+    //! Types that only wrap another value, which is recorded in their place
+    template <class T> struct is_wrapper : std::false_type {};
+    template <class T> struct is_wrapper<NameValuePair<T>> : std::true_type {};
+    template <class T> struct is_wrapper<SizeTag<T>> : std::true_type {};
+    template <class K, class V> struct is_wrapper<MapItem<K, V>> : std::true_type {};
+
+    //! Records the serialization of a T for as long as it is in scope
+    /*! @internal */
+    template <class T, bool Ignored = is_wrapper<typename std::decay<T>::type>::value>
+    class Scope
+    {
+      public:
+        Scope( Statistics * statistics ) : itsStatistics( statistics )
+        {
+          if( itsStatistics )
+            itsStatistics->begin( typeid( typename std::decay<T>::type ) );
+        }
+
+        ~Scope()
+        {
+          if( itsStatistics )
+            itsStatistics->end();
+        }
+
+        Scope( Scope const & ) = delete;
+        Scope & operator=( Scope const & ) = delete;
+
+      private:
+        Statistics * itsStatistics;
+    };
+
+    //! Wrappers are not recorded
+    template <class T>
+    class Scope<T, true>
+    {
+      public:
+        Scope( Statistics * ) {}
+    };
+  } // namespace statistics_detail
+} // namespace cereal
+
+#endif // CEREAL_DETAILS_STATISTICS_HPP_
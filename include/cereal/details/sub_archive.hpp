@@ -0,0 +1,137 @@
+/*! \file sub_archive.hpp
+    \brief Separate archives whose output is embedded in that of another
+    \ingroup Internal */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_DETAILS_SUB_ARCHIVE_HPP_
+#define CEREAL_DETAILS_SUB_ARCHIVE_HPP_
+
+#include <cereal/cereal.hpp>
+#include <cereal/details/traits.hpp>
+#include <cereal/details/memory_resource.hpp>
+
+#include <istream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace cereal
+{
+  class SizingOutputArchive;
+
+  namespace detail
+  {
+    //! Whether values can be serialized by a separate archive of type Archive over a Stream
+    /*! The output of the separate archive is then embedded in that of the original, as
+        for parallel containers and deferred values.  Binary archives support this, as does
+        the sizing archive, which counts what the binary archives would embed. */
+    template <class Archive, class Stream>
+    struct is_sub_archive : std::integral_constant<bool,
+      !traits::is_text_archive<Archive>::value &&
+      ( std::is_constructible<Archive, Stream &>::value || std::is_same<Archive, SizingOutputArchive>::value )> {};
+
+    //! Whether an output archive has options that archives of the same type can be constructed with
+    template <class Archive>
+    struct has_archive_options
+    {
+      template <class U> static auto test(int) -> decltype( U( std::declval<std::ostream &>(), std::declval<U const &>().options() ), std::true_type() );
+      template <class>   static std::false_type test(...);
+      static const bool value = std::is_same<decltype(test<Archive>(0)), std::true_type>::value;
+    };
+
+    //! What a separate archive wrote, to be embedded in the output of another
+    /*! The sizing archive only counts bytes, so for it data stays empty and only size is set. */
+    struct SubArchiveOutput
+    {
+      std::string data;
+      std::size_t size;
+    };
+
+    //! Saves with a separate archive of the same type and options as ar
+    /*! @param save Called with the separate archive */
+    template <class Archive, class Save> inline
+    typename std::enable_if<has_archive_options<Archive>::value, SubArchiveOutput>::type
+    save_in_sub_archive( Archive & ar, Save && save )
+    {
+      std::ostringstream os;
+      {
+        Archive sub( os, ar.options() );
+        save( sub );
+      }
+      auto data = os.str();
+      auto const size = data.size();
+      return { std::move( data ), size };
+    }
+
+    //! Saves with a separate archive of the same type as ar
+    template <class Archive, class Save> inline
+    typename std::enable_if<!has_archive_options<Archive>::value && !std::is_same<Archive, SizingOutputArchive>::value, SubArchiveOutput>::type
+    save_in_sub_archive( Archive &, Save && save )
+    {
+      std::ostringstream os;
+      {
+        Archive sub( os );
+        save( sub );
+      }
+      auto data = os.str();
+      auto const size = data.size();
+      return { std::move( data ), size };
+    }
+
+    //! Counts what a separate binary archive of the same format and options as ar would write
+    template <class Archive, class Save> inline
+    typename std::enable_if<std::is_same<Archive, SizingOutputArchive>::value, SubArchiveOutput>::type
+    save_in_sub_archive( Archive & ar, Save && save )
+    {
+      Archive sub( ar.format(), ar.framesVersionedObjects(), ar.internStringsUpTo() );
+      save( sub );
+      return { std::string(), sub.size() };
+    }
+
+    //! Embeds the output of a separate archive, without its length
+    template <class Archive> inline
+    void save_sub_archive_output( Archive & ar, SubArchiveOutput const & output )
+    {
+      // the sizing archive only looks at the size
+      ar( binary_data( output.data.data(), output.size ) );
+    }
+
+    //! Loads with a separate archive of type Archive, reading from stream
+    /*! @param resource The memory resource of the original archive, which the separate
+                        archive loads into as well
+        @param load Called with the separate archive */
+    template <class Archive, class Load> inline
+    void load_in_sub_archive( std::istream & stream, MemoryResource * resource, Load && load )
+    {
+      Archive sub( stream );
+      sub.setMemoryResource( resource );
+      load( sub );
+    }
+  } // namespace detail
+} // namespace cereal
+
+#endif // CEREAL_DETAILS_SUB_ARCHIVE_HPP_
@@ -0,0 +1,306 @@
+/*! \file trace.hpp
+    \brief Timeline tracing of serialization in the Chrome trace event format
+
+    Archives only record traces when CEREAL_ENABLE_TRACING is defined before
+    cereal is included; otherwise the hooks are compiled out entirely.
+    \ingroup Utility */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_DETAILS_TRACE_HPP_
+#define CEREAL_DETAILS_TRACE_HPP_
+
+#include <cereal/details/statistics.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace cereal
+{
+  // ######################################################################
+  //! Records a timeline of serialization that can be viewed with chrome://tracing
+  /*! Attach an instance to an archive with setTracer and serialize as usual.  Every
+      type that is serialized and, for archives with nodes such as JSON and XML, every
+      node that is started and finished becomes an event with its start time, duration,
+      and the bytes it covers.  writeJSON exports the events in the Chrome trace event
+      format, which can be loaded into chrome://tracing or Perfetto.
+
+      Large objects can produce a great many events, so Options can restrict the trace
+      to events that take at least a given time or cover at least a given number of
+      bytes.  Bytes are measured from the stream given on construction in the same way
+      as for Statistics.  Finding the position means seeking the stream at the start and
+      end of every type and node, which for file streams also flushes them, even when
+      only events over a minimum duration are kept.  Construct without a stream to avoid
+      this, at the cost of every event reporting zero bytes.
+
+      Archives only support this when CEREAL_ENABLE_TRACING is defined before any
+      cereal header is included.
+
+      @code{.cpp}
+      #define CEREAL_ENABLE_TRACING
+      #include <cereal/archives/json.hpp>
+
+      cereal::Tracer tracer( os, cereal::Tracer::Options( 100 ) ); // events of 100us or more
+      {
+        cereal::JSONOutputArchive ar( os );
+        ar.setTracer( &tracer );
+        ar( checkpoint );
+      }
+      tracer.writeJSON( traceFile );
+      @endcode
+
+      @ingroup Utility */
+  class Tracer
+  {
+    public:
+      //! Decides which events are kept
+      class Options
+      {
+        public:
+          //! Keeps every event
+          static Options Default(){ return Options(); }
+
+          //! Specify thresholds for keeping events
+          /*! An event is kept if it meets any threshold that is set, where a threshold
+              of zero is not set.  With no thresholds set every event is kept.
+
+              @param minMicroseconds The shortest duration of an event to keep
+              @param minBytes The fewest bytes for an event to keep */
+          explicit Options( double minMicroseconds = 0, std::size_t minBytes = 0 ) :
+            itsMinMicroseconds( minMicroseconds ),
+            itsMinBytes( minBytes )
+          { }
+
+        private:
+          friend class Tracer;
+          double itsMinMicroseconds;
+          std::size_t itsMinBytes;
+      };
+
+      //! A completed event
+      struct Event
+      {
+        std::string name;         //!< The type or node name
+        char const * category;    //!< "type" or "node"
+        double startMicroseconds; //!< Start time since the tracer was created
+        double microseconds;      //!< Duration
+        std::size_t bytes;        //!< Bytes written or read during the event
+        std::size_t depth;        //!< Nesting depth of the event among types or nodes
+      };
+
+      //! Traces without measuring bytes, so no stream is sought or flushed
+      explicit Tracer( Options const & options = Options::Default() ) :
+        itsOptions( options ), itsOrigin( clock::now() ) {}
+
+      //! Traces, measuring bytes written to stream
+      explicit Tracer( std::ostream & stream, Options const & options = Options::Default() ) :
+        itsOptions( options ), itsPosition( stream, std::ios::out ), itsOrigin( clock::now() ) {}
+
+      //! Traces, measuring bytes read from stream
+      explicit Tracer( std::istream & stream, Options const & options = Options::Default() ) :
+        itsOptions( options ), itsPosition( stream, std::ios::in ), itsOrigin( clock::now() ) {}
+
+      //! Traces, measuring bytes for a stream used in both directions
+      /*! @param which std::ios::out to measure bytes written, std::ios::in to measure bytes read */
+      Tracer( std::iostream & stream, std::ios::openmode which, Options const & options = Options::Default() ) :
+        itsOptions( options ), itsPosition( stream, which ), itsOrigin( clock::now() ) {}
+
+      //! The events kept so far, in the order they finished
+      std::vector<Event> const & events() const
+      { return itsEvents; }
+
+      //! Forgets all events, keeping the time origin
+      void clear()
+      {
+        itsEvents.clear();
+        itsTypeFrames.clear();
+        itsNodeFrames.clear();
+      }
+
+      //! Writes the events as a Chrome trace event JSON object
+      void writeJSON( std::ostream & os ) const
+      {
+        os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        for( std::size_t i = 0; i < itsEvents.size(); ++i )
+        {
+          auto const & e = itsEvents[i];
+          char times[96];
+          std::snprintf( times, sizeof(times), "\"ts\": %.3f, \"dur\": %.3f", e.startMicroseconds, e.microseconds );
+
+          os << ( i ? ",\n " : "\n " ) << "{\"name\": \"";
+          for( char c : e.name )
+          {
+            if( c == '"' || c == '\\' )
+              os << '\\';
+            os << c;
+          }
+          os << "\", \"cat\": \"" << e.category << "\", \"ph\": \"X\", " << times
+             << ", \"pid\": 1, \"tid\": 1, \"args\": {\"bytes\": " << e.bytes << "}}";
+        }
+        os << "\n]}\n";
+      }
+
+      //! Marks the start of serializing a value of some type
+      /*! @internal */
+      void beginType( std::type_info const & type )
+      {
+        itsTypeFrames.push_back( { &type, nullptr, itsPosition(), clock::now() } );
+      }
+
+      //! Marks the end of the type most recently begun
+      /*! @internal */
+      void endType()
+      {
+        auto const frame = itsTypeFrames.back();
+        itsTypeFrames.pop_back();
+        finish( frame, "type", itsTypeFrames.size() );
+      }
+
+      //! Marks the start of a node, which may not have a name
+      /*! @internal */
+      void beginNode( char const * name )
+      {
+        itsNodeFrames.push_back( { nullptr, name, itsPosition(), clock::now() } );
+        if( name )
+        {
+          // The name may not outlive the node, so it is kept with the frame
+          itsNodeNames.resize( itsNodeFrames.size() );
+          itsNodeNames.back() = name;
+        }
+      }
+
+      //! Marks the end of the node most recently begun
+      /*! @internal */
+      void endNode()
+      {
+        if( itsNodeFrames.empty() )
+          return;
+
+        auto frame = itsNodeFrames.back();
+        itsNodeFrames.pop_back();
+        if( frame.name )
+          frame.name = itsNodeNames[itsNodeFrames.size()].c_str();
+        finish( frame, "node", itsNodeFrames.size() );
+      }
+
+    private:
+      typedef std::chrono::steady_clock clock;
+
+      struct Frame
+      {
+        std::type_info const * type; //!< Set for types
+        char const * name;           //!< Set for named nodes
+        std::streamoff position;
+        clock::time_point start;
+      };
+
+      //! Turns a finished frame into an event, if it meets the thresholds
+      void finish( Frame const & frame, char const * category, std::size_t depth )
+      {
+        auto const now = clock::now();
+        double const microseconds = std::chrono::duration<double, std::micro>( now - frame.start ).count();
+        auto const pos = itsPosition();
+        std::size_t const bytes = pos > frame.position ? static_cast<std::size_t>( pos - frame.position ) : 0;
+
+        bool const timed = itsOptions.itsMinMicroseconds > 0;
+        bool const sized = itsOptions.itsMinBytes > 0;
+        if( ( timed || sized ) &&
+            !( timed && microseconds >= itsOptions.itsMinMicroseconds ) &&
+            !( sized && bytes >= itsOptions.itsMinBytes ) )
+          return;
+
+        Event e;
+        e.name = frame.type ? typeName( *frame.type ) : ( frame.name ? frame.name : "node" );
+        e.category = category;
+        e.startMicroseconds = std::chrono::duration<double, std::micro>( frame.start - itsOrigin ).count();
+        e.microseconds = microseconds;
+        e.bytes = bytes;
+        e.depth = depth;
+        itsEvents.push_back( std::move( e ) );
+      }
+
+      //! Demangled type names, computed once per type
+      std::string const & typeName( std::type_info const & type )
+      {
+        auto iter = itsTypeNames.find( std::type_index( type ) );
+        if( iter == itsTypeNames.end() )
+          iter = itsTypeNames.emplace( std::type_index( type ), util::demangle( type.name() ) ).first;
+        return iter->second;
+      }
+
+      Options itsOptions;
+      statistics_detail::StreamPosition itsPosition;
+      clock::time_point itsOrigin;
+      std::vector<Frame> itsTypeFrames;
+      std::vector<Frame> itsNodeFrames;
+      std::vector<std::string> itsNodeNames; //!< Copies of node names, indexed by node depth
+      std::unordered_map<std::type_index, std::string> itsTypeNames;
+      std::vector<Event> itsEvents;
+  };
+
+  namespace trace_detail
+  {
+    //! Traces the serialization of a T for as long as it is in scope
+    /*! @internal */
+    template <class T, bool Ignored = statistics_detail::is_wrapper<typename std::decay<T>::type>::value>
+    class Scope
+    {
+      public:
+        Scope( Tracer * tracer ) : itsTracer( tracer )
+        {
+          if( itsTracer )
+            itsTracer->beginType( typeid( typename std::decay<T>::type ) );
+        }
+
+        ~Scope()
+        {
+          if( itsTracer )
+            itsTracer->endType();
+        }
+
+        Scope( Scope const & ) = delete;
+        Scope & operator=( Scope const & ) = delete;
+
+      private:
+        Tracer * itsTracer;
+    };
+
+    //! Wrappers are not traced
+    template <class T>
+    class Scope<T, true>
+    {
+      public:
+        Scope( Tracer * ) {}
+    };
+  } // namespace trace_detail
+} // namespace cereal
+
+#endif // CEREAL_DETAILS_TRACE_HPP_
@@ -1300,6 +1300,10 @@ namespace cereal
                      "} \n\n" );
       static T * load_andor_construct()
       { return ::cereal::access::construct<T>(); }
+
+      //! Default constructs into storage that has already been allocated
+      static void load_andor_construct( T * ptr )
+      { ::cereal::access::construct( ptr ); }
     };
 
     template <class T, class A>
@@ -1319,6 +1323,55 @@ namespace cereal
         LoadAndConstruct<T>::load_and_construct( ar, construct );
       }
     };
+
+    //! Holds an element of a container while it is loaded through load_and_construct
+    /*! Container loaders serialize this in place of each element, then move the
+        element into the container.  This lets containers hold types that are not
+        default constructible, and spares types that are the cost of default
+        constructing each element only to overwrite it.
+        @internal */
+    template <class Archive, class T>
+    class ConstructedElement
+    {
+      public:
+        ConstructedElement() : itsConstruct( reinterpret_cast<T *>( &itsStorage ) )
+        { }
+
+        ConstructedElement( ConstructedElement const & ) = delete;
+        ConstructedElement & operator=( ConstructedElement const & ) = delete;
+
+        ~ConstructedElement()
+        {
+          if( itsConstruct.itsValid )
+            itsConstruct.itsPtr->~T();
+        }
+
+        void CEREAL_SERIALIZE_FUNCTION_NAME( Archive & ar )
+        {
+          Construct<T, Archive>::load_andor_construct( ar, itsConstruct );
+        }
+
+        //! The loaded element
+        /*! @throw Exception if load_and_construct did not construct it */
+        T & get()
+        {
+          return *itsConstruct.ptr();
+        }
+
+      private:
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type itsStorage;
+        ::cereal::construct<T> itsConstruct;
+    };
+
+    //! Whether container loaders construct elements of T through ConstructedElement
+    /*! This holds for movable types with load_and_construct, even if they are also
+        default constructible, in which case their member load or serialize is no
+        longer used for container elements.  Types that cannot be moved are still
+        default constructed and then loaded in place.
+        @internal */
+    template <class T, class Archive>
+    struct constructs_container_elements : std::integral_constant<bool,
+      traits::has_load_and_construct<T, Archive>::value && std::is_move_constructible<T>::value> {};
   } // namespace detail
 } // namespace cereal
 
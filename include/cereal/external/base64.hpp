@@ -20,12 +20,30 @@
    3. This notice may not be removed or altered from any source distribution.
 
    René Nyffenegger rene.nyffenegger@adp-gmbh.ch
+
+   Altered for cereal: the codec writes into caller provided buffers that are
+   sized up front, works on whole groups of characters through lookup tables,
+   and uses SSSE3 or AVX2 for the bulk of the data when the compiler targets them.
+   Define CEREAL_BASE64_NO_SIMD to always use the portable code.
 */
 
 #ifndef CEREAL_EXTERNAL_BASE64_HPP_
 #define CEREAL_EXTERNAL_BASE64_HPP_
 
 #include <string>
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(CEREAL_BASE64_NO_SIMD)
+  #if defined(__AVX2__)
+    #define CEREAL_BASE64_AVX2
+    #define CEREAL_BASE64_SSSE3
+    #include <immintrin.h>
+  #elif defined(__SSSE3__)
+    #define CEREAL_BASE64_SSSE3
+    #include <tmmintrin.h>
+  #endif
+#endif
 
 namespace base64
 {
@@ -38,87 +56,265 @@ namespace base64
     return (isalnum(c) || (c == '+') || (c == '/'));
   }
 
-  inline std::string encode(unsigned char const* bytes_to_encode, size_t in_len) {
-    std::string ret;
-    int i = 0;
-    int j = 0;
-    unsigned char char_array_3[3];
-    unsigned char char_array_4[4];
-
-    while (in_len--) {
-      char_array_3[i++] = *(bytes_to_encode++);
-      if (i == 3) {
-        char_array_4[0] = (unsigned char) ((char_array_3[0] & 0xfc) >> 2);
-        char_array_4[1] = (unsigned char) ( ( ( char_array_3[0] & 0x03 ) << 4 ) + ( ( char_array_3[1] & 0xf0 ) >> 4 ) );
-        char_array_4[2] = (unsigned char) ( ( ( char_array_3[1] & 0x0f ) << 2 ) + ( ( char_array_3[2] & 0xc0 ) >> 6 ) );
-        char_array_4[3] = (unsigned char) ( char_array_3[2] & 0x3f );
-
-        for(i = 0; (i <4) ; i++)
-          ret += chars[char_array_4[i]];
-        i = 0;
-      }
+  namespace detail
+  {
+    //! Marks a character outside of the base64 alphabet in the decoding table
+    static const std::uint8_t invalid = 0xff;
+
+    //! Maps characters to their six bit values, or invalid
+    inline std::uint8_t const * decoding_table()
+    {
+      static const std::uint8_t table[256] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,   62, 0xff, 0xff, 0xff,   63,
+          52,   53,   54,   55,   56,   57,   58,   59,   60,   61, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff,    0,    1,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,   12,   13,   14,
+          15,   16,   17,   18,   19,   20,   21,   22,   23,   24,   25, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff,   26,   27,   28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,
+          41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+      return table;
     }
 
-    if (i)
+    #ifdef CEREAL_BASE64_SSSE3
+    //! Turns the six bit values in each byte into their base64 characters
+    inline __m128i encode_lookup( __m128i indices )
     {
-      for(j = i; j < 3; j++)
-        char_array_3[j] = '\0';
+      __m128i shift = _mm_subs_epu8( indices, _mm_set1_epi8( 51 ) );
+      const __m128i less = _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), indices );
+      shift = _mm_or_si128( shift, _mm_and_si128( less, _mm_set1_epi8( 13 ) ) );
+
+      const __m128i shiftLUT = _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0 );
+
+      return _mm_add_epi8( _mm_shuffle_epi8( shiftLUT, shift ), indices );
+    }
+
+    //! Splits the first 12 bytes into 16 six bit values, one per byte
+    inline __m128i encode_split( __m128i in )
+    {
+      in = _mm_shuffle_epi8( in, _mm_set_epi8( 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1 ) );
+
+      const __m128i t0 = _mm_and_si128( in, _mm_set1_epi32( 0x0fc0fc00 ) );
+      const __m128i t1 = _mm_mulhi_epu16( t0, _mm_set1_epi32( 0x04000040 ) );
+      const __m128i t2 = _mm_and_si128( in, _mm_set1_epi32( 0x003f03f0 ) );
+      const __m128i t3 = _mm_mullo_epi16( t2, _mm_set1_epi32( 0x01000010 ) );
+
+      return _mm_or_si128( t1, t3 );
+    }
+
+    //! Translates 16 characters into their six bit values
+    /*! @return false if any of the characters is outside of the alphabet */
+    inline bool decode_lookup( __m128i & str )
+    {
+      const __m128i lutLo   = _mm_setr_epi8( 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                             0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A );
+      const __m128i lutHi   = _mm_setr_epi8( 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                             0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+      const __m128i lutRoll = _mm_setr_epi8( 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 );
+      const __m128i mask2F  = _mm_set1_epi8( 0x2f );
+
+      const __m128i hiNibbles = _mm_and_si128( _mm_srli_epi32( str, 4 ), mask2F );
+      const __m128i loNibbles = _mm_and_si128( str, mask2F );
+      const __m128i hi = _mm_shuffle_epi8( lutHi, hiNibbles );
+      const __m128i lo = _mm_shuffle_epi8( lutLo, loNibbles );
+
+      if( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_and_si128( lo, hi ), _mm_setzero_si128() ) ) != 0xffff )
+        return false;
+
+      const __m128i eq2F = _mm_cmpeq_epi8( str, mask2F );
+      const __m128i roll = _mm_shuffle_epi8( lutRoll, _mm_add_epi8( eq2F, hiNibbles ) );
+      str = _mm_add_epi8( str, roll );
+      return true;
+    }
+
+    //! Packs 16 six bit values into 12 bytes at the front of the register
+    inline __m128i decode_pack( __m128i values )
+    {
+      const __m128i mergedPairs = _mm_maddubs_epi16( values, _mm_set1_epi32( 0x01400140 ) );
+      const __m128i merged = _mm_madd_epi16( mergedPairs, _mm_set1_epi32( 0x00011000 ) );
+      return _mm_shuffle_epi8( merged, _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 ) );
+    }
+    #endif // CEREAL_BASE64_SSSE3
+  } // detail
+
+  //! The number of characters needed to encode in_len bytes, including padding
+  inline size_t encoded_size(size_t in_len) {
+    return (in_len + 2) / 3 * 4;
+  }
 
-      char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-      char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-      char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-      char_array_4[3] = char_array_3[2] & 0x3f;
+  //! Encodes in_len bytes into out, which must have room for encoded_size(in_len) characters
+  /*! No terminating null character is written */
+  inline void encode(unsigned char const* bytes_to_encode, size_t in_len, char* out) {
+    size_t i = 0;
+
+    #ifdef CEREAL_BASE64_AVX2
+    // Each iteration reads 28 bytes and uses 24 of them
+    for (; i + 28 <= in_len; i += 24, out += 32) {
+      const __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes_to_encode + i));
+      const __m128i hi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes_to_encode + i + 12));
+      const __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+      const __m256i shuffled = _mm256_shuffle_epi8(in, _mm256_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                                          1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+      const __m256i t0 = _mm256_and_si256(shuffled, _mm256_set1_epi32(0x0fc0fc00));
+      const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+      const __m256i t2 = _mm256_and_si256(shuffled, _mm256_set1_epi32(0x003f03f0));
+      const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+      const __m256i indices = _mm256_or_si256(t1, t3);
+
+      __m256i shift = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+      const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+      shift = _mm256_or_si256(shift, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+      const __m256i shiftLUT = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                                '/' - 63, 'A', 0, 0,
+                                                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                                '/' - 63, 'A', 0, 0);
+      const __m256i result = _mm256_add_epi8(_mm256_shuffle_epi8(shiftLUT, shift), indices);
 
-      for (j = 0; (j < i + 1); j++)
-        ret += chars[char_array_4[j]];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), result);
+    }
+    #endif // CEREAL_BASE64_AVX2
+
+    #ifdef CEREAL_BASE64_SSSE3
+    // Each iteration reads 16 bytes and uses 12 of them
+    for (; i + 16 <= in_len; i += 12, out += 16) {
+      const __m128i in = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes_to_encode + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), detail::encode_lookup(detail::encode_split(in)));
+    }
+    #endif // CEREAL_BASE64_SSSE3
 
-      while((i++ < 3))
-        ret += '=';
+    char const* table = chars.data();
 
+    for (; i + 3 <= in_len; i += 3, out += 4) {
+      const std::uint32_t group = (std::uint32_t(bytes_to_encode[i]) << 16) |
+                                  (std::uint32_t(bytes_to_encode[i + 1]) << 8) |
+                                   std::uint32_t(bytes_to_encode[i + 2]);
+      out[0] = table[(group >> 18) & 0x3f];
+      out[1] = table[(group >> 12) & 0x3f];
+      out[2] = table[(group >> 6) & 0x3f];
+      out[3] = table[group & 0x3f];
     }
 
+    if (i < in_len) {
+      const bool two = i + 2 == in_len;
+      const std::uint32_t group = (std::uint32_t(bytes_to_encode[i]) << 16) |
+                                  (two ? std::uint32_t(bytes_to_encode[i + 1]) << 8 : 0);
+      out[0] = table[(group >> 18) & 0x3f];
+      out[1] = table[(group >> 12) & 0x3f];
+      out[2] = two ? table[(group >> 6) & 0x3f] : '=';
+      out[3] = '=';
+    }
+  }
+
+  inline std::string encode(unsigned char const* bytes_to_encode, size_t in_len) {
+    std::string ret(encoded_size(in_len), '\0');
+    if (in_len)
+      encode(bytes_to_encode, in_len, &ret[0]);
     return ret;
+  }
+
+  //! The number of bytes that in_len characters of well formed base64 decode to
+  /*! Only trailing padding is considered, so this is exact for the output of encode
+      and an upper bound for anything else */
+  inline size_t decoded_size(char const* encoded, size_t in_len) {
+    size_t padding = 0;
+    while (padding < 2 && in_len > padding && encoded[in_len - padding - 1] == '=')
+      ++padding;
 
+    const size_t significant = in_len - padding;
+    const size_t remainder = significant % 4;
+    return significant / 4 * 3 + (remainder ? remainder - 1 : 0);
   }
 
-  inline std::string decode(std::string const& encoded_string) {
-    size_t in_len = encoded_string.size();
+  //! Decodes up to in_len characters into out, writing at most out_len bytes
+  /*! Decoding stops at the first padding or other character that is not part of
+      the base64 alphabet, or when out is full.
+      @return The number of bytes written */
+  inline size_t decode(char const* encoded, size_t in_len, unsigned char* out, size_t out_len) {
     size_t i = 0;
-    size_t j = 0;
-    int in_ = 0;
-    unsigned char char_array_4[4], char_array_3[3];
-    std::string ret;
-
-    while (in_len-- && ( encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-      char_array_4[i++] = encoded_string[in_]; in_++;
-      if (i ==4) {
-        for (i = 0; i <4; i++)
-          char_array_4[i] = (unsigned char) chars.find( char_array_4[i] );
-
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-        for (i = 0; (i < 3); i++)
-          ret += char_array_3[i];
-        i = 0;
-      }
+    size_t o = 0;
+
+    #ifdef CEREAL_BASE64_AVX2
+    // Each iteration reads 32 characters and writes 32 bytes, 24 of which are kept
+    for (; i + 32 <= in_len && o + 32 <= out_len; i += 32, o += 24) {
+      __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(encoded + i));
+      __m128i hi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(encoded + i + 16));
+      if (!detail::decode_lookup(lo) || !detail::decode_lookup(hi))
+        break;
+
+      const __m256i values = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+      const __m256i mergedPairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+      const __m256i merged = _mm256_madd_epi16(mergedPairs, _mm256_set1_epi32(0x00011000));
+      const __m256i packed = _mm256_shuffle_epi8(merged, _mm256_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                                           2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+      const __m256i contiguous = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + o), contiguous);
+    }
+    #endif // CEREAL_BASE64_AVX2
+
+    #ifdef CEREAL_BASE64_SSSE3
+    // Each iteration reads 16 characters and writes 16 bytes, 12 of which are kept
+    for (; i + 16 <= in_len && o + 16 <= out_len; i += 16, o += 12) {
+      __m128i str = _mm_loadu_si128(reinterpret_cast<__m128i const*>(encoded + i));
+      if (!detail::decode_lookup(str))
+        break;
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), detail::decode_pack(str));
     }
+    #endif // CEREAL_BASE64_SSSE3
 
-    if (i) {
-      for (j = i; j <4; j++)
-        char_array_4[j] = 0;
+    std::uint8_t const* table = detail::decoding_table();
 
-      for (j = 0; j <4; j++)
-        char_array_4[j] = (unsigned char) chars.find( char_array_4[j] );
+    for (; i + 4 <= in_len && o + 3 <= out_len; i += 4, o += 3) {
+      const std::uint8_t a = table[static_cast<unsigned char>(encoded[i])];
+      const std::uint8_t b = table[static_cast<unsigned char>(encoded[i + 1])];
+      const std::uint8_t c = table[static_cast<unsigned char>(encoded[i + 2])];
+      const std::uint8_t d = table[static_cast<unsigned char>(encoded[i + 3])];
+      if ((a | b | c | d) == detail::invalid)
+        break;
 
-      char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-      char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-      char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+      out[o]     = static_cast<unsigned char>((a << 2) | (b >> 4));
+      out[o + 1] = static_cast<unsigned char>((b << 4) | (c >> 2));
+      out[o + 2] = static_cast<unsigned char>((c << 6) | d);
+    }
+
+    // Final group, which may be partial or end in padding
+    std::uint8_t values[4] = {0, 0, 0, 0};
+    size_t count = 0;
+    for (; count < 4 && i + count < in_len; ++count) {
+      values[count] = table[static_cast<unsigned char>(encoded[i + count])];
+      if (values[count] == detail::invalid)
+        break;
+    }
 
-      for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+    if (count > 1 && o < out_len) {
+      out[o++] = static_cast<unsigned char>((values[0] << 2) | (values[1] >> 4));
+      if (count > 2 && o < out_len)
+        out[o++] = static_cast<unsigned char>((values[1] << 4) | (values[2] >> 2));
+      if (count > 3 && o < out_len)
+        out[o++] = static_cast<unsigned char>((values[2] << 6) | values[3]);
     }
 
+    return o;
+  }
+
+  inline std::string decode(std::string const& encoded_string) {
+    std::string ret(decoded_size(encoded_string.data(), encoded_string.size()), '\0');
+    if (!ret.empty())
+      ret.resize(decode(encoded_string.data(), encoded_string.size(), reinterpret_cast<unsigned char*>(&ret[0]), ret.size()));
     return ret;
   }
 } // base64
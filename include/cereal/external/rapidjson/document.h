@@ -708,7 +708,7 @@ public:
 	template <unsigned parseFlags, typename Stream>
 	GenericDocument& ParseStream(Stream& stream) {
 		ValueType::SetNull_(); // Remove existing root if exist
-		GenericReader<Encoding, Allocator> reader;
+		GenericReader<Encoding, Allocator> reader(&GetAllocator());	// Keep the parse stack in the document's pool
 		if (reader.template Parse<parseFlags>(stream, *this)) {
 			RAPIDJSON_ASSERT(stack_.GetSize() == sizeof(ValueType)); // Got one and only one root object
 			this->RawAssign(*stack_.template Pop<ValueType>(1));	// Add this-> to prevent issue 13.
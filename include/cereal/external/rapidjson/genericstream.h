@@ -63,8 +63,10 @@ namespace rapidjson {
       GenericWriteStream(std::ostream& os) : os_(os) {
       }
 
+      // Writes go straight to the stream buffer; ostream::put would construct a sentry for every character
       void Put(char c) {
-        os_.put(c);
+        if (std::char_traits<char>::eq_int_type(os_.rdbuf()->sputc(c), std::char_traits<char>::eof()))
+          os_.setstate(std::ios::badbit);
       }
 
       void PutN(char c, size_t n) {
@@ -0,0 +1,362 @@
+#ifndef RAPIDJSON_INTERNAL_DTOA_H_
+#define RAPIDJSON_INTERNAL_DTOA_H_
+
+// Shortest round-trip floating point formatting using the Grisu2 algorithm from
+// Loitsch, Florian. "Printing floating-point numbers quickly and accurately with
+// integers." ACM Sigplan Notices 45.6 (2010): 233-243.
+//
+// This header is self contained so that it can be shared by archives that do
+// not otherwise depend on rapidjson.
+
+#include <cstdint>
+#include <cstring>
+
+namespace rapidjson {
+namespace internal {
+
+//! A floating point number with a 64 bit significand and a binary exponent
+/*! Represents f * 2^e without an implicit bit. */
+struct DiyFp {
+	DiyFp() : f(0), e(0) {}
+	DiyFp(uint64_t fp, int exp) : f(fp), e(exp) {}
+
+	DiyFp operator-(const DiyFp& rhs) const {
+		return DiyFp(f - rhs.f, e);
+	}
+
+	//! Multiplies two numbers keeping the upper 64 bits of the product, rounded
+	DiyFp operator*(const DiyFp& rhs) const {
+#if defined(__GNUC__) && defined(__x86_64__)
+		__extension__ typedef unsigned __int128 uint128;
+		uint128 p = static_cast<uint128>(f) * static_cast<uint128>(rhs.f);
+		uint64_t h = static_cast<uint64_t>(p >> 64);
+		uint64_t l = static_cast<uint64_t>(p);
+		if (l & (uint64_t(1) << 63)) // rounding
+			h++;
+		return DiyFp(h, e + rhs.e + 64);
+#else
+		const uint64_t M32 = 0xFFFFFFFF;
+		const uint64_t a = f >> 32;
+		const uint64_t b = f & M32;
+		const uint64_t c = rhs.f >> 32;
+		const uint64_t d = rhs.f & M32;
+		const uint64_t ac = a * c;
+		const uint64_t bc = b * c;
+		const uint64_t ad = a * d;
+		const uint64_t bd = b * d;
+		uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+		tmp += 1U << 31; // rounding
+		return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+#endif
+	}
+
+	//! Shifts the significand so that its most significant bit is set
+	DiyFp Normalize() const {
+		DiyFp res = *this;
+#if defined(__GNUC__)
+		const int s = __builtin_clzll(res.f);
+		res.f <<= s;
+		res.e -= s;
+#else
+		while (!(res.f & (uint64_t(1) << 63))) {
+			res.f <<= 1;
+			res.e--;
+		}
+#endif
+		return res;
+	}
+
+	uint64_t f;
+	int e;
+};
+
+//! Bit layout of the IEEE-754 types supported by Grisu2()
+template <typename T> struct FloatTraits;
+
+template <> struct FloatTraits<double> {
+	typedef uint64_t Bits;
+	static const int kSignificandSize = 52;
+	static const int kExponentBias = 0x3FF + kSignificandSize;
+};
+
+template <> struct FloatTraits<float> {
+	typedef uint32_t Bits;
+	static const int kSignificandSize = 23;
+	static const int kExponentBias = 0x7F + kSignificandSize;
+};
+
+//! Decomposes a finite, positive value into its normalized form and the normalized boundaries
+/*! The boundaries m- and m+ are the midpoints to the neighbouring values of type T and share
+	the exponent of m+.  Any decimal strictly between them reads back as the same value. */
+template <typename T>
+inline void Decompose(T value, DiyFp* v, DiyFp* minus, DiyFp* plus) {
+	typedef FloatTraits<T> Traits;
+	typename Traits::Bits bits;
+	std::memcpy(&bits, &value, sizeof(value));
+
+	const uint64_t hiddenBit = uint64_t(1) << Traits::kSignificandSize;
+	const uint64_t significand = bits & (hiddenBit - 1);
+	const int biasedExponent = static_cast<int>(bits >> Traits::kSignificandSize);
+
+	DiyFp w;
+	if (biasedExponent != 0) {
+		w.f = significand + hiddenBit;
+		w.e = biasedExponent - Traits::kExponentBias;
+	}
+	else {
+		w.f = significand;
+		w.e = 1 - Traits::kExponentBias;
+	}
+
+	// the lower boundary is closer when the significand is a power of two
+	const bool lowerCloser = significand == 0 && biasedExponent > 1;
+
+	DiyFp pl = DiyFp((w.f << 1) + 1, w.e - 1).Normalize();
+	DiyFp mi = lowerCloser ? DiyFp((w.f << 2) - 1, w.e - 2) : DiyFp((w.f << 1) - 1, w.e - 1);
+	mi.f <<= mi.e - pl.e;
+	mi.e = pl.e;
+
+	*v = w.Normalize();
+	*minus = mi;
+	*plus = pl;
+}
+
+//! Gets the cached power of ten c_k = 10^-K such that the product with a DiyFp of exponent e
+//! has its binary exponent in [-60, -32]
+inline DiyFp GetCachedPower(int e, int* K) {
+	// 10^-348, 10^-340, ..., 10^340
+	static const uint64_t kCachedPowers_F[] = {
+		0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+		0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+		0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+		0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+		0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+		0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+		0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+		0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+		0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+		0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+		0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+		0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+		0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+		0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+		0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+		0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+		0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+		0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+		0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+		0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+		0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+		0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+	};
+	static const int16_t kCachedPowers_E[] = {
+		-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954,
+		-927, -901, -874, -847, -821, -794, -768, -741, -715, -688, -661,
+		-635, -608, -582, -555, -529, -502, -475, -449, -422, -396, -369,
+		-343, -316, -289, -263, -236, -210, -183, -157, -130, -103, -77,
+		-50, -24, 3, 30, 56, 83, 109, 136, 162, 189, 216,
+		242, 269, 295, 322, 348, 375, 402, 428, 455, 481, 508,
+		534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800,
+		827, 853, 880, 907, 933, 960, 986, 1013, 1039, 1066
+	};
+
+	const double dk = (-61 - e) * 0.30102999566398114 + 347; // dk must be positive, so can do ceiling in positive
+	int k = static_cast<int>(dk);
+	if (dk - k > 0.0)
+		k++;
+
+	const unsigned index = static_cast<unsigned>((k >> 3) + 1);
+	*K = -(-348 + static_cast<int>(index << 3)); // decimal exponent no need lookup table
+
+	return DiyFp(kCachedPowers_F[index], kCachedPowers_E[index]);
+}
+
+//! Moves the last generated digit down while that gets closer to the exact value and stays in range
+inline void GrisuRound(char* buffer, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+	while (rest < wp_w && delta - rest >= ten_kappa &&
+		(rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+		buffer[len - 1]--;
+		rest += ten_kappa;
+	}
+}
+
+inline unsigned CountDecimalDigit32(uint32_t n) {
+	if (n < 10) return 1;
+	if (n < 100) return 2;
+	if (n < 1000) return 3;
+	if (n < 10000) return 4;
+	if (n < 100000) return 5;
+	if (n < 1000000) return 6;
+	if (n < 10000000) return 7;
+	if (n < 100000000) return 8;
+	if (n < 1000000000) return 9;
+	return 10;
+}
+
+//! Generates the shortest digit string within delta of Mp
+inline void DigitGen(const DiyFp& W, const DiyFp& Mp, uint64_t delta, char* buffer, int* len, int* K) {
+	static const uint64_t kPow10[] = { 1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+		100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+		100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+		1000000000000000000ULL, 10000000000000000000ULL };
+	const DiyFp one(uint64_t(1) << -Mp.e, Mp.e);
+	const DiyFp wp_w = Mp - W;
+	uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+	uint64_t p2 = Mp.f & (one.f - 1);
+	int kappa = static_cast<int>(CountDecimalDigit32(p1));
+	*len = 0;
+
+	while (kappa > 0) {
+		const uint32_t d = p1 / static_cast<uint32_t>(kPow10[kappa - 1]);
+		p1 %= static_cast<uint32_t>(kPow10[kappa - 1]);
+		if (d || *len)
+			buffer[(*len)++] = static_cast<char>('0' + d);
+		kappa--;
+		const uint64_t tmp = (static_cast<uint64_t>(p1) << -one.e) + p2;
+		if (tmp <= delta) {
+			*K += kappa;
+			GrisuRound(buffer, *len, delta, tmp, kPow10[kappa] << -one.e, wp_w.f);
+			return;
+		}
+	}
+
+	// kappa = 0
+	for (;;) {
+		p2 *= 10;
+		delta *= 10;
+		const char d = static_cast<char>(p2 >> -one.e);
+		if (d || *len)
+			buffer[(*len)++] = static_cast<char>('0' + d);
+		p2 &= one.f - 1;
+		kappa--;
+		if (p2 < delta) {
+			*K += kappa;
+			const int index = -kappa;
+			GrisuRound(buffer, *len, delta, p2, one.f, wp_w.f * (index < 20 ? kPow10[index] : 0));
+			return;
+		}
+	}
+}
+
+//! Generates the shortest digits of a finite, positive value such that value ~= buffer * 10^K
+template <typename T>
+inline void Grisu2(T value, char* buffer, int* length, int* K) {
+	DiyFp v, w_m, w_p;
+	Decompose(value, &v, &w_m, &w_p);
+
+	const DiyFp c_mk = GetCachedPower(w_p.e, K);
+	const DiyFp W = v * c_mk;
+	DiyFp Wp = w_p * c_mk;
+	DiyFp Wm = w_m * c_mk;
+	Wm.f++;
+	Wp.f--;
+	DigitGen(W, Wp, Wp.f - Wm.f, buffer, length, K);
+}
+
+inline char* WriteExponent(int K, char* buffer) {
+	if (K < 0) {
+		*buffer++ = '-';
+		K = -K;
+	}
+
+	if (K >= 100) {
+		*buffer++ = static_cast<char>('0' + K / 100);
+		K %= 100;
+		*buffer++ = static_cast<char>('0' + K / 10);
+		*buffer++ = static_cast<char>('0' + K % 10);
+	}
+	else if (K >= 10) {
+		*buffer++ = static_cast<char>('0' + K / 10);
+		*buffer++ = static_cast<char>('0' + K % 10);
+	}
+	else
+		*buffer++ = static_cast<char>('0' + K);
+
+	return buffer;
+}
+
+//! Formats the digits buffer * 10^k as a JSON number
+inline char* Prettify(char* buffer, int length, int k) {
+	const int kk = length + k; // 10^(kk-1) <= v < 10^kk
+
+	if (0 <= k && kk <= 21) {
+		// 1234e7 -> 12340000000.0
+		for (int i = length; i < kk; i++)
+			buffer[i] = '0';
+		buffer[kk] = '.';
+		buffer[kk + 1] = '0';
+		return &buffer[kk + 2];
+	}
+	else if (0 < kk && kk <= 21) {
+		// 1234e-2 -> 12.34
+		std::memmove(&buffer[kk + 1], &buffer[kk], static_cast<size_t>(length - kk));
+		buffer[kk] = '.';
+		return &buffer[length + 1];
+	}
+	else if (-6 < kk && kk <= 0) {
+		// 1234e-6 -> 0.001234
+		const int offset = 2 - kk;
+		std::memmove(&buffer[offset], &buffer[0], static_cast<size_t>(length));
+		buffer[0] = '0';
+		buffer[1] = '.';
+		for (int i = 2; i < offset; i++)
+			buffer[i] = '0';
+		return &buffer[length + offset];
+	}
+	else if (length == 1) {
+		// 1e30
+		buffer[1] = 'e';
+		return WriteExponent(kk - 1, &buffer[2]);
+	}
+	else {
+		// 1234e30 -> 1.234e33
+		std::memmove(&buffer[2], &buffer[1], static_cast<size_t>(length - 1));
+		buffer[1] = '.';
+		buffer[length + 1] = 'e';
+		return WriteExponent(kk - 1, &buffer[length + 2]);
+	}
+}
+
+//! Writes the shortest decimal representation of a finite value that reads back exactly
+/*! No terminating null character is written.
+	\param value A finite value; infinities and NaN must be handled by the caller.
+	\param buffer Output buffer of at least kMaxDtoaLength characters.
+	\return A pointer one past the last character written. */
+template <typename T>
+inline char* Dtoa(T value, char* buffer) {
+	typename FloatTraits<T>::Bits bits;
+	std::memcpy(&bits, &value, sizeof(value));
+	const typename FloatTraits<T>::Bits signBit =
+		static_cast<typename FloatTraits<T>::Bits>(1) << (sizeof(bits) * 8 - 1);
+
+	if (bits & signBit) {
+		*buffer++ = '-';
+		bits &= ~signBit;
+		std::memcpy(&value, &bits, sizeof(value));
+	}
+
+	if (bits == 0) {
+		buffer[0] = '0';
+		buffer[1] = '.';
+		buffer[2] = '0';
+		return &buffer[3];
+	}
+
+	int length, K;
+	Grisu2(value, buffer, &length, &K);
+	return Prettify(buffer, length, K);
+}
+
+//! The largest number of characters written by Dtoa()
+static const int kMaxDtoaLength = 26;
+
+//! Shortest round-trip representation of a double, see Dtoa()
+inline char* dtoa(double value, char* buffer) { return Dtoa(value, buffer); }
+
+//! Shortest round-trip representation of a float, see Dtoa()
+inline char* dtoa(float value, char* buffer) { return Dtoa(value, buffer); }
+
+} // namespace internal
+} // namespace rapidjson
+
+#endif // RAPIDJSON_INTERNAL_DTOA_H_
@@ -0,0 +1,37 @@
+#ifndef RAPIDJSON_INTERNAL_STRTOD_H_
+#define RAPIDJSON_INTERNAL_STRTOD_H_
+
+#include "pow10.h"
+#include <cstdio>	// snprintf() or _sprintf_s()
+#include <cstdlib>	// strtod()
+
+namespace rapidjson {
+namespace internal {
+
+//! Converts a decimal significand * 10^exp to the nearest double.
+/*! When both the significand and the power of ten are exactly representable a single
+	multiplication or division is correctly rounded.  Everything else goes through strtod(),
+	which is given a string without a decimal point and is thus unaffected by the locale.
+	\param significand The leading decimal digits of the number.
+	\param exp The decimal exponent applied to significand.
+	\param truncated Whether non-zero digits beyond those in significand were dropped.
+	\return The nearest double, or infinity if it is out of range.
+*/
+inline double StrtodDecimal(uint64_t significand, int exp, bool truncated) {
+	if (!truncated && significand <= (uint64_t(1) << 53) && exp >= -22 && exp <= 22)
+		return exp < 0 ? static_cast<double>(significand) / Pow10(-exp) : static_cast<double>(significand) * Pow10(exp);
+
+	// A trailing sticky digit stands in for the dropped ones when rounding
+	char buffer[48];
+#if _MSC_VER
+	(void) sprintf_s(buffer, sizeof(buffer), truncated ? "%llu1e%d" : "%llue%d", static_cast<unsigned long long>(significand), truncated ? exp - 1 : exp);
+#else
+	(void) snprintf(buffer, sizeof(buffer), truncated ? "%llu1e%d" : "%llue%d", static_cast<unsigned long long>(significand), truncated ? exp - 1 : exp);
+#endif
+	return std::strtod(buffer, 0);
+}
+
+} // namespace internal
+} // namespace rapidjson
+
+#endif // RAPIDJSON_INTERNAL_STRTOD_H_
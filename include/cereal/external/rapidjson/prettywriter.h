@@ -23,7 +23,7 @@ public:
 		\param levelDepth Initial capacity of
 	*/
 	PrettyWriter(Stream& stream, int precision = 20, Allocator* allocator = 0, size_t levelDepth = Base::kDefaultLevelDepth) :
-		Base(stream, precision, allocator, levelDepth), indentChar_(' '), indentCharCount_(4) {}
+		Base(stream, precision, allocator, levelDepth), indentChar_(' '), indentCharCount_(4), singleLine_(false) {}
 
 	//! Set custom indentation.
 	/*! \param indentChar		Character for indentation. Must be whitespace character (' ', '\t', '\n', '\r').
@@ -37,6 +37,12 @@ public:
 		return *this;
 	}
 
+	//! Write everything on a single line, without any whitespace, like Writer does.
+	PrettyWriter& SetSingleLine(bool singleLine) {
+		singleLine_ = singleLine;
+		return *this;
+	}
+
 	//@name Implementation of Handler.
 	//@{
 
@@ -46,6 +52,7 @@ public:
 	PrettyWriter& Uint(unsigned u)		{ PrettyPrefix(kNumberType); Base::WriteUint(u);		return *this; }
 	PrettyWriter& Int64(int64_t i64)	{ PrettyPrefix(kNumberType); Base::WriteInt64(i64);		return *this; }
 	PrettyWriter& Uint64(uint64_t u64)	{ PrettyPrefix(kNumberType); Base::WriteUint64(u64);	return *this; }
+	PrettyWriter& Float(float f)		{ PrettyPrefix(kNumberType); Base::WriteFloat(f);		return *this; }
 	PrettyWriter& Double(double d)		{ PrettyPrefix(kNumberType); Base::WriteDouble(d);		return *this; }
 
 	PrettyWriter& String(const Ch* str, SizeType length, bool copy = false) {
@@ -68,7 +75,7 @@ public:
 		RAPIDJSON_ASSERT(!Base::level_stack_.template Top<typename Base::Level>()->inArray);
 		bool empty = Base::level_stack_.template Pop<typename Base::Level>(1)->valueCount == 0;
 
-		if (!empty) {
+		if (!empty && !singleLine_) {
 			Base::stream_.Put('\n');
 			WriteIndent();
 		}
@@ -89,7 +96,7 @@ public:
 		RAPIDJSON_ASSERT(Base::level_stack_.template Top<typename Base::Level>()->inArray);
 		bool empty = Base::level_stack_.template Pop<typename Base::Level>(1)->valueCount == 0;
 
-		if (!empty) {
+		if (!empty && !singleLine_) {
 			Base::stream_.Put('\n');
 			WriteIndent();
 		}
@@ -104,7 +111,11 @@ public:
 
 protected:
 	void PrettyPrefix(Type type) {
-		(void)type;
+		if (singleLine_) {
+			Base::Prefix(type);
+			return;
+		}
+
 		if (Base::level_stack_.GetSize() != 0) { // this value is not at root
 			typename Base::Level* level = Base::level_stack_.template Top<typename Base::Level>();
 
@@ -149,6 +160,7 @@ protected:
 
 	Ch indentChar_;
 	unsigned indentCharCount_;
+	bool singleLine_;
 };
 
 } // namespace rapidjson
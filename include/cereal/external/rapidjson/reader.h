@@ -5,14 +5,10 @@
 // Version 0.1
 
 #include "rapidjson.h"
-#include "internal/pow10.h"
+#include "internal/strtod.h"
 #include "internal/stack.h"
 #include <csetjmp>
-
-// All part of denormalized parsing
-#include <limits> // for numeric_limits
-#include <cmath> // for fpclassify
-#include <sstream>
+#include <cmath> // for isinf
 
 #ifdef RAPIDJSON_SSE42
 #include <nmmintrin.h>
@@ -605,42 +601,45 @@ private:
 		}
 
 		// Force double for big integer
-		double d = 0.0;
+		// Doubles keep their leading 19 or more digits exactly and are rounded once at the end
+		static const uint64_t kMaxSignificand = 1844674407370955160uLL; // (2^64 - 1 - 9) / 10
+		uint64_t significand = 0;
+		bool truncated = false;
+		int expFrac = 0;
 		if (useDouble) {
-			d = (double)i64;
+			significand = i64;
 			while (s.Peek() >= '0' && s.Peek() <= '9') {
-				if (d >= 1E307) {
-					RAPIDJSON_PARSE_ERROR("Number too big to store in double", stream.Tell());
-					return;
+				const unsigned digit = static_cast<unsigned>(s.Take() - '0');
+				if (significand <= kMaxSignificand)
+					significand = significand * 10 + digit;
+				else {
+					truncated = truncated || digit != 0;
+					++expFrac;
 				}
-				d = d * 10 + (s.Take() - '0');
 			}
 		}
 
 		// Parse frac = decimal-point 1*DIGIT
-		int expFrac = 0;
 		if (s.Peek() == '.') {
 			if (!useDouble) {
-				d = try64bit ? (double)i64 : (double)i;
+				significand = try64bit ? i64 : i;
 				useDouble = true;
 			}
 			s.Take();
 
-			if (s.Peek() >= '0' && s.Peek() <= '9') {
-				d = d * 10 + (s.Take() - '0');
-				--expFrac;
-			}
-			else {
+			if (!(s.Peek() >= '0' && s.Peek() <= '9')) {
 				RAPIDJSON_PARSE_ERROR("At least one digit in fraction part", stream.Tell());
 				return;
 			}
 
 			while (s.Peek() >= '0' && s.Peek() <= '9') {
-				if (expFrac > -20) {
-					d = d * 10 + (s.Peek() - '0');
+				const unsigned digit = static_cast<unsigned>(s.Take() - '0');
+				if (significand <= kMaxSignificand) {
+					significand = significand * 10 + digit;
 					--expFrac;
 				}
-				s.Take();
+				else
+					truncated = truncated || digit != 0;
 			}
 		}
 
@@ -648,7 +647,7 @@ private:
 		int exp = 0;
 		if (s.Peek() == 'e' || s.Peek() == 'E') {
 			if (!useDouble) {
-				d = try64bit ? (double)i64 : (double)i;
+				significand = try64bit ? i64 : i;
 				useDouble = true;
 			}
 			s.Take();
@@ -664,23 +663,9 @@ private:
 			if (s.Peek() >= '0' && s.Peek() <= '9') {
 				exp = s.Take() - '0';
 				while (s.Peek() >= '0' && s.Peek() <= '9') {
-					exp = exp * 10 + (s.Take() - '0');
-					if (exp > 308) {
-            // Attempt denormalized construction
-            std::stringstream ss;
-            ss.precision( std::numeric_limits<double>::max_digits10 );
-            ss << d * internal::Pow10(expFrac) << 'e' << (expMinus ? '-' : '+') << exp;
-
-            double dd;
-            ss >> dd;
-
-            if( std::fpclassify( dd ) == FP_SUBNORMAL )
-              handler.Double( dd );
-            else
-						  RAPIDJSON_PARSE_ERROR("Number too big to store in double", stream.Tell());
-
-						return;
-					}
+					if (exp < 100000) // saturate, anything beyond is zero or infinity anyway
+						exp = exp * 10 + (s.Peek() - '0');
+					s.Take();
 				}
 			}
 			else {
@@ -694,7 +679,11 @@ private:
 
 		// Finish parsing, call event according to the type of number.
 		if (useDouble) {
-			d *= internal::Pow10(exp + expFrac);
+			const double d = internal::StrtodDecimal(significand, exp + expFrac, truncated);
+			if (std::isinf(d)) {
+				RAPIDJSON_PARSE_ERROR("Number too big to store in double", stream.Tell());
+				return;
+			}
 			handler.Double(minus ? -d : d);
 		}
 		else {
@@ -4,6 +4,8 @@
 #include "rapidjson.h"
 #include "internal/stack.h"
 #include "internal/strfunc.h"
+#include "internal/dtoa.h"
+#include <cmath>	// isfinite()
 #include <cstdio>	// snprintf() or _sprintf_s()
 #include <new>		// placement new
 #include <limits>
@@ -37,6 +39,9 @@ public:
 	Writer(Stream& stream, int precision = 20, Allocator* allocator = 0, size_t levelDepth = kDefaultLevelDepth) :
 		stream_(stream), level_stack_(allocator, levelDepth * sizeof(Level))
   {
+    // Any precision that already round trips is served by the shortest representation
+    shortest_ = precision >= std::numeric_limits<double>::max_digits10;
+
 #if _MSC_VER
     (void) sprintf_s(double_format, sizeof(double_format), "%%0.%dg", precision);
     (void) sprintf_s( long_double_format, sizeof( long_double_format ), "%%0.%dLg", precision );
@@ -50,6 +55,7 @@ public:
 protected:
   char double_format[32];
   char long_double_format[32];
+  bool shortest_; //!< Whether floating point values use the shortest round trip representation
 public:
 
 	//@name Implementation of Handler
@@ -61,6 +67,7 @@ public:
 	Writer& Uint(unsigned u)                { Prefix(kNumberType); WriteUint(u);		return *this;             }
 	Writer& Int64(int64_t i64)              { Prefix(kNumberType); WriteInt64(i64);		return *this;           }
 	Writer& Uint64(uint64_t u64)            { Prefix(kNumberType); WriteUint64(u64);	return *this;           }
+	Writer& Float(float f)                  { Prefix(kNumberType); WriteFloat(f);		return *this;           }
 	Writer& Double(double d)                { Prefix(kNumberType); WriteDouble(d);		return *this;           }
 	Writer& LongDouble(long double d)       { Prefix(kNumberType); WriteLongDouble(d);		return *this;       }
 	Writer& LongLong(long long d)           { Prefix(kNumberType); WriteLongLong(d);		return *this;         }
@@ -208,8 +215,22 @@ protected:
   { return c < 256; }
 #endif
 
-	//! \todo Optimization with custom double-to-string converter.
+	void WriteFloat(float f) {
+		if (shortest_ && std::isfinite(f)) {
+			char buffer[internal::kMaxDtoaLength];
+			WriteBuffer(buffer, internal::dtoa(f, buffer));
+		}
+		else
+			WriteDouble(f);
+	}
+
 	void WriteDouble(double d) {
+		if (shortest_ && std::isfinite(d)) {
+			char buffer[internal::kMaxDtoaLength];
+			WriteBuffer(buffer, internal::dtoa(d, buffer));
+			return;
+		}
+
 		char buffer[100];
 #if _MSC_VER
 		int ret = sprintf_s(buffer, sizeof(buffer), double_format, d);
@@ -221,6 +242,11 @@ protected:
 			stream_.Put(buffer[i]);
 	}
 
+	void WriteBuffer(const char* begin, const char* end) {
+		for (; begin != end; ++begin)
+			stream_.Put(*begin);
+	}
+
 	void WriteLongDouble(long double d) {
 		char buffer[256];
 #if _MSC_VER
@@ -396,7 +396,8 @@ namespace rapidxml
 
         //! Constructs empty pool with default allocator functions.
         memory_pool()
-            : m_alloc_func(0)
+            : m_spare(0)
+            , m_alloc_func(0)
             , m_free_func(0)
         {
             init();
@@ -532,13 +533,29 @@ namespace rapidxml
         //! Any nodes or strings allocated from the pool will no longer be valid.
         void clear()
         {
-            while (m_begin != m_static_memory)
+            reset();
+            while (m_spare)
             {
-                char *previous_begin = reinterpret_cast<header *>(align(m_begin))->previous_begin;
+                char *next = reinterpret_cast<header *>(align(m_spare))->previous_begin;
                 if (m_free_func)
-                    m_free_func(m_begin);
+                    m_free_func(m_spare);
                 else
-                    delete[] m_begin;
+                    delete[] m_spare;
+                m_spare = next;
+            }
+        }
+
+        //! Clears the pool, but keeps the memory it allocated for reuse.
+        //! Later allocations are served from the retained memory before any new memory is allocated,
+        //! so a pool that is reset between similar documents stops allocating.
+        //! Any nodes or strings allocated from the pool will no longer be valid.
+        void reset()
+        {
+            while (m_begin != m_static_memory)
+            {
+                char *previous_begin = reinterpret_cast<header *>(align(m_begin))->previous_begin;
+                reinterpret_cast<header *>(align(m_begin))->previous_begin = m_spare;
+                m_spare = m_begin;
                 m_begin = previous_begin;
             }
             init();
@@ -569,6 +586,7 @@ namespace rapidxml
         struct header
         {
             char *previous_begin;
+            std::size_t size;
         };
 
         void init()
@@ -617,14 +635,28 @@ namespace rapidxml
                 if (pool_size < size)
                     pool_size = size;
 
-                // Allocate
+                // Allocate, reusing memory retained by reset() if a block is large enough
                 std::size_t alloc_size = sizeof(header) + (2 * RAPIDXML_ALIGNMENT - 2) + pool_size;     // 2 alignments required in worst case: one for header, one for actual allocation
-                char *raw_memory = allocate_raw(alloc_size);
+                char *raw_memory = 0;
+                for (char **spare = &m_spare; *spare; spare = &reinterpret_cast<header *>(align(*spare))->previous_begin)
+                {
+                    header *spare_header = reinterpret_cast<header *>(align(*spare));
+                    if (spare_header->size >= alloc_size)
+                    {
+                        raw_memory = *spare;
+                        alloc_size = spare_header->size;
+                        *spare = spare_header->previous_begin;
+                        break;
+                    }
+                }
+                if (!raw_memory)
+                    raw_memory = allocate_raw(alloc_size);
 
                 // Setup new pool in allocated memory
                 char *pool = align(raw_memory);
                 header *new_header = reinterpret_cast<header *>(pool);
                 new_header->previous_begin = m_begin;
+                new_header->size = alloc_size;
                 m_begin = raw_memory;
                 m_ptr = pool + sizeof(header);
                 m_end = raw_memory + alloc_size;
@@ -641,6 +673,7 @@ namespace rapidxml
         char *m_begin;                                      // Start of raw memory making up current pool
         char *m_ptr;                                        // First free byte in current pool
         char *m_end;                                        // One past last available byte in current pool
+        char *m_spare;                                      // Raw memory retained by reset(), linked through the headers
         char m_static_memory[RAPIDXML_STATIC_POOL_SIZE];    // Static raw memory
         alloc_func *m_alloc_func;                           // Allocator function, or 0 if default is to be used
         free_func *m_free_func;                             // Free function, or 0 if default is to be used
@@ -1947,12 +1980,12 @@ namespace rapidxml
         template<int Flags>
         Ch parse_and_append_data(xml_node<Ch> *node, Ch *&text, Ch *contents_start)
         {
-            // Backup to contents start if whitespace trimming is disabled
-            if (!(Flags & parse_trim_whitespace))
-                text = contents_start;
-
             const bool preserve_space =  internal::preserve_space(node);
 
+            // Backup to contents start if whitespace trimming is disabled or whitespace is preserved
+            if (!(Flags & parse_trim_whitespace) || preserve_space)
+                text = contents_start;
+
             // Skip until end of data
             Ch *value_ = text, *end;
             if ((Flags & parse_normalize_whitespace) && !preserve_space)
@@ -2225,7 +2258,8 @@ namespace rapidxml
                             RAPIDXML_PARSE_ERROR("expected >", text);
                         ++text;     // Skip '>'
 
-                        if (contents_end && contents_end != contents_start)
+                        // Whitespace only contents never produce a data node, keep them as the value
+                        if (contents_end && contents_end != contents_start && node->value_size() == 0)
                         {
                             node->value(contents_start, contents_end - contents_start);
                             node->value()[node->value_size()] = Ch('\0');
@@ -0,0 +1,283 @@
+/*! \file deferred.hpp
+    \brief Support for values that are only decoded when first used
+    \ingroup OtherTypes */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_TYPES_DEFERRED_HPP_
+#define CEREAL_TYPES_DEFERRED_HPP_
+
+#include <cereal/cereal.hpp>
+#include <cereal/types/memory.hpp>
+#include <cereal/details/buffers.hpp>
+#include <cereal/details/sub_archive.hpp>
+
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+
+namespace cereal
+{
+  // ######################################################################
+  //! Holds a value that binary archives only decode when it is first used
+  /*! Saving writes the value with an archive of its own, prefixed by its length.  Loading
+      from a binary archive then only reads the length and skips over the value, which is
+      decoded the first time it is accessed.  This suits large members that are rarely
+      used, such as history buffers or attachments.
+
+      By default the encoded value is read into memory and only decoded when accessed.
+      If the input archive is given shared ownership of a seekable stream with
+      setSharedStream, every deferred value it loads instead only records its position,
+      and is read from the stream when accessed.  The value then keeps the stream alive,
+      and restores its position after reading.  Text archives save and load the value
+      directly.
+
+      Accessing a value that has not been decoded yet, even through a const reference,
+      decodes it, so it must not be accessed from several threads at once until then.
+
+      The value is held as a std::unique_ptr, and types without a default constructor
+      are supported through load_and_construct.  Since the value has an archive of its
+      own, it does not share pointers, polymorphic type names or class versions with
+      anything else.  That archive has the same options as the one the value is saved
+      with, and loads into the same memory resource.
+
+      @code{.cpp}
+      struct Session
+      {
+        std::string user;
+        cereal::Deferred<std::vector<Event>> history;
+
+        template <class Archive>
+        void serialize( Archive & ar )
+        { ar( user, history ); }
+      };
+
+      auto is = std::make_shared<std::ifstream>( "sessions.bin", std::ios::binary );
+      cereal::BinaryInputArchive ar( *is );
+      ar.setSharedStream( is ); // histories are not even read while loading
+      std::vector<Session> sessions;
+      ar( sessions );
+
+      // a history is only read and decoded here, if ever
+      for( auto const & event : *sessions.front().history ) ...
+      @endcode
+
+      @ingroup OtherTypes */
+  template <class T>
+  class Deferred
+  {
+    public:
+      //! Holds no value
+      Deferred() = default;
+
+      //! Holds the given value
+      explicit Deferred( std::unique_ptr<T> value ) : itsValue( std::move( value ) ) {}
+
+      //! Holds a copy of the given value
+      explicit Deferred( T const & value ) : itsValue( new T( value ) ) {}
+
+      Deferred( Deferred && ) = default;
+      Deferred & operator=( Deferred && ) = default;
+
+      //! Whether the value is available without decoding it
+      bool isLoaded() const
+      { return !itsLoader; }
+
+      //! The value, decoding it if needed, or nullptr if there is none
+      T * get() const
+      {
+        decode();
+        return itsValue.get();
+      }
+
+      T & operator*() const
+      { return *get(); }
+
+      T * operator->() const
+      { return get(); }
+
+      //! Whether there is a value, decoding it if needed
+      explicit operator bool() const
+      { return get() != nullptr; }
+
+      //! Replaces the value, discarding any value not yet decoded
+      void reset( std::unique_ptr<T> value = std::unique_ptr<T>() )
+      {
+        itsLoader = nullptr;
+        itsValue = std::move( value );
+      }
+
+      //! The value as it is serialized, decoding it if needed
+      /*! @internal */
+      std::unique_ptr<T> & pointer() const
+      {
+        decode();
+        return itsValue;
+      }
+
+      //! Replaces the value with one that loader decodes on first access
+      /*! @internal */
+      void defer( std::function<void( std::unique_ptr<T> & )> loader )
+      {
+        itsValue.reset();
+        itsLoader = std::move( loader );
+      }
+
+    private:
+      //! Decodes the value if it has not been
+      /*! If decoding throws, it is attempted again on the next access */
+      void decode() const
+      {
+        if( !itsLoader )
+          return;
+
+        itsLoader( itsValue );
+        itsLoader = nullptr;
+      }
+
+      mutable std::unique_ptr<T> itsValue;
+      mutable std::function<void( std::unique_ptr<T> & )> itsLoader; //!< Decodes the value, if not yet done
+  };
+
+  namespace deferred_detail
+  {
+    //! Whether an input archive provides the stream it reads from, can share it and can skip over it, so values can be loaded later
+    template <class Archive>
+    struct has_stream
+    {
+      template <class U> static auto test(int) -> decltype( std::declval<U &>().stream(), std::declval<U &>().sharedStream(), std::declval<U &>().skipBinary( 0 ), std::true_type() );
+      template <class>   static std::false_type test(...);
+      static const bool value = std::is_same<decltype(test<Archive>(0)), std::true_type>::value;
+    };
+
+    //! Decodes a value held in memory
+    template <class Archive, class T> inline
+    void defer_in_memory( Archive & ar, Deferred<T> & deferred, size_type length )
+    {
+      auto data = std::make_shared<std::string>( static_cast<std::size_t>( length ), '\0' );
+      if( length )
+        ar( binary_data( &(*data)[0], data->size() ) );
+
+      auto const resource = ar.memoryResource();
+      deferred.defer( [data, resource]( std::unique_ptr<T> & value )
+      {
+        detail::MemoryBuffer buffer( data->data(), data->size() );
+        std::istream stream( &buffer );
+        detail::load_in_sub_archive<Archive>( stream, resource, [&]( Archive & sub ){ sub( value ); } );
+      } );
+    }
+
+    //! Skips over a value, decoding it from the stream later, if the archive shares its stream and it can seek
+    template <class Archive, class T> inline
+    void defer( std::true_type, Archive & ar, Deferred<T> & deferred, size_type length )
+    {
+      std::shared_ptr<std::istream> owner = ar.sharedStream();
+      if( !owner || owner.get() != &ar.stream() )
+      {
+        defer_in_memory( ar, deferred, length );
+        return;
+      }
+
+      auto const position = owner->rdbuf()->pubseekoff( 0, std::ios::cur, std::ios::in );
+      if( position == std::streampos( -1 ) || !ar.skipBinary( static_cast<std::size_t>( length ) ) )
+      {
+        defer_in_memory( ar, deferred, length );
+        return;
+      }
+
+      auto const resource = ar.memoryResource();
+      deferred.defer( [owner, position, length, resource]( std::unique_ptr<T> & value )
+      {
+        std::streambuf * source = owner->rdbuf();
+        auto const resume = source->pubseekoff( 0, std::ios::cur, std::ios::in );
+        if( source->pubseekpos( position, std::ios::in ) == std::streampos( -1 ) )
+          throw Exception("Failed to seek to a deferred value");
+
+        try
+        {
+          detail::RangeBuffer buffer( source, length );
+          std::istream stream( &buffer );
+          detail::load_in_sub_archive<Archive>( stream, resource, [&]( Archive & sub ){ sub( value ); } );
+        }
+        catch( ... )
+        {
+          source->pubseekpos( resume, std::ios::in );
+          throw;
+        }
+
+        source->pubseekpos( resume, std::ios::in );
+      } );
+    }
+
+    //! Reads a value into memory when the archive does not provide its stream
+    template <class Archive, class T> inline
+    void defer( std::false_type, Archive & ar, Deferred<T> & deferred, size_type length )
+    {
+      defer_in_memory( ar, deferred, length );
+    }
+  } // namespace deferred_detail
+
+  //! Saving deferred values to binary archives
+  template <class Archive, class T> inline
+  typename std::enable_if<detail::is_sub_archive<Archive, std::ostream>::value, void>::type
+  CEREAL_SAVE_FUNCTION_NAME( Archive & ar, Deferred<T> const & deferred )
+  {
+    auto const payload = detail::save_in_sub_archive( ar, [&]( Archive & sub ){ sub( deferred.pointer() ); } );
+    ar( static_cast<size_type>( payload.size ) );
+    detail::save_sub_archive_output( ar, payload );
+  }
+
+  //! Loading deferred values from binary archives, without decoding them
+  template <class Archive, class T> inline
+  typename std::enable_if<detail::is_sub_archive<Archive, std::istream>::value, void>::type
+  CEREAL_LOAD_FUNCTION_NAME( Archive & ar, Deferred<T> & deferred )
+  {
+    size_type length;
+    ar( length );
+    deferred_detail::defer( std::integral_constant<bool, deferred_detail::has_stream<Archive>::value>(), ar, deferred, length );
+  }
+
+  //! Saving deferred values to other archives
+  template <class Archive, class T> inline
+  typename std::enable_if<!detail::is_sub_archive<Archive, std::ostream>::value, void>::type
+  CEREAL_SAVE_FUNCTION_NAME( Archive & ar, Deferred<T> const & deferred )
+  {
+    ar( CEREAL_NVP_("value", deferred.pointer()) );
+  }
+
+  //! Loading deferred values from other archives, which decodes them immediately
+  template <class Archive, class T> inline
+  typename std::enable_if<!detail::is_sub_archive<Archive, std::istream>::value, void>::type
+  CEREAL_LOAD_FUNCTION_NAME( Archive & ar, Deferred<T> & deferred )
+  {
+    std::unique_ptr<T> value;
+    ar( CEREAL_NVP_("value", value) );
+    deferred.reset( std::move( value ) );
+  }
+} // namespace cereal
+
+#endif // CEREAL_TYPES_DEFERRED_HPP_
@@ -47,16 +47,40 @@ namespace cereal
 
   //! Loading for std::deque
   template <class Archive, class T, class A> inline
-  void CEREAL_LOAD_FUNCTION_NAME( Archive & ar, std::deque<T, A> & deque )
+  typename std::enable_if<!detail::constructs_container_elements<T, Archive>::value, void>::type
+  CEREAL_LOAD_FUNCTION_NAME( Archive & ar, std::deque<T, A> & deque )
   {
     size_type size;
     ar( make_size_tag( size ) );
 
+    detail::adopt_memory_resource( ar, deque );
     deque.resize( static_cast<size_t>( size ) );
 
     for( auto & i : deque )
       ar( i );
   }
+
+  //! Loading for std::deque of movable types with load_and_construct
+  /*! Each element is constructed by load_and_construct and moved into place, rather
+      than default constructed and then loaded.  This applies to every movable type with
+      load_and_construct, so its member load or serialize, if any, is not used here.
+      See detail::constructs_container_elements */
+  template <class Archive, class T, class A> inline
+  typename std::enable_if<detail::constructs_container_elements<T, Archive>::value, void>::type
+  CEREAL_LOAD_FUNCTION_NAME( Archive & ar, std::deque<T, A> & deque )
+  {
+    size_type size;
+    ar( make_size_tag( size ) );
+
+    detail::adopt_memory_resource( ar, deque );
+    deque.clear();
+    for( size_type i = 0; i < size; ++i )
+    {
+      detail::ConstructedElement<Archive, T> element;
+      ar( element );
+      deque.emplace_back( std::move( element.get() ) );
+    }
+  }
 } // namespace cereal
 
 #endif // CEREAL_TYPES_DEQUE_HPP_
@@ -58,6 +58,7 @@ namespace cereal
     size_type size;
     ar( make_size_tag( size ) );
 
+    detail::adopt_memory_resource( ar, forward_list );
     forward_list.resize( static_cast<size_t>( size ) );
 
     for( auto & i : forward_list )
@@ -56,13 +56,14 @@ namespace cereal
       size_type size;
       ar( make_size_tag( size ) );
 
+      detail::adopt_memory_resource( ar, map );
       map.clear();
 
       auto hint = map.begin();
       for( size_t i = 0; i < size; ++i )
       {
-        typename MapT::key_type key;
-        typename MapT::mapped_type value;
+        auto key = detail::make_with_allocator<typename MapT::key_type>( map.get_allocator() );
+        auto value = detail::make_with_allocator<typename MapT::mapped_type>( map.get_allocator() );
 
         ar( make_map_item(key, value) );
         #ifdef CEREAL_OLDER_GCC
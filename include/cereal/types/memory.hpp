@@ -171,6 +171,107 @@ namespace cereal
       memory_detail::LoadAndConstructLoadWrapper<Archive, T> loadWrapper( ptr );
       ar( CEREAL_NVP_("data", loadWrapper) );
     }
+
+    //! Storage for the target of a loaded shared_ptr, allocated together with its reference count
+    /*! The target is constructed in place once loading allows it, and only destroyed
+        if that happened.
+        @internal */
+    template <class T>
+    struct SharedStorage
+    {
+      SharedStorage() : valid( false ) {}
+      SharedStorage( SharedStorage const & ) = delete;
+      SharedStorage & operator=( SharedStorage const & ) = delete;
+
+      ~SharedStorage()
+      {
+        if( valid )
+          get()->~T();
+      }
+
+      T * get()
+      {
+        return reinterpret_cast<T *>( &storage );
+      }
+
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+      bool valid; //!< Set once the target has been constructed
+    };
+
+    //! Allocates storage for the target of a shared_ptr, from the archive's memory resource if it has one
+    /*! @internal */
+    template <class T, class Archive> inline
+    std::shared_ptr<SharedStorage<T>> allocateSharedStorage( Archive & ar )
+    {
+      if( auto resource = ar.memoryResource() )
+        return std::allocate_shared<SharedStorage<T>>( ResourceAllocator<SharedStorage<T>>( resource ) );
+
+      return std::make_shared<SharedStorage<T>>();
+    }
+
+    //! Allocates storage for the target of a shared_ptr, which will be constructed later
+    /*! The target and its reference count share a single allocation.
+
+        @return Where to record that the target has been constructed
+        @internal */
+    template <class Archive, class T> inline
+    bool * allocateSharedPtr( Archive & ar, std::shared_ptr<T> & ptr, std::false_type /* has_shared_from_this */ )
+    {
+      auto storage = allocateSharedStorage<T>( ar );
+      ptr = std::shared_ptr<T>( storage, storage->get() );
+      return &storage->valid;
+    }
+
+    //! Allocates storage for the target of a shared_ptr derived from std::enable_shared_from_this
+    /*! The shared_ptr must take ownership of a raw pointer for shared_from_this to work,
+        so the target is allocated on its own, on the heap.
+
+        @return Where to record that the target has been constructed
+        @internal */
+    template <class Archive, class T> inline
+    bool * allocateSharedPtr( Archive &, std::shared_ptr<T> & ptr, std::true_type /* has_shared_from_this */ )
+    {
+      // Storage type for the pointer - since we can't default construct this type,
+      // we'll allocate it using std::aligned_storage and use a custom deleter
+      using ST = typename std::aligned_storage<sizeof(T)>::type;
+
+      // Valid flag - set to true once construction finishes
+      //  This prevents us from calling the destructor on
+      //  uninitialized data.
+      auto valid = std::make_shared<bool>( false );
+
+      // Allocate our storage, which we will treat as
+      //  uninitialized until initialized with placement new
+      ptr.reset( reinterpret_cast<T *>( new ST() ),
+          [=]( T * t )
+          {
+            if( *valid )
+              t->~T();
+
+            delete reinterpret_cast<ST *>( t );
+          } );
+
+      return valid.get();
+    }
+
+    //! Allocates and default constructs the target of a shared_ptr in a single allocation
+    /*! @internal */
+    template <class Archive, class T> inline
+    void constructSharedPtr( Archive & ar, std::shared_ptr<T> & ptr, std::false_type /* has_shared_from_this */ )
+    {
+      auto storage = allocateSharedStorage<T>( ar );
+      ::cereal::detail::Construct<T, Archive>::load_andor_construct( storage->get() );
+      storage->valid = true;
+      ptr = std::shared_ptr<T>( storage, storage->get() );
+    }
+
+    //! Allocates and default constructs the target of a shared_ptr derived from std::enable_shared_from_this
+    /*! @internal */
+    template <class Archive, class T> inline
+    void constructSharedPtr( Archive &, std::shared_ptr<T> & ptr, std::true_type /* has_shared_from_this */ )
+    {
+      ptr.reset( ::cereal::detail::Construct<T, Archive>::load_andor_construct() );
+    }
   } // end namespace memory_detail
 
   //! Saving std::shared_ptr for non polymorphic types
@@ -235,6 +336,17 @@ namespace cereal
     auto & ptr = wrapper.ptr;
 
     uint32_t id = ar.registerSharedPointer( ptr.get() );
+
+    if( ( id & detail::msb_32bit ) && ar.queuesPointees() )
+    {
+      // The second msb tells the loader that the data follows once its queue reaches it
+      ar( CEREAL_NVP_("id", id | detail::msb2_32bit) );
+
+      auto const target = ptr;
+      ar.queuePointee( [&ar, target]() { ar( CEREAL_NVP_("data", *target) ); } );
+      return;
+    }
+
     ar( CEREAL_NVP_("id", id) );
 
     if( id & detail::msb_32bit )
@@ -257,34 +369,27 @@ namespace cereal
 
     if( id & detail::msb_32bit )
     {
-      // Storage type for the pointer - since we can't default construct this type,
-      // we'll allocate it using std::aligned_storage and use a custom deleter
-      using ST = typename std::aligned_storage<sizeof(T)>::type;
-
-      // Valid flag - set to true once construction finishes
-      //  This prevents us from calling the destructor on
-      //  uninitialized data.
-      auto valid = std::make_shared<bool>( false );
-
       // Allocate our storage, which we will treat as
       //  uninitialized until initialized with placement new
-      ptr.reset( reinterpret_cast<T *>( new ST() ),
-          [=]( T * t )
-          {
-            if( valid )
-              t->~T();
-
-            delete reinterpret_cast<ST *>( t );
-          } );
+      bool * const valid = memory_detail::allocateSharedPtr( ar, ptr, typename ::cereal::traits::has_shared_from_this<T>::type() );
 
       // Register the pointer
       ar.registerSharedPointer( id, ptr );
 
-      // Perform the actual loading and allocation
-      memory_detail::loadAndConstructSharedPtr( ar, ptr.get(), typename ::cereal::traits::has_shared_from_this<T>::type() );
+      // Perform the actual loading and allocation, now or once the queue of targets reaches it
+      auto const target = ptr;
+      auto construct = [&ar, target, valid]()
+      {
+        memory_detail::loadAndConstructSharedPtr( ar, target.get(), typename ::cereal::traits::has_shared_from_this<T>::type() );
+
+        // Mark pointer as valid (initialized)
+        *valid = true;
+      };
 
-      // Mark pointer as valid (initialized)
-      *valid = true;
+      if( id & detail::msb2_32bit )
+        ar.queuePointee( construct );
+      else
+        construct();
     }
     else
       ptr = std::static_pointer_cast<T>(ar.getSharedPointer(id));
@@ -304,9 +409,16 @@ namespace cereal
 
     if( id & detail::msb_32bit )
     {
-      ptr.reset( detail::Construct<T, Archive>::load_andor_construct() );
+      memory_detail::constructSharedPtr( ar, ptr, typename ::cereal::traits::has_shared_from_this<T>::type() );
       ar.registerSharedPointer( id, ptr );
-      ar( CEREAL_NVP_("data", *ptr) );
+
+      if( id & detail::msb2_32bit ) // the data follows once the queue of targets reaches it
+      {
+        auto const target = ptr;
+        ar.queuePointee( [&ar, target]() { ar( CEREAL_NVP_("data", *target) ); } );
+      }
+      else
+        ar( CEREAL_NVP_("data", *ptr) );
     }
     else
       ptr = std::static_pointer_cast<T>(ar.getSharedPointer(id));
@@ -0,0 +1,226 @@
+/*! \file parallel.hpp
+    \brief Support for saving and loading large containers in parallel ranges
+    \ingroup OtherTypes */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES OR SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_TYPES_PARALLEL_HPP_
+#define CEREAL_TYPES_PARALLEL_HPP_
+
+#include <cereal/cereal.hpp>
+#include <cereal/details/parallel.hpp>
+#include <cereal/details/buffers.hpp>
+#include <cereal/details/sub_archive.hpp>
+
+#include <istream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace cereal
+{
+  //! A container that is saved and loaded in independent ranges, in parallel
+  /*! Created with make_parallel.
+      @internal */
+  template <class Container>
+  struct ParallelContainer
+  {
+    Container & container; //!< The container, which must support random access
+    ThreadPool * pool;     //!< The pool to use, if any
+    std::size_t rangeSize; //!< Elements per range, or zero to choose automatically
+  };
+
+  //! Saves or loads a container of independent objects in parallel
+  /*! With binary archives, the elements are split into ranges which are each serialized
+      by an archive of their own, on the given pool, into a private buffer.  The buffers are
+      then written one after another, preceded by a table of their sizes.  Loading resizes
+      the container up front, reads the buffers and loads the ranges concurrently.
+
+      Because each range has its own archive, pointers, polymorphic type names and class
+      versions are tracked separately for each range.  Saving throws an Exception if a
+      shared pointer target is reachable from elements in two different ranges or was
+      already saved earlier in the archive, since it would otherwise be loaded as two
+      separate objects.  Targets shared only within a single element are fine.  Targets
+      saved later in the archive cannot be checked and must not be shared with the elements.
+
+      The archives of the ranges are constructed with the same options as the archive
+      the container is saved to, and load into the same memory resource.  The sizing
+      archive counts exactly what the binary archives write.
+
+      The layout differs from that of the container itself, so data saved this way must
+      be loaded this way.  The range size is recorded, so loading may use a different
+      pool.  Text archives save and load the container as usual.
+
+      The container must support size(), resize() and random access iterators, and its
+      elements must be default constructible, as for std::vector and std::deque.
+
+      @code{.cpp}
+      cereal::ThreadPool pool;
+      cereal::BinaryOutputArchive ar( os );
+      ar( cereal::make_parallel( &pool, records ) );
+      @endcode
+
+      @param pool The pool to serialize on, or nullptr to serialize the ranges on the calling thread
+      @param container The container to serialize
+      @param rangeSize The number of elements in each range; by default there are a few ranges
+                       for each thread in the pool
+      @relates ParallelContainer */
+  template <class Container> inline
+  ParallelContainer<Container> make_parallel( ThreadPool * pool, Container & container, std::size_t rangeSize = 0 )
+  {
+    return { container, pool, rangeSize };
+  }
+
+  namespace parallel_detail
+  {
+    //! The number of elements in each range
+    inline size_type range_size( ThreadPool * pool, std::size_t count, std::size_t rangeSize )
+    {
+      if( rangeSize )
+        return rangeSize;
+
+      std::size_t const ranges = pool ? 4 * ( pool->size() + 1 ) : 1;
+      return std::max<std::size_t>( ( count + ranges - 1 ) / ranges, 1 );
+    }
+
+    //! The number of ranges needed for count elements
+    inline std::size_t range_count( size_type count, size_type rangeSize )
+    {
+      return static_cast<std::size_t>( count / rangeSize + ( count % rangeSize ? 1 : 0 ) );
+    }
+  } // namespace parallel_detail
+
+  //! Saving containers in parallel ranges to binary archives
+  template <class Archive, class Container> inline
+  typename std::enable_if<detail::is_sub_archive<Archive, std::ostream>::value, void>::type
+  CEREAL_SAVE_FUNCTION_NAME( Archive & ar, ParallelContainer<Container> const & parallel )
+  {
+    auto const & container = parallel.container;
+    size_type const count = container.size();
+    size_type const rangeSize = parallel_detail::range_size( parallel.pool, container.size(), parallel.rangeSize );
+    std::size_t const ranges = parallel_detail::range_count( count, rangeSize );
+
+    std::vector<detail::SubArchiveOutput> buffers( ranges );
+    std::vector<std::vector<void const *>> targets( ranges );
+
+    parallel_detail::for_each_chunk( parallel.pool, ranges, 1, [&]( std::size_t begin, std::size_t end )
+    {
+      for( std::size_t r = begin; r < end; ++r )
+      {
+        buffers[r] = detail::save_in_sub_archive( ar, [&]( Archive & sub )
+        {
+          auto const first = container.begin() + static_cast<std::ptrdiff_t>( r * rangeSize );
+          auto const last = container.begin() + static_cast<std::ptrdiff_t>( std::min( count, ( r + 1 ) * rangeSize ) );
+          for( auto iter = first; iter != last; ++iter )
+            sub( *iter );
+
+          sub.forEachSharedPointer( [&]( void const * addr ){ targets[r].push_back( addr ); } );
+        } );
+      }
+    } );
+
+    std::unordered_set<void const *> seen;
+    for( auto const & rangeTargets : targets )
+      for( auto addr : rangeTargets )
+        if( ar.isSharedPointerRegistered( addr ) || !seen.insert( addr ).second )
+          throw Exception("A shared pointer target in a parallel container is shared with another range or an earlier value");
+
+    ar( make_size_tag( count ) );
+    ar( rangeSize );
+    for( auto const & buffer : buffers )
+      ar( static_cast<size_type>( buffer.size ) );
+    for( auto const & buffer : buffers )
+      detail::save_sub_archive_output( ar, buffer );
+  }
+
+  //! Loading containers in parallel ranges from binary archives
+  template <class Archive, class Container> inline
+  typename std::enable_if<detail::is_sub_archive<Archive, std::istream>::value, void>::type
+  CEREAL_LOAD_FUNCTION_NAME( Archive & ar, ParallelContainer<Container> & parallel )
+  {
+    size_type count;
+    size_type rangeSize;
+    ar( make_size_tag( count ) );
+    ar( rangeSize );
+
+    if( count && !rangeSize )
+      throw Exception("Invalid range size for a parallel container");
+
+    std::size_t const ranges = count ? parallel_detail::range_count( count, rangeSize ) : 0;
+    std::vector<std::size_t> offsets( ranges + 1, 0 );
+    for( std::size_t r = 0; r < ranges; ++r )
+    {
+      size_type length;
+      ar( length );
+      offsets[r + 1] = offsets[r] + static_cast<std::size_t>( length );
+    }
+
+    std::string data( offsets.back(), '\0' );
+    if( !data.empty() )
+      ar( binary_data( &data[0], data.size() ) );
+
+    auto & container = parallel.container;
+    container.resize( static_cast<std::size_t>( count ) );
+
+    parallel_detail::for_each_chunk( parallel.pool, ranges, 1, [&]( std::size_t begin, std::size_t end )
+    {
+      for( std::size_t r = begin; r < end; ++r )
+      {
+        detail::MemoryBuffer buffer( data.data() + offsets[r], offsets[r + 1] - offsets[r] );
+        std::istream is( &buffer );
+        detail::load_in_sub_archive<Archive>( is, ar.memoryResource(), [&]( Archive & sub )
+        {
+          auto const first = container.begin() + static_cast<std::ptrdiff_t>( r * rangeSize );
+          auto const last = container.begin() + static_cast<std::ptrdiff_t>( std::min( count, ( r + 1 ) * rangeSize ) );
+          for( auto iter = first; iter != last; ++iter )
+            sub( *iter );
+        } );
+
+        if( buffer.in_avail() != 0 )
+          throw Exception("A range of a parallel container was not loaded completely");
+      }
+    } );
+  }
+
+  //! Saving containers as usual to archives without parallel support
+  template <class Archive, class Container> inline
+  typename std::enable_if<!detail::is_sub_archive<Archive, std::ostream>::value, void>::type
+  CEREAL_SAVE_FUNCTION_NAME( Archive & ar, ParallelContainer<Container> const & parallel )
+  {
+    ar( parallel.container );
+  }
+
+  //! Loading containers as usual from archives without parallel support
+  template <class Archive, class Container> inline
+  typename std::enable_if<!detail::is_sub_archive<Archive, std::istream>::value, void>::type
+  CEREAL_LOAD_FUNCTION_NAME( Archive & ar, ParallelContainer<Container> & parallel )
+  {
+    ar( parallel.container );
+  }
+} // namespace cereal
+
+#endif // CEREAL_TYPES_PARALLEL_HPP_
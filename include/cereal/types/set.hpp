@@ -54,12 +54,13 @@ namespace cereal
       size_type size;
       ar( make_size_tag( size ) );
 
+      detail::adopt_memory_resource( ar, set );
       set.clear();
 
       auto hint = set.begin();
       for( size_type i = 0; i < size; ++i )
       {
-        typename SetT::key_type key;
+        auto key = detail::make_with_allocator<typename SetT::key_type>( set.get_allocator() );
 
         ar( key );
         #ifdef CEREAL_OLDER_GCC
@@ -31,13 +31,28 @@
 #define CEREAL_TYPES_STRING_HPP_
 
 #include <cereal/cereal.hpp>
+#include <cereal/details/interning.hpp>
+#include <cstring>
 #include <string>
 
 namespace cereal
 {
+  namespace string_detail
+  {
+    //! Whether an archive can write repeated strings as references to earlier ones
+    template <class Archive>
+    struct interns_strings
+    {
+      template <class U> static auto test(int) -> decltype( std::declval<U &>().internString( static_cast<const void *>( nullptr ), std::size_t() ), std::true_type() );
+      template <class>   static std::false_type test(...);
+      static const bool value = std::is_same<decltype(test<Archive>(0)), std::true_type>::value;
+    };
+  } // namespace string_detail
+
   //! Serialization for basic_string types, if binary data is supported
   template<class Archive, class CharT, class Traits, class Alloc> inline
-  typename std::enable_if<traits::is_output_serializable<BinaryData<CharT>, Archive>::value, void>::type
+  typename std::enable_if<traits::is_output_serializable<BinaryData<CharT>, Archive>::value &&
+                          !string_detail::interns_strings<Archive>::value, void>::type
   CEREAL_SAVE_FUNCTION_NAME(Archive & ar, std::basic_string<CharT, Traits, Alloc> const & str)
   {
     // Save number of chars + the data
@@ -47,14 +62,64 @@ namespace cereal
 
   //! Serialization for basic_string types, if binary data is supported
   template<class Archive, class CharT, class Traits, class Alloc> inline
-  typename std::enable_if<traits::is_input_serializable<BinaryData<CharT>, Archive>::value, void>::type
+  typename std::enable_if<traits::is_input_serializable<BinaryData<CharT>, Archive>::value &&
+                          !string_detail::interns_strings<Archive>::value, void>::type
   CEREAL_LOAD_FUNCTION_NAME(Archive & ar, std::basic_string<CharT, Traits, Alloc> & str)
   {
     size_type size;
     ar( make_size_tag( size ) );
+    detail::adopt_memory_resource( ar, str );
     str.resize(static_cast<std::size_t>(size));
     ar( binary_data( const_cast<CharT *>( str.data() ), static_cast<std::size_t>(size) * sizeof(CharT) ) );
   }
+
+  //! Serialization for basic_string types, if the archive interns strings
+  /*! A string the archive has seen before is saved as a reference to the first copy;
+      the first copy is saved as usual, with a flag in its size so it is remembered on load */
+  template<class Archive, class CharT, class Traits, class Alloc> inline
+  typename std::enable_if<traits::is_output_serializable<BinaryData<CharT>, Archive>::value &&
+                          string_detail::interns_strings<Archive>::value, void>::type
+  CEREAL_SAVE_FUNCTION_NAME(Archive & ar, std::basic_string<CharT, Traits, Alloc> const & str)
+  {
+    auto const bytes = str.size() * sizeof(CharT);
+    auto const interned = ar.internString( str.data(), bytes );
+
+    if( interned & detail::interned_reference_flag )
+      ar( make_size_tag( interned ) );
+    else
+    {
+      ar( make_size_tag( static_cast<size_type>(str.size()) | interned ) );
+      ar( binary_data( str.data(), bytes ) );
+    }
+  }
+
+  //! Serialization for basic_string types, if the archive interns strings
+  template<class Archive, class CharT, class Traits, class Alloc> inline
+  typename std::enable_if<traits::is_input_serializable<BinaryData<CharT>, Archive>::value &&
+                          string_detail::interns_strings<Archive>::value, void>::type
+  CEREAL_LOAD_FUNCTION_NAME(Archive & ar, std::basic_string<CharT, Traits, Alloc> & str)
+  {
+    size_type size;
+    ar( make_size_tag( size ) );
+    detail::adopt_memory_resource( ar, str );
+
+    if( size & detail::interned_reference_flag ) // a copy of an earlier string
+    {
+      auto const & bytes = ar.internedString( size & ~detail::interned_reference_flag );
+      str.resize( bytes.size() / sizeof(CharT) );
+      std::memcpy( const_cast<CharT *>( str.data() ), bytes.data(), str.size() * sizeof(CharT) );
+      return;
+    }
+
+    bool const interned = ( size & detail::interned_string_flag ) != 0;
+    size &= ~detail::interned_string_flag;
+
+    str.resize(static_cast<std::size_t>(size));
+    ar( binary_data( const_cast<CharT *>( str.data() ), static_cast<std::size_t>(size) * sizeof(CharT) ) );
+
+    if( interned )
+      ar.internString( str.data(), static_cast<std::size_t>(size) * sizeof(CharT) );
+  }
 } // namespace cereal
 
 #endif // CEREAL_TYPES_STRING_HPP_
@@ -54,13 +54,14 @@ namespace cereal
       size_type size;
       ar( make_size_tag( size ) );
 
+      detail::adopt_memory_resource( ar, map );
       map.clear();
       map.reserve( static_cast<std::size_t>( size ) );
 
       for( size_type i = 0; i < size; ++i )
       {
-        typename MapT::key_type key;
-        typename MapT::mapped_type value;
+        auto key = detail::make_with_allocator<typename MapT::key_type>( map.get_allocator() );
+        auto value = detail::make_with_allocator<typename MapT::mapped_type>( map.get_allocator() );
 
         ar( make_map_item(key, value) );
         map.emplace( std::move( key ), std::move( value ) );
@@ -35,6 +35,64 @@
 
 namespace cereal
 {
+  namespace vector_detail
+  {
+    //! Whether an output archive can save vectors of arithmetic values as a single block
+    /*! Text archives provide saveArithmeticBlock for this, which reports whether the
+        block was used, see JSONOutputArchive::saveArithmeticBlock */
+    template <class Archive>
+    struct saves_arithmetic_blocks
+    {
+      template <class U> static auto test(int) -> decltype( std::declval<U &>().saveArithmeticBlock( static_cast<int const *>( nullptr ), std::size_t() ), std::true_type() );
+      template <class>   static std::false_type test(...);
+      static const bool value = std::is_same<decltype(test<Archive>(0)), std::true_type>::value;
+    };
+
+    //! Whether an input archive can load vectors of arithmetic values saved as a single block
+    template <class Archive>
+    struct loads_arithmetic_blocks
+    {
+      template <class U> static auto test(int) -> decltype( std::declval<U &>().loadArithmeticBlock( std::declval<std::vector<int> &>() ), std::true_type() );
+      template <class>   static std::false_type test(...);
+      static const bool value = std::is_same<decltype(test<Archive>(0)), std::true_type>::value;
+    };
+
+    //! Whether vectors of T are saved or loaded as blocks, given whether the archive supports them
+    template <class Blocks, class T>
+    struct uses_arithmetic_block : std::integral_constant<bool,
+      Blocks::value && std::is_arithmetic<T>::value && !std::is_same<T, bool>::value> {};
+
+    //! Saves a vector as a block
+    /*! @return false, without saving anything, if the archive did not enable blocks */
+    template <class Archive, class T, class A> inline
+    bool save_block( std::true_type, Archive & ar, std::vector<T, A> const & vector )
+    {
+      return ar.saveArithmeticBlock( vector.data(), vector.size() );
+    }
+
+    //! Archives without blocks save vectors element by element
+    template <class Archive, class T, class A> inline
+    bool save_block( std::false_type, Archive &, std::vector<T, A> const & )
+    {
+      return false;
+    }
+
+    //! Loads a vector saved as a block
+    /*! @return false, without loading anything, if the vector was saved element by element */
+    template <class Archive, class T, class A> inline
+    bool load_block( std::true_type, Archive & ar, std::vector<T, A> & vector )
+    {
+      return ar.loadArithmeticBlock( vector );
+    }
+
+    //! Archives without blocks load vectors element by element
+    template <class Archive, class T, class A> inline
+    bool load_block( std::false_type, Archive &, std::vector<T, A> & )
+    {
+      return false;
+    }
+  } // namespace vector_detail
+
   //! Serialization for std::vectors of arithmetic (but not bool) using binary serialization, if supported
   template <class Archive, class T, class A> inline
   typename std::enable_if<traits::is_output_serializable<BinaryData<T>, Archive>::value
@@ -54,27 +112,38 @@ namespace cereal
     size_type vectorSize;
     ar( make_size_tag( vectorSize ) );
 
+    detail::adopt_memory_resource( ar, vector );
     vector.resize( static_cast<std::size_t>( vectorSize ) );
     ar( binary_data( vector.data(), static_cast<std::size_t>( vectorSize ) * sizeof(T) ) );
   }
 
   //! Serialization for non-arithmetic vector types
+  /*! Arithmetic values are saved as a single block if the archive supports and enables it */
   template <class Archive, class T, class A> inline
   typename std::enable_if<!traits::is_output_serializable<BinaryData<T>, Archive>::value
                           || !std::is_arithmetic<T>::value, void>::type
   CEREAL_SAVE_FUNCTION_NAME( Archive & ar, std::vector<T, A> const & vector )
   {
+    if( vector_detail::save_block( vector_detail::uses_arithmetic_block<vector_detail::saves_arithmetic_blocks<Archive>, T>(), ar, vector ) )
+      return;
+
     ar( make_size_tag( static_cast<size_type>(vector.size()) ) ); // number of elements
     for(auto && v : vector)
       ar( v );
   }
 
   //! Serialization for non-arithmetic vector types
+  /*! Arithmetic values are loaded as a single block if they were saved as one */
   template <class Archive, class T, class A> inline
-  typename std::enable_if<!traits::is_input_serializable<BinaryData<T>, Archive>::value
-                          || !std::is_arithmetic<T>::value, void>::type
+  typename std::enable_if<( !traits::is_input_serializable<BinaryData<T>, Archive>::value
+                            || !std::is_arithmetic<T>::value )
+                          && !detail::constructs_container_elements<T, Archive>::value, void>::type
   CEREAL_LOAD_FUNCTION_NAME( Archive & ar, std::vector<T, A> & vector )
   {
+    detail::adopt_memory_resource( ar, vector );
+    if( vector_detail::load_block( vector_detail::uses_arithmetic_block<vector_detail::loads_arithmetic_blocks<Archive>, T>(), ar, vector ) )
+      return;
+
     size_type size;
     ar( make_size_tag( size ) );
 
@@ -83,6 +152,29 @@ namespace cereal
       ar( v );
   }
 
+  //! Serialization for vectors of movable types with load_and_construct
+  /*! Each element is constructed by load_and_construct and moved into place, rather
+      than default constructed and then loaded.  This applies to every movable type with
+      load_and_construct, so its member load or serialize, if any, is not used here.
+      See detail::constructs_container_elements */
+  template <class Archive, class T, class A> inline
+  typename std::enable_if<detail::constructs_container_elements<T, Archive>::value, void>::type
+  CEREAL_LOAD_FUNCTION_NAME( Archive & ar, std::vector<T, A> & vector )
+  {
+    size_type size;
+    ar( make_size_tag( size ) );
+
+    detail::adopt_memory_resource( ar, vector );
+    vector.clear();
+    vector.reserve( static_cast<std::size_t>( size ) );
+    for( size_type i = 0; i < size; ++i )
+    {
+      detail::ConstructedElement<Archive, T> element;
+      ar( element );
+      vector.emplace_back( std::move( element.get() ) );
+    }
+  }
+
   //! Serialization for bool vector types
   template <class Archive, class A> inline
   void CEREAL_SAVE_FUNCTION_NAME( Archive & ar, std::vector<bool, A> const & vector )
@@ -99,6 +191,7 @@ namespace cereal
     size_type size;
     ar( make_size_tag( size ) );
 
+    detail::adopt_memory_resource( ar, vector );
     vector.resize( static_cast<std::size_t>( size ) );
     for(auto && v : vector)
     {
@@ -29,210 +29,85 @@
 #  pragma warning(disable : 4244 4267)
 #endif
 
-#include <sstream>
-#include <iostream>
-#include <chrono>
-#include <random>
-
-#include <boost/format.hpp>
-
-#include <boost/serialization/serialization.hpp>
-#include <boost/archive/binary_oarchive.hpp>
-#include <boost/archive/binary_iarchive.hpp>
-#include <boost/serialization/vector.hpp>
-#include <boost/serialization/map.hpp>
-#include <boost/serialization/string.hpp>
-#include <boost/serialization/base_object.hpp>
+#include "performance.hpp"
 
 #include <cereal/archives/binary.hpp>
-#include <cereal/types/vector.hpp>
-#include <cereal/types/string.hpp>
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/archives/json.hpp>
+#include <cereal/archives/xml.hpp>
+
+#include <cereal/types/array.hpp>
+#include <cereal/types/base_class.hpp>
+#include <cereal/types/bitset.hpp>
+#include <cereal/types/chrono.hpp>
+#include <cereal/types/common.hpp>
+#include <cereal/types/complex.hpp>
+#include <cereal/types/deque.hpp>
+#include <cereal/types/forward_list.hpp>
+#include <cereal/types/list.hpp>
 #include <cereal/types/map.hpp>
+#include <cereal/types/memory.hpp>
+#include <cereal/types/polymorphic.hpp>
+#include <cereal/types/queue.hpp>
+#include <cereal/types/set.hpp>
+#include <cereal/types/stack.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/tuple.hpp>
+#include <cereal/types/unordered_map.hpp>
+#include <cereal/types/unordered_set.hpp>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/valarray.hpp>
+#include <cereal/types/vector.hpp>
 
-//! Runs serialization to save data to an ostringstream
-/*! Used to time how long it takes to save data to an ostringstream.
-    Everything that happens within the save function will be timed, including
-    any set-up necessary to perform the serialization.
-
-    @param data The data to save
-    @param saveFunction A function taking in an ostringstream and the data and returning void
-    @return The ostringstream and the time it took to save the data */
-template <class T>
-std::chrono::nanoseconds
-saveData( T const & data, std::function<void(std::ostringstream &, T const&)> saveFunction, std::ostringstream & os )
-{
-  auto start = std::chrono::high_resolution_clock::now();
-  saveFunction( os, data );
-  return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::high_resolution_clock::now() - start );
-}
+#include <limits>
+#include <random>
 
-//! Runs serialization to load data to from an istringstream
-/*! Used to time how long it takes to load data from an istringstream.
-    Everything that happens within the load function will be timed, including
-    any set-up necessary to perform the serialization.
+// ######################################################################
+// Archives under test
 
-    @param dataStream The saved data stream
-    @param loadFunction A function taking in an istringstream and a data reference and returning void
-    @return The loaded data and the time it took to save the data */
-template <class T>
-std::pair<T, std::chrono::nanoseconds>
-loadData( std::ostringstream const & dataStream, std::function<void(std::istringstream &, T &)> loadFunction )
+struct Binary
 {
-  T data;
-  std::istringstream os( dataStream.str() );
-
-  auto start = std::chrono::high_resolution_clock::now();
-  loadFunction( os, data );
-
-  return {data, std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::high_resolution_clock::now() - start )};
-}
+  typedef cereal::BinaryOutputArchive OutputArchive;
+  typedef cereal::BinaryInputArchive InputArchive;
+  static std::string name() { return "binary"; }
+};
 
-struct cerealBinary
+struct PortableBinary
 {
-  //! Saves data to a cereal binary archive
-  template <class T>
-  static void save( std::ostringstream & os, T const & data )
-  {
-    cereal::BinaryOutputArchive oar(os);
-    oar(data);
-  }
-
-  //! Loads data to a cereal binary archive
-  template <class T>
-  static void load( std::istringstream & is, T & data )
-  {
-    cereal::BinaryInputArchive iar(is);
-    iar(data);
-  }
+  typedef cereal::PortableBinaryOutputArchive OutputArchive;
+  typedef cereal::PortableBinaryInputArchive InputArchive;
+  static std::string name() { return "portable"; }
 };
 
-struct boostBinary
+struct JSON
 {
-  //! Saves data to a boost binary archive
-  template <class T>
-  static void save( std::ostringstream & os, T const & data )
-  {
-    boost::archive::binary_oarchive oar(os);
-    oar & data;
-  }
-
-  //! Loads data to a boost binary archive
-  template <class T>
-  static void load( std::istringstream & is, T & data )
-  {
-    boost::archive::binary_iarchive iar(is);
-    iar & data;
-  }
+  typedef cereal::JSONOutputArchive OutputArchive;
+  typedef cereal::JSONInputArchive InputArchive;
+  static std::string name() { return "json"; }
 };
 
-struct binary
+struct XML
 {
-  typedef boostBinary  boost;
-  typedef cerealBinary cereal;
+  typedef cereal::XMLOutputArchive OutputArchive;
+  typedef cereal::XMLInputArchive InputArchive;
+  static std::string name() { return "xml"; }
 };
 
-//! Times how long it takes to serialize (load and store) some data
-/*! Times how long and the size of the serialization object used to serialize
-    some data.  Result is output to standard out.
-
-    @tparam SerializationT The serialization struct that has all save and load functions
-    @tparam DataTCereal The type of data to test for cereal
-    @tparam DataTBoost The type of data to test for boost
-    @param name The name for this test
-    @param data The data to serialize for cereal
-    @param data The data to serialize for boost
-    @param numAverages The number of times to average
-    @param validateData Whether data should be validated (input == output) */
-template <class SerializationT, class DataTCereal, class DataTBoost>
-void test( std::string const & name,
-            DataTCereal const & dataC,
-            DataTBoost const & dataB,
-            size_t numAverages = 100,
-            bool validateData = false );
-
-template <class SerializationT, class DataTCereal, class DataTBoost>
-void test( std::string const & name,
-            DataTCereal const & dataC,
-            DataTBoost const & dataB,
-            size_t numAverages,
-            bool /*validateData*/ )
+//! Adds benchmarks of a data set with every archive
+template <class T>
+void addAll( benchmark::Runner & runner, std::string const & name, T && data, std::size_t objects )
 {
-  std::cout << "-----------------------------------" << std::endl;
-  std::cout << "Running test: " << name << std::endl;
-
-  std::chrono::nanoseconds totalBoostSave{0};
-  std::chrono::nanoseconds totalBoostLoad{0};
-
-  std::chrono::nanoseconds totalCerealSave{0};
-  std::chrono::nanoseconds totalCerealLoad{0};
-
-  size_t boostSize = 0;
-  size_t cerealSize = 0;
-
-  for(size_t i = 0; i < numAverages; ++i)
-  {
-    // Boost
-    {
-      std::ostringstream os;
-      auto saveResult = saveData<DataTBoost>( dataB, {SerializationT::boost::template save<DataTBoost>}, os );
-      totalBoostSave += saveResult;
-      if(!boostSize)
-        boostSize = os.tellp();
-
-      auto loadResult = loadData<DataTBoost>( os, {SerializationT::boost::template load<DataTBoost>} );
-      totalBoostLoad += loadResult.second;
-    }
-
-    // Cereal
-    {
-      std::ostringstream os;
-      auto saveResult = saveData<DataTCereal>( dataC, {SerializationT::cereal::template save<DataTCereal>}, os );
-      totalCerealSave += saveResult;
-      if(!cerealSize)
-        cerealSize = os.tellp();
-
-      auto loadResult = loadData<DataTCereal>( os, {SerializationT::cereal::template load<DataTCereal>} );
-      totalCerealLoad += loadResult.second;
-    }
-  }
+  typedef typename std::decay<T>::type DataType;
+  std::shared_ptr<DataType const> shared = std::make_shared<DataType>( std::forward<T>( data ) );
 
-  // Averages
-  double averageBoostSave = std::chrono::duration_cast<std::chrono::milliseconds>(totalBoostSave).count() / static_cast<double>( numAverages );
-  double averageBoostLoad = std::chrono::duration_cast<std::chrono::milliseconds>(totalBoostLoad).count() / static_cast<double>( numAverages );
-
-  double averageCerealSave = std::chrono::duration_cast<std::chrono::milliseconds>(totalCerealSave).count() / static_cast<double>( numAverages );
-  double averageCerealLoad = std::chrono::duration_cast<std::chrono::milliseconds>(totalCerealLoad).count() / static_cast<double>( numAverages );
-
-  // Percentages relative to boost
-  double cerealSaveP = averageCerealSave / averageBoostSave;
-  double cerealLoadP = averageCerealLoad / averageBoostLoad;
-  double cerealSizeP = cerealSize / static_cast<double>( boostSize );
-
-  std::cout << "  Boost results:" << std::endl;
-  std::cout << boost::format("\tsave | time: %06.4fms (%1.2f) size: %20.8fkb (%1.8f) total: %6.1fms")
-    % averageBoostSave % 1.0 % (boostSize / 1024.0) % 1.0 % static_cast<double>( std::chrono::duration_cast<std::chrono::milliseconds>(totalBoostSave).count() );
-  std::cout << std::endl;
-  std::cout << boost::format("\tload | time: %06.4fms (%1.2f) total: %6.1fms")
-    % averageBoostLoad % 1.0 % static_cast<double>( std::chrono::duration_cast<std::chrono::milliseconds>(totalBoostLoad).count() );
-  std::cout << std::endl;
-
-  std::cout << "  Cereal results:" << std::endl;
-  std::cout << boost::format("\tsave | time: %06.4fms (%1.2f) size: %20.8fkb (%1.8f) total: %6.1fms")
-    % averageCerealSave % cerealSaveP % (cerealSize / 1024.0) % cerealSizeP % static_cast<double>( std::chrono::duration_cast<std::chrono::milliseconds>(totalCerealSave).count() );
-  std::cout << std::endl;
-  std::cout << boost::format("\tload | time: %06.4fms (%1.2f) total: %6.1fms")
-    % averageCerealLoad % cerealLoadP % static_cast<double>( std::chrono::duration_cast<std::chrono::milliseconds>(totalCerealLoad).count() );
-  std::cout << std::endl;
+  runner.add<Binary>( name, shared, objects );
+  runner.add<PortableBinary>( name, shared, objects );
+  runner.add<JSON>( name, shared, objects );
+  runner.add<XML>( name, shared, objects );
 }
 
-template <class SerializationT, class DataT>
-void test( std::string const & name,
-            DataT const & data,
-            size_t numAverages = 100,
-            bool validateData = false )
-{
-  return test<SerializationT, DataT, DataT>( name, data, data, numAverages, validateData );
-}
+// ######################################################################
+// Random data
 
 template<class T>
 typename std::enable_if<std::is_floating_point<T>::value, T>::type
@@ -255,30 +130,22 @@ random_value(std::mt19937 & gen)
 {
   std::string s(std::uniform_int_distribution<int>(3, 30)(gen), ' ');
   for(char & c : s)
-    c = std::uniform_int_distribution<char>(' ', '~')(gen);
+    c = static_cast<char>( std::uniform_int_distribution<int>('a', 'z')(gen) );
   return s;
 }
 
-template<class C>
-std::basic_string<C> random_basic_string(std::mt19937 & gen, size_t maxSize = 30)
+//! Fills a container of size elements through an inserter
+template <class T, class Inserter>
+void fill( std::mt19937 & gen, std::size_t size, Inserter inserter )
 {
-  std::basic_string<C> s(std::uniform_int_distribution<int>(3, maxSize)(gen), ' ');
-  for(C & c : s)
-    c = static_cast<C>( std::uniform_int_distribution<int>( '~', '~' )(gen) );
-  return s;
-  return s;
+  for( std::size_t i = 0; i < size; ++i )
+    *inserter++ = random_value<T>( gen );
 }
 
-template <size_t N>
-std::string random_binary_string(std::mt19937 & gen)
-{
-  std::string s(N, ' ');
-  for(auto & c : s )
-    c = std::uniform_int_distribution<char>('0', '1')(gen);
-  return s;
-}
+// ######################################################################
+// User types
 
-struct PoDStructCereal
+struct PoDStruct
 {
   int32_t a;
   int64_t b;
@@ -288,178 +155,411 @@ struct PoDStructCereal
   template <class Archive>
   void serialize( Archive & ar )
   {
-    ar(a, b, c, d);
+    ar( CEREAL_NVP(a), CEREAL_NVP(b), CEREAL_NVP(c), CEREAL_NVP(d) );
   }
 };
 
-struct PoDStructBoost
+struct PoDChild : virtual PoDStruct
 {
-  int32_t a;
-  int64_t b;
-  float c;
-  double d;
+  PoDChild() : v(64)
+  { }
+
+  std::vector<float> v;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( cereal::virtual_base_class<PoDStruct>(this), CEREAL_NVP(v) );
+  }
+};
+
+//! A class that stores its version alongside its data
+struct Versioned
+{
+  int32_t x = 0;
+  double y = 0;
+  std::string z;
 
   template <class Archive>
-  void serialize( Archive & ar, const unsigned int /*version*/ )
+  void serialize( Archive & ar, std::uint32_t const version )
   {
-    ar & a & b & c & d;
+    ar( CEREAL_NVP(x), CEREAL_NVP(y) );
+    if( version > 1 )
+      ar( CEREAL_NVP(z) );
   }
 };
 
-struct PoDChildCereal : virtual PoDStructCereal
+CEREAL_CLASS_VERSION( Versioned, 2 )
+
+//! A comparator with a serialize function, since text archives cannot elide empty classes
+struct Greater
 {
-  PoDChildCereal() : v(1024)
+  bool operator()( int32_t a, int32_t b ) const { return a > b; }
+
+  template <class Archive>
+  void serialize( Archive & )
   { }
+};
 
-  std::vector<float> v;
+enum class Color { Red, Green, Blue };
+
+//! A node in a directed acyclic graph of shared pointers
+struct Node
+{
+  int32_t value = 0;
+  std::vector<std::shared_ptr<Node>> edges;
 
   template <class Archive>
   void serialize( Archive & ar )
   {
-    ar( cereal::virtual_base_class<PoDStructCereal>(this), v );
+    ar( CEREAL_NVP(value), CEREAL_NVP(edges) );
   }
 };
 
-struct PoDChildBoost : virtual PoDStructBoost
+struct Shape
 {
-  PoDChildBoost() : v(1024)
-  { }
+  virtual ~Shape() {}
+  virtual double area() const = 0;
+};
 
-  std::vector<float> v;
+struct Circle : Shape
+{
+  double radius = 0;
+  double area() const override { return radius * radius * 3.14159265358979; }
 
   template <class Archive>
-  void serialize( Archive & ar, const unsigned int /*version*/ )
+  void serialize( Archive & ar )
   {
-    ar & boost::serialization::base_object<PoDStructBoost>(*this);
-    ar & v;
+    ar( CEREAL_NVP(radius) );
   }
 };
 
-int main()
+struct Rectangle : Shape
 {
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  auto rngC = [&](){ return random_value<uint8_t>(gen); };
-  auto rngD = [&](){ return random_value<double>(gen); };
-  const bool randomize = false;
+  double width = 0;
+  double height = 0;
+  double area() const override { return width * height; }
 
-  //########################################
-  auto vectorDoubleTest = [&](size_t s, bool randomize_)
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( CEREAL_NVP(width), CEREAL_NVP(height) );
+  }
+};
+
+CEREAL_REGISTER_TYPE(Circle)
+CEREAL_REGISTER_TYPE(Rectangle)
+
+// ######################################################################
+int main( int argc, char ** argv )
+{
+  benchmark::Settings settings;
+  try
+  {
+    settings = benchmark::Settings::parse( argc, argv );
+  }
+  catch( std::runtime_error const & e )
+  {
+    if( *e.what() )
+      std::cerr << e.what() << std::endl;
+    benchmark::Settings::usage( std::cerr, argv[0] );
+    return *e.what() ? 1 : 0;
+  }
+
+  std::unique_ptr<benchmark::Runner> runnerPtr;
+  try
+  {
+    runnerPtr.reset( new benchmark::Runner( settings ) );
+  }
+  catch( std::runtime_error const & e )
   {
-    std::ostringstream name;
-    name << "Vector(double) size " << s;
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
 
-    std::vector<double> data(s);
-    if(randomize_)
-      for( auto & d : data )
-        d = rngD();
+  benchmark::Runner & runner = *runnerPtr;
 
-    test<binary>( name.str(), data );
-  };
+  // A fixed seed keeps output sizes stable from run to run
+  std::mt19937 gen( 5489u );
 
-  vectorDoubleTest(1, randomize); // 8B
-  vectorDoubleTest(16, randomize); // 128B
-  vectorDoubleTest(1024, randomize); // 8KB
-  vectorDoubleTest(1024*1024, randomize); // 8MB
+  std::size_t const small = 1024;
+  std::size_t const large = 64 * 1024;
 
   //########################################
-  auto vectorCharTest = [&](size_t s, bool randomize_)
+  // Arithmetic and strings
   {
-    std::ostringstream name;
-    name << "Vector(uint8_t) size " << s;
+    std::vector<double> data;
+    fill<double>( gen, large, std::back_inserter( data ) );
+    addAll( runner, "vector<double>", std::move( data ), data.size() );
+  }
 
-    std::vector<uint8_t> data(s);
-    if(randomize_)
-      for( auto & d : data )
-        d = rngC();
+  {
+    std::vector<uint8_t> data;
+    fill<uint8_t>( gen, 256 * 1024, std::back_inserter( data ) );
+    addAll( runner, "vector<uint8_t>", std::move( data ), data.size() );
+  }
 
-    test<binary>( name.str(), data );
-  };
+  {
+    std::vector<int32_t> data;
+    fill<int32_t>( gen, large, std::back_inserter( data ) );
+    addAll( runner, "vector<int32_t>", std::move( data ), data.size() );
+  }
 
-  vectorCharTest(1024*1024*64, randomize);
+  {
+    std::string data( 1024 * 1024, ' ' );
+    for( auto & c : data )
+      c = static_cast<char>( std::uniform_int_distribution<int>( 'a', 'z' )( gen ) );
+    addAll( runner, "string", std::move( data ), 1 );
+  }
+
+  {
+    std::vector<std::string> data;
+    fill<std::string>( gen, small * 8, std::back_inserter( data ) );
+    addAll( runner, "vector<string>", std::move( data ), data.size() );
+  }
 
   //########################################
-  auto vectorPoDStructTest = [&](size_t s)
+  // Standard library containers
   {
-    std::ostringstream name;
-    name << "Vector(PoDStruct) size " << s;
+    std::array<float, 1024> data;
+    fill<float>( gen, data.size(), data.begin() );
+    addAll( runner, "array<float>", std::move( data ), data.size() );
+  }
 
-    std::vector<PoDStructCereal> dataC(s);
-    std::vector<PoDStructBoost> dataB(s);
-    test<binary>( name.str(), dataC, dataB );
-  };
+  {
+    std::vector<std::bitset<256>> data( small );
+    for( auto & b : data )
+      for( std::size_t i = 0; i < b.size(); ++i )
+        b[i] = gen() & 1;
+    addAll( runner, "vector<bitset<256>>", std::move( data ), data.size() );
+  }
 
-  vectorPoDStructTest(1);
-  vectorPoDStructTest(64);
-  vectorPoDStructTest(1024);
-  vectorPoDStructTest(1024*1024);
-  vectorPoDStructTest(1024*1024*2);
+  {
+    std::vector<std::chrono::nanoseconds> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data.emplace_back( random_value<int64_t>( gen ) );
+    addAll( runner, "vector<chrono::duration>", std::move( data ), data.size() );
+  }
+
+  {
+    std::vector<std::complex<double>> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data.emplace_back( random_value<double>( gen ), random_value<double>( gen ) );
+    addAll( runner, "vector<complex<double>>", std::move( data ), data.size() );
+  }
+
+  {
+    std::deque<int32_t> data;
+    fill<int32_t>( gen, large, std::back_inserter( data ) );
+    addAll( runner, "deque<int32_t>", std::move( data ), data.size() );
+  }
 
-  //########################################
-  auto vectorPoDChildTest = [&](size_t s)
   {
-    std::ostringstream name;
-    name << "Vector(PoDChild) size " << s;
+    std::forward_list<double> data;
+    fill<double>( gen, small * 8, std::front_inserter( data ) );
+    addAll( runner, "forward_list<double>", std::move( data ), small * 8 );
+  }
 
-    std::vector<PoDChildCereal> dataC(s);
-    std::vector<PoDChildBoost> dataB(s);
-    test<binary>( name.str(), dataC, dataB );
-  };
+  {
+    std::list<std::string> data;
+    fill<std::string>( gen, small * 8, std::back_inserter( data ) );
+    addAll( runner, "list<string>", std::move( data ), data.size() );
+  }
 
-  vectorPoDChildTest(1024);
-  vectorPoDChildTest(1024*32);
+  {
+    std::map<std::string, PoDStruct> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data[std::to_string( i )] = PoDStruct{ random_value<int32_t>( gen ), random_value<int64_t>( gen ),
+                                              random_value<float>( gen ), random_value<double>( gen ) };
+    addAll( runner, "map<string,PoDStruct>", std::move( data ), data.size() );
+  }
+
+  {
+    std::multimap<int32_t, double> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data.emplace( static_cast<int32_t>( i / 4 ), random_value<double>( gen ) );
+    addAll( runner, "multimap<int32_t,double>", std::move( data ), data.size() );
+  }
 
-  //########################################
-  auto stringTest = [&](size_t s)
   {
-    std::ostringstream name;
-    name << "String size " << s;
+    std::queue<int32_t> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data.push( random_value<int32_t>( gen ) );
+    addAll( runner, "queue<int32_t>", std::move( data ), data.size() );
+  }
 
-    std::string data = random_basic_string<char>(gen, s);
-    std::cout << "data.size " << data.size() << std::endl;
-    test<binary>( name.str(), data );
-  };
+  {
+    std::priority_queue<int32_t, std::vector<int32_t>, Greater> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data.push( random_value<int32_t>( gen ) );
+    addAll( runner, "priority_queue<int32_t>", std::move( data ), data.size() );
+  }
 
-  stringTest(200000);
-  stringTest(2000000);
-  stringTest(20000000);
+  {
+    std::stack<double> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data.push( random_value<double>( gen ) );
+    addAll( runner, "stack<double>", std::move( data ), data.size() );
+  }
+
+  {
+    std::set<std::string> data;
+    fill<std::string>( gen, small * 8, std::inserter( data, data.end() ) );
+    addAll( runner, "set<string>", std::move( data ), data.size() );
+  }
+
+  {
+    std::vector<std::tuple<int32_t, double, std::string>> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data.emplace_back( random_value<int32_t>( gen ), random_value<double>( gen ), random_value<std::string>( gen ) );
+    addAll( runner, "vector<tuple>", std::move( data ), data.size() );
+  }
+
+  {
+    std::unordered_map<uint32_t, std::string> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data[static_cast<uint32_t>( i )] = random_value<std::string>( gen );
+    addAll( runner, "unordered_map<uint32_t,string>", std::move( data ), data.size() );
+  }
+
+  {
+    std::unordered_set<int64_t> data;
+    fill<int64_t>( gen, small * 8, std::inserter( data, data.end() ) );
+    addAll( runner, "unordered_set<int64_t>", std::move( data ), data.size() );
+  }
+
+  {
+    std::vector<std::pair<int32_t, std::string>> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data.emplace_back( random_value<int32_t>( gen ), random_value<std::string>( gen ) );
+    addAll( runner, "vector<pair>", std::move( data ), data.size() );
+  }
+
+  {
+    std::valarray<double> data( large );
+    for( auto & d : data )
+      d = random_value<double>( gen );
+    addAll( runner, "valarray<double>", std::move( data ), data.size() );
+  }
 
-  //########################################
-  auto vectorStringTest = [&](size_t s)
   {
-    std::ostringstream name;
-    name << "Vector(String) size " << s;
+    std::vector<Color> data;
+    for( std::size_t i = 0; i < large; ++i )
+      data.push_back( static_cast<Color>( gen() % 3 ) );
+    addAll( runner, "vector<enum>", std::move( data ), data.size() );
+  }
 
-    std::vector<std::string> data(s);
-    for(size_t i=0; i<data.size(); ++i)
-      data[i] = random_basic_string<char>(gen);
+  //########################################
+  // User types
+  {
+    std::vector<PoDStruct> data( small * 8 );
+    for( auto & p : data )
+      p = PoDStruct{ random_value<int32_t>( gen ), random_value<int64_t>( gen ),
+                     random_value<float>( gen ), random_value<double>( gen ) };
+    addAll( runner, "vector<PoDStruct>", std::move( data ), data.size() );
+  }
 
-    test<binary>( name.str(), data );
-  };
+  {
+    std::vector<PoDChild> data( small );
+    for( auto & p : data )
+    {
+      p.a = random_value<int32_t>( gen );
+      p.b = random_value<int64_t>( gen );
+      p.c = random_value<float>( gen );
+      p.d = random_value<double>( gen );
+      for( auto & f : p.v )
+        f = random_value<float>( gen );
+    }
+    addAll( runner, "vector<PoDChild>", std::move( data ), data.size() );
+  }
 
-  vectorStringTest(512);
-  vectorStringTest(1024);
-  vectorStringTest(1024*64);
-  vectorStringTest(1024*128);
+  {
+    std::vector<Versioned> data( small * 8 );
+    for( auto & v : data )
+    {
+      v.x = random_value<int32_t>( gen );
+      v.y = random_value<double>( gen );
+      v.z = random_value<std::string>( gen );
+    }
+    addAll( runner, "vector<Versioned>", std::move( data ), data.size() );
+  }
 
   //########################################
-  auto mapPoDStructTest = [&](size_t s)
+  // Pointers
+  {
+    std::vector<std::unique_ptr<int64_t>> data;
+    for( std::size_t i = 0; i < small * 8; ++i )
+      data.emplace_back( new int64_t( random_value<int64_t>( gen ) ) );
+    addAll( runner, "vector<unique_ptr<int64_t>>", std::move( data ), data.size() );
+  }
+
+  {
+    // Each node points at a few earlier nodes, so most pointers are back references
+    std::vector<std::shared_ptr<Node>> data;
+    for( std::size_t i = 0; i < small * 4; ++i )
+    {
+      auto node = std::make_shared<Node>();
+      node->value = random_value<int32_t>( gen );
+      for( std::size_t e = 0; e < 3 && !data.empty(); ++e )
+        node->edges.push_back( data[gen() % data.size()] );
+      data.push_back( node );
+    }
+    addAll( runner, "shared_ptr graph", std::move( data ), data.size() );
+  }
+
   {
-    std::ostringstream name;
-    name << "Map(PoDStruct) size " <<s;
+    std::vector<std::unique_ptr<Shape>> data;
+    for( std::size_t i = 0; i < small * 4; ++i )
+    {
+      if( i % 2 )
+      {
+        std::unique_ptr<Circle> c( new Circle );
+        c->radius = random_value<double>( gen );
+        data.emplace_back( std::move( c ) );
+      }
+      else
+      {
+        std::unique_ptr<Rectangle> r( new Rectangle );
+        r->width = random_value<double>( gen );
+        r->height = random_value<double>( gen );
+        data.emplace_back( std::move( r ) );
+      }
+    }
+    addAll( runner, "polymorphic unique_ptr", std::move( data ), data.size() );
+  }
 
-    std::map<std::string, PoDStructCereal> mC;
-    std::map<std::string, PoDStructBoost> mB;
-    for(size_t i=0; i<s; ++i)
+  {
+    std::vector<std::shared_ptr<Shape>> data;
+    for( std::size_t i = 0; i < small * 4; ++i )
     {
-      mC[std::to_string( i )] = PoDStructCereal();
-      mB[std::to_string( i )] = PoDStructBoost();
+      // Every other entry repeats an earlier pointer
+      if( i % 2 && !data.empty() )
+        data.push_back( data[gen() % data.size()] );
+      else
+      {
+        auto c = std::make_shared<Circle>();
+        c->radius = random_value<double>( gen );
+        data.push_back( c );
+      }
     }
-    test<binary>(name.str(), mC, mB);
-  };
+    addAll( runner, "polymorphic shared_ptr", std::move( data ), data.size() );
+  }
+
+  runner.run();
+
+  if( !settings.jsonPath.empty() )
+  {
+    std::ofstream os( settings.jsonPath );
+    runner.writeJSON( os );
+    if( !os )
+    {
+      std::cerr << "Failed to write " << settings.jsonPath << std::endl;
+      return 1;
+    }
+  }
 
-  mapPoDStructTest(1024);
-  mapPoDStructTest(1024*64);
+  if( !settings.baselinePath.empty() && !settings.list )
+    return runner.compare( std::cout ) ? 1 : 0;
 
   return 0;
 }
@@ -0,0 +1,725 @@
+/*! \file performance.hpp
+    \brief Benchmark harness used by the cereal performance suite
+
+    Provides timing, statistics, and result reporting for the benchmarks in
+    performance.cpp, and comparison of results against a saved baseline.  Apart from the
+    rapidjson bundled with cereal, used to read baselines, only the standard library is needed.
+    \ingroup Sandbox */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_SANDBOX_PERFORMANCE_HPP_
+#define CEREAL_SANDBOX_PERFORMANCE_HPP_
+
+#include <cereal/archives/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace benchmark
+{
+  // ######################################################################
+  //! An output stream buffer that keeps its storage between runs
+  /*! std::ostringstream gives up its buffer whenever it is reset, which would make
+      every timed save pay for growing a fresh string.  This buffer keeps its
+      capacity across calls to reset() so that only the archive itself is measured. */
+  class OutputBuffer : public std::streambuf
+  {
+    public:
+      OutputBuffer() : itsData( 64 ) { reset(); }
+
+      //! Discards the contents while keeping the allocated storage
+      void reset()
+      {
+        setp( itsData.data(), itsData.data() + itsData.size() );
+      }
+
+      //! The number of bytes written since the last reset
+      std::size_t size() const
+      { return static_cast<std::size_t>( pptr() - pbase() ); }
+
+      //! Copies out the bytes written since the last reset
+      std::string str() const
+      { return std::string( pbase(), size() ); }
+
+    protected:
+      int_type overflow( int_type c ) override
+      {
+        if( traits_type::eq_int_type( c, traits_type::eof() ) )
+          return traits_type::not_eof( c );
+
+        grow( size() + 1 );
+        *pptr() = traits_type::to_char_type( c );
+        pbump( 1 );
+        return c;
+      }
+
+      std::streamsize xsputn( char const * s, std::streamsize n ) override
+      {
+        auto const count = static_cast<std::size_t>( n );
+        if( static_cast<std::size_t>( epptr() - pptr() ) < count )
+          grow( size() + count );
+
+        std::memcpy( pptr(), s, count );
+        advance( count );
+        return n;
+      }
+
+    private:
+      //! Grows the storage to hold at least required bytes, preserving the contents
+      void grow( std::size_t required )
+      {
+        auto const used = size();
+        std::size_t capacity = itsData.size();
+        while( capacity < required )
+          capacity *= 2;
+
+        itsData.resize( capacity );
+        setp( itsData.data(), itsData.data() + itsData.size() );
+        advance( used );
+      }
+
+      //! pbump only takes an int, so large advances are split up
+      void advance( std::size_t count )
+      {
+        while( count )
+        {
+          auto const step = static_cast<int>( std::min<std::size_t>( count, 1 << 30 ) );
+          pbump( step );
+          count -= static_cast<std::size_t>( step );
+        }
+      }
+
+      std::vector<char> itsData;
+  };
+
+  // ######################################################################
+  //! A seekable input stream buffer over a block of memory that can be rewound
+  class InputBuffer : public std::streambuf
+  {
+    public:
+      //! Sets the data that will be read, which must outlive any reads
+      void set( std::string const & data )
+      {
+        itsBegin = const_cast<char *>( data.data() );
+        itsEnd = itsBegin + data.size();
+        reset();
+      }
+
+      //! Rewinds to the start of the data
+      void reset()
+      {
+        setg( itsBegin, itsBegin, itsEnd );
+      }
+
+    protected:
+      pos_type seekoff( off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which ) override
+      {
+        if( !( which & std::ios_base::in ) )
+          return pos_type( off_type( -1 ) );
+
+        char * base = dir == std::ios_base::beg ? eback() :
+                      dir == std::ios_base::cur ? gptr() : egptr();
+        char * target = base + off;
+        if( target < eback() || target > egptr() )
+          return pos_type( off_type( -1 ) );
+
+        setg( eback(), target, egptr() );
+        return pos_type( target - eback() );
+      }
+
+      pos_type seekpos( pos_type pos, std::ios_base::openmode which ) override
+      {
+        return seekoff( off_type( pos ), std::ios_base::beg, which );
+      }
+
+    private:
+      char * itsBegin = nullptr;
+      char * itsEnd = nullptr;
+  };
+
+  // ######################################################################
+  //! Summary statistics over the repetitions of a single benchmark, in seconds per operation
+  struct Statistics
+  {
+    double min = 0;
+    double median = 0;
+    double mean = 0;
+    double stddev = 0;
+
+    //! Computes the statistics for a set of samples
+    static Statistics compute( std::vector<double> samples )
+    {
+      Statistics stats;
+      if( samples.empty() )
+        return stats;
+
+      std::sort( samples.begin(), samples.end() );
+      auto const n = samples.size();
+
+      stats.min = samples.front();
+      stats.median = n % 2 ? samples[n / 2] : ( samples[n / 2 - 1] + samples[n / 2] ) / 2;
+
+      double sum = 0;
+      for( auto s : samples )
+        sum += s;
+      stats.mean = sum / static_cast<double>( n );
+
+      double squares = 0;
+      for( auto s : samples )
+        squares += ( s - stats.mean ) * ( s - stats.mean );
+      stats.stddev = n > 1 ? std::sqrt( squares / static_cast<double>( n - 1 ) ) : 0;
+
+      return stats;
+    }
+  };
+
+  //! The measured outcome of timing one operation on one data set with one archive
+  struct Result
+  {
+    std::string name;       //!< The data set being serialized
+    std::string archive;    //!< The archive used
+    std::string operation;  //!< Either "save" or "load"
+    std::size_t iterations; //!< Operations per repetition
+    std::size_t repetitions;//!< Number of timed repetitions
+    std::size_t bytes;      //!< Size of the serialized output
+    std::size_t objects;    //!< Number of logical objects in the data set
+    Statistics seconds;     //!< Seconds per operation
+
+    double bytesPerSecond() const
+    { return seconds.median > 0 ? static_cast<double>( bytes ) / seconds.median : 0; }
+
+    double objectsPerSecond() const
+    { return seconds.median > 0 ? static_cast<double>( objects ) / seconds.median : 0; }
+  };
+
+  // ######################################################################
+  //! Options controlling how benchmarks are run and reported
+  struct Settings
+  {
+    std::size_t warmup = 1;      //!< Untimed repetitions run before measuring
+    std::size_t repetitions = 5; //!< Timed repetitions used for the statistics
+    double minTime = 0.02;       //!< Minimum time, in seconds, that each repetition should take
+    std::vector<std::string> filters; //!< Only benchmarks whose full name contains one of these are run
+    std::string jsonPath;        //!< Where to write machine readable results, if anywhere
+    std::string baselinePath;    //!< Results to compare against, if any
+    double threshold = 0.25;     //!< Allowed relative slowdown before a benchmark counts as a regression
+    std::size_t retries = 3;     //!< Times a benchmark that appears to regress is measured again
+    bool normalize = false;      //!< Scale the baseline by the overall speed of this machine relative to it
+    bool list = false;           //!< Only list the benchmark names
+
+    //! Parses the command line, throwing std::runtime_error on bad input
+    static Settings parse( int argc, char ** argv )
+    {
+      Settings settings;
+
+      for( int i = 1; i < argc; ++i )
+      {
+        std::string const arg = argv[i];
+
+        auto value = [&]() -> std::string
+        {
+          if( i + 1 >= argc )
+            throw std::runtime_error( "Missing value for " + arg );
+          return argv[++i];
+        };
+
+        if( arg == "--warmup" )
+          settings.warmup = std::strtoul( value().c_str(), nullptr, 10 );
+        else if( arg == "--repetitions" )
+          settings.repetitions = std::max<std::size_t>( 1, std::strtoul( value().c_str(), nullptr, 10 ) );
+        else if( arg == "--min-time" )
+          settings.minTime = std::strtod( value().c_str(), nullptr );
+        else if( arg == "--filter" )
+          settings.filters.push_back( value() );
+        else if( arg == "--json" )
+          settings.jsonPath = value();
+        else if( arg == "--baseline" )
+          settings.baselinePath = value();
+        else if( arg == "--threshold" )
+          settings.threshold = std::strtod( value().c_str(), nullptr );
+        else if( arg == "--retries" )
+          settings.retries = std::strtoul( value().c_str(), nullptr, 10 );
+        else if( arg == "--normalize" )
+          settings.normalize = true;
+        else if( arg == "--quick" )
+        {
+          settings.warmup = 0;
+          settings.repetitions = 3;
+          settings.minTime = 0.002;
+        }
+        else if( arg == "--list" )
+          settings.list = true;
+        else if( arg == "--help" || arg == "-h" )
+          throw std::runtime_error( "" );
+        else
+          throw std::runtime_error( "Unknown argument " + arg );
+      }
+
+      return settings;
+    }
+
+    static void usage( std::ostream & os, char const * program )
+    {
+      os << "Usage: " << program << " [options]\n"
+         << "  --filter <text>       Only run benchmarks whose name contains text (may be repeated)\n"
+         << "  --repetitions <n>     Timed repetitions per benchmark (default 5)\n"
+         << "  --warmup <n>          Untimed repetitions per benchmark (default 1)\n"
+         << "  --min-time <seconds>  Minimum duration of each repetition (default 0.02)\n"
+         << "  --quick               Short run suitable for smoke testing\n"
+         << "  --json <file>         Write machine readable results to file\n"
+         << "  --baseline <file>     Compare against results previously written with --json\n"
+         << "  --threshold <ratio>   Allowed slowdown relative to the baseline (default 0.25)\n"
+         << "  --retries <n>         Times to re-measure benchmarks slower than the baseline (default 3)\n"
+         << "  --normalize           Compare relative to the median speed difference from the baseline\n"
+         << "  --list                List benchmark names without running them\n";
+    }
+  };
+
+  // ######################################################################
+  //! Runs benchmarks and collects their results
+  class Runner
+  {
+    public:
+      //! Creates a runner, loading the baseline if one was given
+      /*! @throws std::runtime_error if the baseline cannot be read */
+      explicit Runner( Settings const & settings ) : itsSettings( settings )
+      {
+        if( !itsSettings.baselinePath.empty() )
+          loadBaseline( itsSettings.baselinePath );
+      }
+
+      //! Adds benchmarks for saving and loading data with the archive pair described by ArchiveT
+      /*! ArchiveT must provide a static name(), and OutputArchive and InputArchive typedefs.
+          The data is round tripped once up front so that the load benchmark has something
+          to read and so that the output size is known.  Nothing is timed until run().
+
+          @param name The name of the data set
+          @param data The data to serialize, shared between archives
+          @param objects The number of logical objects contained in data */
+      template <class ArchiveT, class T>
+      void add( std::string const & name, std::shared_ptr<T const> data, std::size_t objects )
+      {
+        std::string const fullName = name + "/" + ArchiveT::name();
+        if( !selected( fullName ) )
+          return;
+
+        if( itsSettings.list )
+        {
+          std::cout << fullName << std::endl;
+          return;
+        }
+
+        //! Buffers are kept between runs so that timing only covers the archive
+        struct State
+        {
+          State() : os( &outBuffer ), is( &inBuffer ) {}
+
+          std::shared_ptr<T const> data;
+          OutputBuffer outBuffer;
+          std::ostream os;
+          std::string saved;
+          InputBuffer inBuffer;
+          std::istream is;
+        };
+
+        auto state = std::make_shared<State>();
+        state->data = std::move( data );
+
+        auto save = [state]()
+        {
+          state->outBuffer.reset();
+          typename ArchiveT::OutputArchive ar( state->os );
+          ar( *state->data );
+        };
+
+        auto load = [state]()
+        {
+          state->inBuffer.reset();
+          state->is.clear();
+          T loaded;
+          typename ArchiveT::InputArchive ar( state->is );
+          ar( loaded );
+        };
+
+        save();
+        state->saved = state->outBuffer.str();
+        state->inBuffer.set( state->saved );
+
+        itsBenchmarks.push_back( { name, ArchiveT::name(), "save", state->saved.size(), objects, save } );
+        itsBenchmarks.push_back( { name, ArchiveT::name(), "load", state->saved.size(), objects, load } );
+      }
+
+      //! Runs every added benchmark, printing results as they complete
+      /*! When comparing against a baseline, benchmarks that appear to have regressed are
+          measured again once everything else has run, keeping the faster of the attempts.
+          Load on a shared machine tends to come in bursts, so trying again later, and for
+          longer each time, is far more reliable than taking more samples straight away. */
+      void run()
+      {
+        if( itsSettings.list )
+          return;
+
+        printHeader( std::cout );
+        for( auto const & b : itsBenchmarks )
+        {
+          itsResults.push_back( measure( b, itsSettings.repetitions ) );
+          print( std::cout, itsResults.back() );
+        }
+
+        for( std::size_t attempt = 0; attempt < itsSettings.retries; ++attempt )
+        {
+          std::vector<std::size_t> suspects;
+          for( std::size_t i = 0; i < itsResults.size(); ++i )
+            if( regressed( itsResults[i] ) )
+              suspects.push_back( i );
+
+          if( suspects.empty() )
+            break;
+
+          std::cout << "Measuring " << suspects.size() << " benchmarks again that appear slower than the baseline" << std::endl;
+          for( auto i : suspects )
+          {
+            auto const result = measure( itsBenchmarks[i], itsSettings.repetitions << ( attempt + 1 ) );
+            if( result.seconds.min < itsResults[i].seconds.min )
+              itsResults[i] = result;
+            print( std::cout, itsResults[i] );
+          }
+        }
+      }
+
+      //! All results gathered so far
+      std::vector<Result> const & results() const
+      { return itsResults; }
+
+      //! Writes the results as JSON
+      void writeJSON( std::ostream & os ) const
+      {
+        os << "{\n  \"context\": {\n"
+           << "    \"compiler\": " << quote( compiler() ) << ",\n"
+           << "    \"warmup\": " << itsSettings.warmup << ",\n"
+           << "    \"repetitions\": " << itsSettings.repetitions << ",\n"
+           << "    \"min_time\": " << number( itsSettings.minTime ) << "\n"
+           << "  },\n  \"benchmarks\": [";
+
+        for( std::size_t i = 0; i < itsResults.size(); ++i )
+        {
+          auto const & r = itsResults[i];
+          os << ( i ? ",\n" : "\n" )
+             << "    {\"name\": " << quote( r.name )
+             << ", \"archive\": " << quote( r.archive )
+             << ", \"operation\": " << quote( r.operation )
+             << ", \"iterations\": " << r.iterations
+             << ", \"repetitions\": " << r.repetitions
+             << ", \"bytes\": " << r.bytes
+             << ", \"objects\": " << r.objects
+             << ", \"seconds\": {\"min\": " << number( r.seconds.min )
+             << ", \"median\": " << number( r.seconds.median )
+             << ", \"mean\": " << number( r.seconds.mean )
+             << ", \"stddev\": " << number( r.seconds.stddev ) << "}"
+             << ", \"bytes_per_second\": " << number( r.bytesPerSecond() )
+             << ", \"objects_per_second\": " << number( r.objectsPerSecond() ) << "}";
+        }
+
+        os << "\n  ]\n}\n";
+      }
+
+      //! Compares the results against the baseline given in the settings
+      /*! A benchmark regresses when its fastest repetition is slower than the fastest
+          repetition in the baseline by more than the threshold.  The minimum is used rather
+          than the median since it is the least affected by other load on the machine.
+          Benchmarks missing from either side are skipped.
+
+          With normalization the baseline is first scaled by the median ratio between the
+          current and baseline times, so that a baseline recorded on a faster or slower
+          machine still finds the benchmarks that slowed down relative to the others.
+
+          @param os Where the comparison report is written
+          @return The number of regressions found */
+      std::size_t compare( std::ostream & os ) const
+      {
+        double const speed = speedFactor();
+        if( itsSettings.normalize )
+          os << "Normalizing by a machine speed factor of " << speed << std::endl;
+
+        std::size_t regressions = 0, compared = 0;
+        for( auto const & r : itsResults )
+        {
+          double const baseline = baselineFor( r ) * speed;
+          if( baseline <= 0 )
+            continue;
+
+          ++compared;
+          double const ratio = r.seconds.min / baseline;
+          if( ratio > 1.0 + itsSettings.threshold )
+          {
+            ++regressions;
+            os << "REGRESSION ";
+          }
+          else if( ratio < 1.0 / ( 1.0 + itsSettings.threshold ) )
+            os << "improved   ";
+          else
+            continue;
+
+          os << std::left << std::setw( 40 ) << ( r.name + "/" + r.archive ) << std::right
+             << std::setw( 6 ) << r.operation
+             << std::setw( 12 ) << formatTime( baseline ) << " -> " << std::setw( 12 ) << formatTime( r.seconds.min )
+             << " (" << std::fixed << std::setprecision( 2 ) << ratio << "x)" << std::endl;
+          os.unsetf( std::ios::floatfield );
+        }
+
+        os << compared << " benchmarks compared against " << itsSettings.baselinePath << ", "
+           << regressions << " slower by more than " << itsSettings.threshold * 100 << "%" << std::endl;
+
+        return regressions;
+      }
+
+      //! Prints the column headers for the human readable report
+      static void printHeader( std::ostream & os )
+      {
+        os << std::left << std::setw( 40 ) << "benchmark" << std::right
+           << std::setw( 6 ) << "op"
+           << std::setw( 12 ) << "median"
+           << std::setw( 9 ) << "+/-"
+           << std::setw( 12 ) << "MB/s"
+           << std::setw( 14 ) << "objects/s"
+           << std::setw( 12 ) << "bytes" << std::endl;
+      }
+
+    private:
+      //! A single timed operation
+      struct Benchmark
+      {
+        std::string name;
+        std::string archive;
+        std::string operation;
+        std::size_t bytes;
+        std::size_t objects;
+        std::function<void()> func;
+      };
+
+      //! Reads the fastest time of each benchmark from a file written by writeJSON
+      void loadBaseline( std::string const & path )
+      {
+        std::ifstream file( path );
+        if( !file )
+          throw std::runtime_error( "Unable to open baseline " + path );
+
+        std::stringstream contents;
+        contents << file.rdbuf();
+        std::string const text = contents.str();
+
+        try
+        {
+          rapidjson::Document document;
+          document.Parse<0>( text.c_str() );
+          if( document.HasParseError() )
+            throw std::runtime_error( std::string( "Invalid baseline " ) + path + ": " + document.GetParseError() );
+
+          auto const & benchmarks = document["benchmarks"];
+          for( rapidjson::SizeType i = 0; i < benchmarks.Size(); ++i )
+          {
+            auto const & b = benchmarks[i];
+            itsBaseline[key( b["name"].GetString(), b["archive"].GetString(), b["operation"].GetString() )] =
+              b["seconds"]["min"].GetDouble();
+          }
+        }
+        catch( cereal::RapidJSONException const & e )
+        {
+          throw std::runtime_error( "Malformed baseline " + path + ": " + e.what() );
+        }
+      }
+
+      //! The baseline time for a result, or zero if there is none
+      double baselineFor( Result const & r ) const
+      {
+        auto const iter = itsBaseline.find( key( r.name, r.archive, r.operation ) );
+        return iter == itsBaseline.end() ? 0 : iter->second;
+      }
+
+      //! How much slower this machine is than the one that recorded the baseline
+      /*! This is the median ratio of current to baseline times over the results gathered so
+          far, or one when normalization is disabled or nothing can be compared yet */
+      double speedFactor() const
+      {
+        if( !itsSettings.normalize )
+          return 1.0;
+
+        std::vector<double> ratios;
+        for( auto const & r : itsResults )
+        {
+          double const baseline = baselineFor( r );
+          if( baseline > 0 )
+            ratios.push_back( r.seconds.min / baseline );
+        }
+
+        return ratios.empty() ? 1.0 : Statistics::compute( ratios ).median;
+      }
+
+      bool selected( std::string const & fullName ) const
+      {
+        if( itsSettings.filters.empty() )
+          return true;
+
+        for( auto const & f : itsSettings.filters )
+          if( fullName.find( f ) != std::string::npos )
+            return true;
+
+        return false;
+      }
+
+      //! Times a benchmark, first calibrating how many iterations fill the minimum repetition time
+      Result measure( Benchmark const & benchmark, std::size_t repetitions ) const
+      {
+        auto const & func = benchmark.func;
+        typedef std::chrono::steady_clock clock;
+
+        auto timeIterations = [&]( std::size_t iterations )
+        {
+          auto const start = clock::now();
+          for( std::size_t i = 0; i < iterations; ++i )
+            func();
+          return std::chrono::duration<double>( clock::now() - start ).count();
+        };
+
+        // Grow the iteration count until a repetition lasts at least minTime
+        std::size_t iterations = 1;
+        for( double elapsed = timeIterations( iterations ); elapsed < itsSettings.minTime; elapsed = timeIterations( iterations ) )
+        {
+          double const scale = elapsed > 0 ? itsSettings.minTime / elapsed * 1.2 : 10.0;
+          iterations = std::max( iterations + 1, static_cast<std::size_t>( static_cast<double>( iterations ) * std::min( scale, 10.0 ) ) );
+        }
+
+        for( std::size_t i = 0; i < itsSettings.warmup; ++i )
+          timeIterations( iterations );
+
+        std::vector<double> samples;
+        for( std::size_t i = 0; i < repetitions; ++i )
+          samples.push_back( timeIterations( iterations ) / static_cast<double>( iterations ) );
+
+        Result result;
+        result.name = benchmark.name;
+        result.archive = benchmark.archive;
+        result.operation = benchmark.operation;
+        result.iterations = iterations;
+        result.repetitions = repetitions;
+        result.bytes = benchmark.bytes;
+        result.objects = benchmark.objects;
+        result.seconds = Statistics::compute( samples );
+        return result;
+      }
+
+      //! Whether a result is slower than its baseline by more than the threshold
+      bool regressed( Result const & r ) const
+      {
+        double const baseline = baselineFor( r ) * speedFactor();
+        return baseline > 0 && r.seconds.min > baseline * ( 1.0 + itsSettings.threshold );
+      }
+
+      static void print( std::ostream & os, Result const & r )
+      {
+        auto const percent = r.seconds.median > 0 ? 100.0 * r.seconds.stddev / r.seconds.median : 0.0;
+
+        os << std::left << std::setw( 40 ) << ( r.name + "/" + r.archive ) << std::right
+                  << std::setw( 6 ) << r.operation
+                  << std::setw( 12 ) << formatTime( r.seconds.median )
+                  << std::setw( 8 ) << std::fixed << std::setprecision( 1 ) << percent << "%"
+                  << std::setw( 12 ) << std::setprecision( 1 ) << r.bytesPerSecond() / ( 1024.0 * 1024.0 )
+                  << std::setw( 14 ) << std::setprecision( 0 ) << r.objectsPerSecond()
+                  << std::setw( 12 ) << r.bytes << std::endl;
+        os.unsetf( std::ios::floatfield );
+      }
+
+      static std::string key( std::string const & name, std::string const & archive, std::string const & operation )
+      {
+        return name + "/" + archive + "/" + operation;
+      }
+
+      static std::string formatTime( double seconds )
+      {
+        char buffer[32];
+        if( seconds >= 1 )         std::snprintf( buffer, sizeof(buffer), "%.3f s", seconds );
+        else if( seconds >= 1e-3 ) std::snprintf( buffer, sizeof(buffer), "%.3f ms", seconds * 1e3 );
+        else if( seconds >= 1e-6 ) std::snprintf( buffer, sizeof(buffer), "%.3f us", seconds * 1e6 );
+        else                       std::snprintf( buffer, sizeof(buffer), "%.1f ns", seconds * 1e9 );
+        return buffer;
+      }
+
+      static std::string number( double value )
+      {
+        char buffer[32];
+        std::snprintf( buffer, sizeof(buffer), "%.9g", value );
+        return buffer;
+      }
+
+      static std::string quote( std::string const & str )
+      {
+        std::string out = "\"";
+        for( char c : str )
+        {
+          if( c == '"' || c == '\\' )
+            out += '\\';
+          out += c;
+        }
+        return out + "\"";
+      }
+
+      static std::string compiler()
+      {
+        #if defined(__clang__)
+        return std::string( "clang " ) + __clang_version__;
+        #elif defined(__GNUC__)
+        return std::string( "gcc " ) + __VERSION__;
+        #elif defined(_MSC_VER)
+        return "msvc " + std::to_string( _MSC_VER );
+        #else
+        return "unknown";
+        #endif
+      }
+
+      Settings itsSettings;
+      std::vector<Benchmark> itsBenchmarks;
+      std::vector<Result> itsResults;
+      std::map<std::string, double> itsBaseline; //!< Fastest baseline time, keyed by name/archive/operation
+  };
+} // namespace benchmark
+
+#endif // CEREAL_SANDBOX_PERFORMANCE_HPP_
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+
+# Regenerates the baseline used by the performance regression test.
+#   $1 is the performance benchmark executable
+#   $2 is the baseline file to write
+#   any remaining arguments are passed on to the benchmark
+#
+# Timings are only comparable on the machine that produced them, so the baseline
+# should be refreshed on the machine that runs the regression test, and again
+# whenever a change is expected to alter performance.
+
+set -e
+
+if [ $# -lt 2 ]; then
+  echo "usage: $0 <performance executable> <baseline file> [benchmark arguments]"
+  exit 1
+fi
+
+BENCHMARK=$1
+BASELINE=$2
+shift 2
+
+tempfile=`mktemp`
+trap "rm -f ${tempfile}" EXIT
+
+"${BENCHMARK}" "$@" --json "${tempfile}"
+cp "${tempfile}" "${BASELINE}"
+
+echo "Updated ${BASELINE}"
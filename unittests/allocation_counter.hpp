@@ -0,0 +1,157 @@
+/*! \file allocation_counter.hpp
+    \brief Counts heap allocations made by the current thread
+
+    Replaces the global operator new and delete so that tests can check how many
+    allocations a block of code performs.  The replacement operators are defined
+    in this header, so it must be included by exactly one translation unit of a
+    test executable. */
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef CEREAL_TEST_ALLOCATION_COUNTER_H_
+#define CEREAL_TEST_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace allocation_counter
+{
+  //! Running totals for the current thread
+  struct Totals
+  {
+    std::size_t allocations;
+    std::size_t deallocations;
+    std::size_t bytes;
+  };
+
+  //! The totals for the current thread, starting at zero
+  inline Totals & totals()
+  {
+    static thread_local Totals t = { 0, 0, 0 };
+    return t;
+  }
+
+  inline void * allocate( std::size_t size )
+  {
+    auto & t = totals();
+    ++t.allocations;
+    t.bytes += size;
+    return std::malloc( size ? size : 1 );
+  }
+
+  inline void deallocate( void * ptr )
+  {
+    if( ptr )
+    {
+      ++totals().deallocations;
+      std::free( ptr );
+    }
+  }
+} // namespace allocation_counter
+
+// ######################################################################
+//! Counts the allocations made by the current thread during its lifetime
+/*! @code{.cpp}
+    {
+      AllocationCounter counter;
+      oar( data );
+      BOOST_CHECK_EQUAL( counter.allocations(), 0 );
+    }
+    @endcode */
+class AllocationCounter
+{
+  public:
+    AllocationCounter() : itsStart( allocation_counter::totals() ) {}
+
+    //! The number of allocations since construction or the last reset
+    std::size_t allocations() const
+    { return allocation_counter::totals().allocations - itsStart.allocations; }
+
+    //! The number of deallocations since construction or the last reset
+    std::size_t deallocations() const
+    { return allocation_counter::totals().deallocations - itsStart.deallocations; }
+
+    //! The number of bytes requested since construction or the last reset
+    std::size_t bytes() const
+    { return allocation_counter::totals().bytes - itsStart.bytes; }
+
+    //! Starts counting again from zero
+    void reset()
+    { itsStart = allocation_counter::totals(); }
+
+  private:
+    allocation_counter::Totals itsStart;
+};
+
+// ######################################################################
+// Replacement global allocation functions
+
+void * operator new( std::size_t size )
+{
+  if( void * ptr = allocation_counter::allocate( size ) )
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void * operator new[]( std::size_t size )
+{
+  if( void * ptr = allocation_counter::allocate( size ) )
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void * operator new( std::size_t size, std::nothrow_t const & ) noexcept
+{
+  return allocation_counter::allocate( size );
+}
+
+void * operator new[]( std::size_t size, std::nothrow_t const & ) noexcept
+{
+  return allocation_counter::allocate( size );
+}
+
+void operator delete( void * ptr ) noexcept
+{
+  allocation_counter::deallocate( ptr );
+}
+
+void operator delete[]( void * ptr ) noexcept
+{
+  allocation_counter::deallocate( ptr );
+}
+
+void operator delete( void * ptr, std::nothrow_t const & ) noexcept
+{
+  allocation_counter::deallocate( ptr );
+}
+
+void operator delete[]( void * ptr, std::nothrow_t const & ) noexcept
+{
+  allocation_counter::deallocate( ptr );
+}
+
+#endif // CEREAL_TEST_ALLOCATION_COUNTER_H_
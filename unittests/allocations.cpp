@@ -0,0 +1,571 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include "allocation_counter.hpp"
+#include <cereal/archives/json_lines.hpp>
+#include <boost/test/unit_test.hpp>
+
+//! A stream buffer over storage allocated up front, which can be read back after writing
+class PresizedBuffer : public std::streambuf
+{
+  public:
+    PresizedBuffer( size_t size ) : itsData( size ) { clear(); }
+
+    //! Starts writing from the beginning again
+    void clear()
+    {
+      setp( itsData.data(), itsData.data() + itsData.size() );
+      setg( itsData.data(), itsData.data(), itsData.data() );
+    }
+
+    //! Makes everything written so far available for reading from the start
+    void rewind()
+    {
+      setg( itsData.data(), itsData.data(), pptr() );
+    }
+
+  private:
+    std::vector<char> itsData;
+};
+
+struct AllocationMessage
+{
+  int id;
+  double value;
+  std::string name;
+  std::vector<int> values;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( CEREAL_NVP(id), CEREAL_NVP(value), CEREAL_NVP(name), CEREAL_NVP(values) );
+  }
+};
+
+AllocationMessage make_allocation_message( std::mt19937 & gen, size_t size )
+{
+  AllocationMessage m;
+  m.id = random_value<int>(gen);
+  m.value = random_value<double>(gen);
+  // Longer than any small string optimization, so copies of it would allocate
+  m.name = "allocation message " + random_basic_string<char>(gen);
+  for( size_t i = 0; i < size; ++i )
+    m.values.push_back( random_value<int>(gen) );
+  return m;
+}
+
+BOOST_AUTO_TEST_CASE( allocation_counter_counts )
+{
+  AllocationCounter counter;
+  std::unique_ptr<int> i( new int( 5 ) );
+  std::vector<char> v( 100 );
+
+  BOOST_CHECK_EQUAL( counter.allocations(), 2 );
+  BOOST_CHECK_EQUAL( counter.deallocations(), 0 );
+  BOOST_CHECK_GE( counter.bytes(), sizeof(int) + 100 );
+
+  i.reset();
+  BOOST_CHECK_EQUAL( counter.deallocations(), 1 );
+
+  counter.reset();
+  BOOST_CHECK_EQUAL( counter.allocations(), 0 );
+}
+
+template <class OArchive, class IArchive, class T>
+void test_arithmetic_vector_allocations( std::mt19937 & gen )
+{
+  std::vector<T> o_vector( 1000 );
+  for( auto & v : o_vector )
+    v = random_value<T>(gen);
+  std::vector<T> i_vector( o_vector.size() );
+
+  PresizedBuffer buffer( 64 * 1024 );
+  std::ostream os( &buffer );
+  std::istream is( &buffer );
+
+  AllocationCounter counter;
+  {
+    OArchive oar( os );
+    oar( o_vector );
+  }
+  size_t const saveAllocations = counter.allocations();
+
+  buffer.rewind();
+  counter.reset();
+  {
+    IArchive iar( is );
+    iar( i_vector );
+  }
+  size_t const loadAllocations = counter.allocations();
+
+  BOOST_CHECK_EQUAL( saveAllocations, 0 );
+  BOOST_CHECK_EQUAL( loadAllocations, 0 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( i_vector.begin(), i_vector.end(), o_vector.begin(), o_vector.end() );
+}
+
+BOOST_AUTO_TEST_CASE( binary_arithmetic_vector_allocations )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  test_arithmetic_vector_allocations<cereal::BinaryOutputArchive, cereal::BinaryInputArchive, double>( gen );
+  test_arithmetic_vector_allocations<cereal::BinaryOutputArchive, cereal::BinaryInputArchive, int32_t>( gen );
+  test_arithmetic_vector_allocations<cereal::BinaryOutputArchive, cereal::BinaryInputArchive, uint8_t>( gen );
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_arithmetic_vector_allocations )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  test_arithmetic_vector_allocations<cereal::PortableBinaryOutputArchive, cereal::PortableBinaryInputArchive, double>( gen );
+  test_arithmetic_vector_allocations<cereal::PortableBinaryOutputArchive, cereal::PortableBinaryInputArchive, int64_t>( gen );
+}
+
+BOOST_AUTO_TEST_CASE( binary_string_allocations )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  std::string o_string( 2000, ' ' );
+  for( auto & c : o_string )
+    c = static_cast<char>( std::uniform_int_distribution<int>( 'A', 'Z' )(gen) );
+
+  std::string i_string;
+  i_string.reserve( o_string.size() );
+
+  PresizedBuffer buffer( 4 * 1024 );
+  std::ostream os( &buffer );
+  std::istream is( &buffer );
+
+  AllocationCounter counter;
+  {
+    cereal::BinaryOutputArchive oar( os );
+    oar( o_string );
+  }
+  size_t const saveAllocations = counter.allocations();
+
+  buffer.rewind();
+  counter.reset();
+  {
+    cereal::BinaryInputArchive iar( is );
+    iar( i_string );
+  }
+  size_t const loadAllocations = counter.allocations();
+
+  BOOST_CHECK_EQUAL( saveAllocations, 0 );
+  BOOST_CHECK_EQUAL( loadAllocations, 0 );
+  BOOST_CHECK_EQUAL( i_string, o_string );
+}
+
+BOOST_AUTO_TEST_CASE( binary_reused_archive_allocations )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  auto const message = make_allocation_message( gen, 20 );
+
+  PresizedBuffer buffer( 64 * 1024 );
+  std::ostream os( &buffer );
+  cereal::BinaryOutputArchive oar( os );
+
+  AllocationCounter counter;
+  for( int i = 0; i < 100; ++i )
+    oar( message );
+
+  BOOST_CHECK_EQUAL( counter.allocations(), 0 );
+}
+
+// Text archives keep some bookkeeping per archive, but with a context they should not need
+// more memory as messages get larger
+template <class OArchive, class IArchive, class Context>
+void test_context_allocations( size_t bound )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  Context context;
+  PresizedBuffer buffer( 1024 * 1024 );
+  std::ostream os( &buffer );
+  std::istream is( &buffer );
+
+  // Grow the context to fit the largest message first
+  {
+    OArchive oar( os, context );
+    oar( make_allocation_message( gen, 2000 ) );
+  }
+
+  for( size_t size : { 1, 100, 2000 } )
+  {
+    auto const o_message = make_allocation_message( gen, size );
+
+    AllocationMessage i_message;
+    i_message.name.reserve( o_message.name.size() );
+    i_message.values.reserve( o_message.values.size() );
+
+    buffer.clear();
+    AllocationCounter counter;
+    {
+      OArchive oar( os, context );
+      oar( o_message );
+    }
+    size_t const saveAllocations = counter.allocations();
+
+    buffer.rewind();
+    is.clear();
+    counter.reset();
+    {
+      IArchive iar( is, context );
+      iar( i_message );
+    }
+    size_t const loadAllocations = counter.allocations();
+
+    BOOST_CHECK_LE( saveAllocations, bound );
+    BOOST_CHECK_LE( loadAllocations, bound );
+    BOOST_CHECK_EQUAL( i_message.values.size(), size );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( json_context_allocations )
+{
+  test_context_allocations<cereal::JSONOutputArchive, cereal::JSONInputArchive, cereal::JSONContext>( 8 );
+}
+
+BOOST_AUTO_TEST_CASE( xml_context_allocations )
+{
+  test_context_allocations<cereal::XMLOutputArchive, cereal::XMLInputArchive, cereal::XMLContext>( 16 );
+}
+
+BOOST_AUTO_TEST_CASE( json_lines_record_allocations )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  auto const message = make_allocation_message( gen, 20 );
+
+  PresizedBuffer buffer( 1024 * 1024 );
+  std::ostream os( &buffer );
+  cereal::JSONLinesOutputArchive oar( os );
+
+  // The first record sizes the archive's buffers, after which records come for free
+  oar( message );
+
+  AllocationCounter counter;
+  for( int i = 0; i < 100; ++i )
+    oar( message );
+
+  BOOST_CHECK_EQUAL( counter.allocations(), 0 );
+}
+
+struct AllocationNode
+{
+  int32_t value = 0;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( value ); }
+};
+
+struct AllocationConstructedNode
+{
+  AllocationConstructedNode( int32_t v ) : value( v ) {}
+
+  int32_t value;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( value ); }
+
+  template <class Archive>
+  static void load_and_construct( Archive & ar, cereal::construct<AllocationConstructedNode> & construct )
+  {
+    int32_t value;
+    ar( value );
+    construct( value );
+  }
+};
+
+struct AllocationSharedNode : std::enable_shared_from_this<AllocationSharedNode>
+{
+  int32_t value = 0;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( value ); }
+};
+
+//! Loads distinct shared pointers, returning the number of allocations made while loading
+template <class T>
+size_t load_shared_ptr_allocations( std::vector<std::shared_ptr<T>> const & o_ptrs,
+                                    std::vector<std::shared_ptr<T>> & i_ptrs,
+                                    cereal::MemoryResource * resource )
+{
+  PresizedBuffer buffer( 1024 * 1024 );
+  std::ostream os( &buffer );
+  std::istream is( &buffer );
+  {
+    cereal::BinaryOutputArchive oar( os );
+    oar( o_ptrs );
+  }
+
+  buffer.rewind();
+  i_ptrs.reserve( o_ptrs.size() );
+
+  AllocationCounter counter;
+  {
+    cereal::BinaryInputArchive iar( is );
+    iar.setMemoryResource( resource );
+    iar( i_ptrs );
+  }
+  size_t const allocations = counter.allocations();
+
+  BOOST_REQUIRE_EQUAL( i_ptrs.size(), o_ptrs.size() );
+  for( size_t i = 0; i < o_ptrs.size(); ++i )
+    BOOST_CHECK_EQUAL( i_ptrs[i]->value, o_ptrs[i]->value );
+
+  return allocations;
+}
+
+template <class T>
+std::vector<std::shared_ptr<T>> make_allocation_nodes( size_t size )
+{
+  std::vector<std::shared_ptr<T>> ptrs;
+  for( size_t i = 0; i < size; ++i )
+  {
+    ptrs.push_back( std::make_shared<T>() );
+    ptrs.back()->value = static_cast<int32_t>( i );
+  }
+  return ptrs;
+}
+
+// Each loaded pointer costs one allocation for its target and reference count, plus the
+// archive's own record of it
+BOOST_AUTO_TEST_CASE( binary_shared_ptr_allocations )
+{
+  size_t const size = 1000;
+
+  {
+    auto const o_ptrs = make_allocation_nodes<AllocationNode>( size );
+    std::vector<std::shared_ptr<AllocationNode>> i_ptrs;
+    BOOST_CHECK_LE( load_shared_ptr_allocations( o_ptrs, i_ptrs, nullptr ), 2 * size + 32 );
+  }
+
+  {
+    std::vector<std::shared_ptr<AllocationConstructedNode>> o_ptrs, i_ptrs;
+    for( size_t i = 0; i < size; ++i )
+      o_ptrs.push_back( std::make_shared<AllocationConstructedNode>( static_cast<int32_t>( i ) ) );
+    BOOST_CHECK_LE( load_shared_ptr_allocations( o_ptrs, i_ptrs, nullptr ), 2 * size + 32 );
+  }
+
+  {
+    auto const o_ptrs = make_allocation_nodes<AllocationSharedNode>( size );
+    std::vector<std::shared_ptr<AllocationSharedNode>> i_ptrs;
+    load_shared_ptr_allocations( o_ptrs, i_ptrs, nullptr );
+    for( auto const & p : i_ptrs )
+      BOOST_CHECK( p->shared_from_this() == p );
+  }
+}
+
+// Counts what is allocated from it, passing everything on to the heap
+class CountingMemoryResource : public cereal::MemoryResource
+{
+  public:
+    void * allocate( std::size_t size, std::size_t ) override
+    {
+      ++allocations;
+      return ::operator new( size );
+    }
+
+    void deallocate( void * ptr, std::size_t, std::size_t ) override
+    {
+      ++deallocations;
+      ::operator delete( ptr );
+    }
+
+    size_t allocations = 0;
+    size_t deallocations = 0;
+};
+
+BOOST_AUTO_TEST_CASE( binary_shared_ptr_memory_resource )
+{
+  size_t const size = 1000;
+
+  CountingMemoryResource counting;
+  {
+    auto const o_ptrs = make_allocation_nodes<AllocationNode>( size );
+    std::vector<std::shared_ptr<AllocationNode>> i_ptrs;
+    load_shared_ptr_allocations( o_ptrs, i_ptrs, &counting );
+    BOOST_CHECK_EQUAL( counting.allocations, size );
+  }
+  BOOST_CHECK_EQUAL( counting.deallocations, size );
+
+  // Only the archive's own records of the pointers and the arena's blocks come from the heap
+  cereal::MonotonicMemoryResource arena( 1024 * 1024 );
+  std::vector<std::shared_ptr<AllocationConstructedNode>> o_ptrs, i_ptrs;
+  for( size_t i = 0; i < size; ++i )
+    o_ptrs.push_back( std::make_shared<AllocationConstructedNode>( static_cast<int32_t>( i ) ) );
+  BOOST_CHECK_LE( load_shared_ptr_allocations( o_ptrs, i_ptrs, &arena ), size + 32 );
+}
+
+template <class T>
+using ResourceVector = std::vector<T, cereal::ResourceAllocator<T>>;
+
+using ResourceString = std::basic_string<char, std::char_traits<char>, cereal::ResourceAllocator<char>>;
+
+using ResourceMap = std::map<ResourceString, ResourceVector<int32_t>, std::less<ResourceString>,
+                             cereal::ResourceAllocator<std::pair<ResourceString const, ResourceVector<int32_t>>>>;
+
+struct ResourceMessage
+{
+  ResourceVector<ResourceString> names;
+  ResourceMap values;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( names, values ); }
+};
+
+ResourceMessage make_resource_message( size_t size )
+{
+  ResourceMessage message;
+  for( size_t i = 0; i < size; ++i )
+  {
+    // long enough to be kept out of the small string buffer
+    ResourceString name( "a name that does not fit in a string " );
+    name += std::to_string( i ).c_str();
+    message.names.push_back( name );
+    message.values.emplace( name, ResourceVector<int32_t>( i % 7, static_cast<int32_t>( i ) ) );
+  }
+  return message;
+}
+
+// Nested containers and strings load into the archive's resource along with their parents
+BOOST_AUTO_TEST_CASE( binary_container_memory_resource )
+{
+  size_t const size = 500;
+  auto const o_message = make_resource_message( size );
+
+  std::stringstream ss;
+  {
+    cereal::BinaryOutputArchive oar( ss );
+    oar( o_message );
+  }
+
+  CountingMemoryResource counting;
+  {
+    ResourceMessage i_message;
+    {
+      cereal::BinaryInputArchive iar( ss );
+      iar.setMemoryResource( &counting );
+      iar( i_message );
+    }
+
+    BOOST_CHECK( i_message.names == o_message.names );
+    BOOST_CHECK( i_message.values == o_message.values );
+
+    BOOST_CHECK( i_message.names.get_allocator().resource() == &counting );
+    BOOST_CHECK( i_message.values.get_allocator().resource() == &counting );
+    for( auto const & name : i_message.names )
+      BOOST_CHECK( name.get_allocator().resource() == &counting );
+    for( auto const & value : i_message.values )
+    {
+      BOOST_CHECK( value.first.get_allocator().resource() == &counting );
+      BOOST_CHECK( value.second.get_allocator().resource() == &counting );
+    }
+    BOOST_CHECK_GE( counting.allocations, 3 * size );
+  }
+  BOOST_CHECK_EQUAL( counting.allocations, counting.deallocations );
+
+  // With an arena, only its blocks and the archive itself touch the heap
+  cereal::MonotonicMemoryResource arena( 1024 * 1024 );
+  ResourceMessage i_message;
+  {
+    ss.seekg( 0 );
+    cereal::BinaryInputArchive iar( ss );
+    iar.setMemoryResource( &arena );
+
+    AllocationCounter counter;
+    iar( i_message );
+    BOOST_CHECK_LE( counter.allocations(), 32 );
+  }
+  BOOST_CHECK( i_message.values == o_message.values );
+
+  // A container given its own resource keeps it
+  ResourceVector<ResourceString> names( &counting );
+  {
+    ss.seekg( 0 );
+    cereal::BinaryInputArchive iar( ss );
+    iar.setMemoryResource( &arena );
+    iar( names );
+  }
+  BOOST_CHECK( names.get_allocator().resource() == &counting );
+  BOOST_CHECK( names.front().get_allocator().resource() == &counting );
+}
+
+template <class IArchive, class OArchive>
+void test_text_container_memory_resource( typename OArchive::Options const & options )
+{
+  auto const o_message = make_resource_message( 50 );
+
+  std::stringstream ss;
+  {
+    OArchive oar( ss, options );
+    oar( o_message );
+  }
+
+  CountingMemoryResource counting;
+  {
+    ResourceMessage i_message;
+    {
+      IArchive iar( ss );
+      iar.setMemoryResource( &counting );
+      iar( i_message );
+    }
+
+    BOOST_CHECK( i_message.names == o_message.names );
+    BOOST_CHECK( i_message.values == o_message.values );
+
+    BOOST_CHECK( i_message.names.get_allocator().resource() == &counting );
+    for( auto const & name : i_message.names )
+      BOOST_CHECK( name.get_allocator().resource() == &counting );
+    for( auto const & value : i_message.values )
+    {
+      BOOST_CHECK( value.first.get_allocator().resource() == &counting );
+      BOOST_CHECK( value.second.get_allocator().resource() == &counting );
+    }
+  }
+  BOOST_CHECK_EQUAL( counting.allocations, counting.deallocations );
+}
+
+BOOST_AUTO_TEST_CASE( json_container_memory_resource )
+{
+  using Options = cereal::JSONOutputArchive::Options;
+  for( bool compact : { false, true } )
+    test_text_container_memory_resource<cereal::JSONInputArchive, cereal::JSONOutputArchive>(
+      Options( std::numeric_limits<double>::max_digits10, Options::IndentChar::space, 4, compact ) );
+}
+
+BOOST_AUTO_TEST_CASE( xml_container_memory_resource )
+{
+  for( bool compact : { false, true } )
+    test_text_container_memory_resource<cereal::XMLInputArchive, cereal::XMLOutputArchive>(
+      cereal::XMLOutputArchive::Options( std::numeric_limits<double>::max_digits10, true, false, false, compact ) );
+}
@@ -0,0 +1,127 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <boost/test/unit_test.hpp>
+
+template <class IArchive, class OArchive>
+void test_binary_data()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  std::vector<size_t> sizes;
+  for( size_t i = 0; i < 100; ++i )
+    sizes.push_back( i );
+  for( size_t i = 0; i < 20; ++i )
+    sizes.push_back( random_value<size_t>(gen) % 10000 );
+
+  for( auto size : sizes )
+  {
+    std::vector<unsigned char> o_data( size );
+    for( auto & c : o_data )
+      c = random_value<unsigned char>(gen);
+
+    std::ostringstream os;
+    {
+      OArchive oar(os);
+      oar.saveBinaryValue( o_data.data(), o_data.size() );
+      oar.saveBinaryValue( o_data.data(), o_data.size(), "named" );
+    }
+
+    std::vector<unsigned char> i_data( size + 1, 0x5a );
+    std::vector<unsigned char> i_named( size );
+
+    std::istringstream is(os.str());
+    {
+      IArchive iar(is);
+      iar.loadBinaryValue( i_data.data(), size );
+      iar.loadBinaryValue( i_named.data(), i_named.size(), "named" );
+    }
+
+    BOOST_CHECK_EQUAL_COLLECTIONS( i_data.begin(), i_data.begin() + size, o_data.begin(), o_data.end() );
+    BOOST_CHECK_EQUAL( i_data[size], 0x5a ); // nothing is written past the destination
+    BOOST_CHECK_EQUAL_COLLECTIONS( i_named.begin(), i_named.end(), o_data.begin(), o_data.end() );
+
+    // The size given when loading must match what was saved
+    std::vector<unsigned char> i_wrong( size + 3 );
+    std::istringstream is_wrong(os.str());
+    {
+      IArchive iar(is_wrong);
+      BOOST_CHECK_THROW( iar.loadBinaryValue( i_wrong.data(), i_wrong.size() ), cereal::Exception );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( xml_binary_data )
+{
+  test_binary_data<cereal::XMLInputArchive, cereal::XMLOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( json_binary_data )
+{
+  test_binary_data<cereal::JSONInputArchive, cereal::JSONOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( base64_codec )
+{
+  // Test vectors from RFC 4648
+  std::vector<std::pair<std::string, std::string>> const vectors = {
+    { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+    { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" } };
+
+  for( auto const & v : vectors )
+  {
+    auto const encoded = base64::encode( reinterpret_cast<unsigned char const *>( v.first.data() ), v.first.size() );
+    BOOST_CHECK_EQUAL( encoded, v.second );
+    BOOST_CHECK_EQUAL( base64::encoded_size( v.first.size() ), v.second.size() );
+    BOOST_CHECK_EQUAL( base64::decoded_size( v.second.data(), v.second.size() ), v.first.size() );
+    BOOST_CHECK_EQUAL( base64::decode( v.second ), v.first );
+  }
+
+  // Long inputs go through the vectorized paths, if any, and must agree with the tail handling
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for( size_t size = 0; size < 200; ++size )
+  {
+    std::string data( size, '\0' );
+    for( auto & c : data )
+      c = static_cast<char>( random_value<unsigned char>(gen) );
+
+    auto const encoded = base64::encode( reinterpret_cast<unsigned char const *>( data.data() ), data.size() );
+    BOOST_CHECK_EQUAL( encoded.size(), base64::encoded_size( size ) );
+    BOOST_CHECK_EQUAL( base64::decode( encoded ), data );
+
+    // Decoding stops at the first character outside of the alphabet
+    if( encoded.size() >= 8 )
+    {
+      std::string corrupted = encoded;
+      corrupted[4] = '!';
+      BOOST_CHECK_EQUAL( base64::decode( corrupted ), data.substr( 0, 3 ) );
+    }
+  }
+}
@@ -209,4 +209,42 @@ struct StructHash {
     }
 };
 
+//! A document for the text archive tests, with nested objects, a map and a string
+struct TextArchiveData
+{
+  std::vector<StructInternalSerialize> vec;
+  std::map<std::string, double> map;
+  std::string str;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( CEREAL_NVP(vec), CEREAL_NVP(map), CEREAL_NVP(str) );
+  }
+
+  bool operator==( TextArchiveData const & other ) const
+  {
+    return vec == other.vec && map == other.map && str == other.str;
+  }
+};
+
+inline std::ostream& operator<<(std::ostream& os, TextArchiveData const & d)
+{
+  return os << "[vec(" << d.vec.size() << ") map(" << d.map.size() << ") str(" << d.str << ")]";
+}
+
+//! Random data with size elements in each container, and str, which typically needs escaping
+inline TextArchiveData make_text_archive_data( std::mt19937 & gen, size_t size, std::string const & str )
+{
+  TextArchiveData data;
+  for( size_t i = 0; i < size; ++i )
+  {
+    data.vec.emplace_back( random_value<int>(gen), random_value<int>(gen) );
+    data.map.emplace( random_basic_string<char>(gen), random_value<double>(gen) );
+  }
+  data.str = str;
+
+  return data;
+}
+
 #endif // CEREAL_TEST_COMMON_H_
@@ -0,0 +1,309 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <cereal/types/deferred.hpp>
+#include <cereal/archives/sizing.hpp>
+#include <boost/test/unit_test.hpp>
+
+static int deferredLoads = 0;
+
+struct DeferredAttachment
+{
+  DeferredAttachment( std::string n ) : name( std::move( n ) ) {}
+
+  std::string name;
+  std::vector<int32_t> data;
+
+  template <class Archive>
+  void save( Archive & ar ) const
+  { ar( name, data ); }
+
+  template <class Archive>
+  static void load_and_construct( Archive & ar, cereal::construct<DeferredAttachment> & construct )
+  {
+    ++deferredLoads;
+    std::string name;
+    ar( name );
+    construct( name );
+    ar( construct->data );
+  }
+};
+
+struct DeferredSession
+{
+  int32_t id;
+  cereal::Deferred<std::vector<double>> history;
+  cereal::Deferred<DeferredAttachment> attachment;
+  cereal::Deferred<DeferredAttachment> missing;
+  std::string trailer;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( id, history, attachment, missing, trailer ); }
+};
+
+//! A stream buffer over a string that cannot seek
+class DeferredUnseekableBuffer : public std::stringbuf
+{
+  public:
+    DeferredUnseekableBuffer( std::string const & s ) : std::stringbuf( s ) {}
+
+  protected:
+    pos_type seekoff( off_type, std::ios_base::seekdir, std::ios_base::openmode ) override
+    { return pos_type( off_type( -1 ) ); }
+
+    pos_type seekpos( pos_type, std::ios_base::openmode ) override
+    { return pos_type( off_type( -1 ) ); }
+};
+
+template <class IArchive, class OArchive>
+void test_deferred( bool lazy )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  DeferredSession o_session;
+  o_session.id = random_value<int32_t>(gen);
+  std::vector<double> o_history( 1000 );
+  for( auto & h : o_history )
+    h = random_value<double>(gen);
+  o_session.history = cereal::Deferred<std::vector<double>>( o_history );
+  o_session.attachment.reset( std::unique_ptr<DeferredAttachment>( new DeferredAttachment( random_basic_string<char>(gen) ) ) );
+  o_session.attachment->data.assign( 50, random_value<int32_t>(gen) );
+  o_session.trailer = random_basic_string<char>(gen);
+  int32_t const o_after = random_value<int32_t>(gen);
+
+  std::ostringstream os;
+  {
+    OArchive oar( os );
+    oar( o_session, o_after );
+  }
+
+  for( bool seekable : { true, false } )
+  {
+    deferredLoads = 0;
+
+    std::istringstream seekableStream( os.str() );
+    DeferredUnseekableBuffer unseekableBuffer( os.str() );
+    std::istream unseekableStream( &unseekableBuffer );
+    std::istream & is = seekable ? static_cast<std::istream &>( seekableStream ) : unseekableStream;
+
+    DeferredSession i_session;
+    int32_t i_after;
+    IArchive iar( is );
+    iar( i_session, i_after );
+
+    // Everything around the deferred values is loaded as usual
+    BOOST_CHECK_EQUAL( i_session.id, o_session.id );
+    BOOST_CHECK_EQUAL( i_session.trailer, o_session.trailer );
+    BOOST_CHECK_EQUAL( i_after, o_after );
+
+    BOOST_CHECK_EQUAL( !i_session.attachment.isLoaded(), lazy );
+    BOOST_CHECK_EQUAL( deferredLoads, lazy ? 0 : 1 );
+
+    auto const position = is.tellg();
+
+    BOOST_REQUIRE( i_session.attachment );
+    BOOST_CHECK_EQUAL( deferredLoads, 1 );
+    BOOST_CHECK( i_session.attachment.isLoaded() );
+    BOOST_CHECK_EQUAL( i_session.attachment->name, o_session.attachment->name );
+    BOOST_CHECK( i_session.attachment->data == o_session.attachment->data );
+
+    BOOST_CHECK( *i_session.history == o_history );
+    BOOST_CHECK( !i_session.missing );
+    BOOST_CHECK_EQUAL( deferredLoads, 1 );
+
+    // Decoding leaves the stream where it was
+    BOOST_CHECK( is.tellg() == position );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( binary_deferred )
+{
+  test_deferred<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>( true );
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_deferred )
+{
+  test_deferred<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>( true );
+}
+
+BOOST_AUTO_TEST_CASE( json_deferred )
+{
+  test_deferred<cereal::JSONInputArchive, cereal::JSONOutputArchive>( false );
+}
+
+BOOST_AUTO_TEST_CASE( xml_deferred )
+{
+  test_deferred<cereal::XMLInputArchive, cereal::XMLOutputArchive>( false );
+}
+
+template <class IArchive, class OArchive>
+void test_deferred_in_stream()
+{
+  std::mt19937 gen(std::random_device{}());
+
+  std::vector<DeferredSession> o_sessions( 5 );
+  for( auto & o_session : o_sessions )
+  {
+    o_session.id = random_value<int32_t>(gen);
+    o_session.attachment.reset( std::unique_ptr<DeferredAttachment>( new DeferredAttachment( random_basic_string<char>(gen) ) ) );
+    o_session.attachment->data.assign( 50, random_value<int32_t>(gen) );
+    o_session.trailer = random_basic_string<char>(gen);
+  }
+
+  std::ostringstream os;
+  {
+    OArchive oar( os );
+    oar( o_sessions );
+  }
+
+  for( bool sameStream : { true, false } )
+  {
+    deferredLoads = 0;
+    std::vector<DeferredSession> i_sessions;
+    {
+      auto is = std::make_shared<std::istringstream>( os.str() );
+      IArchive iar( *is );
+
+      // Sharing a stream the archive does not read leaves values in memory
+      iar.setSharedStream( sameStream ? is : std::make_shared<std::istringstream>() );
+      iar( i_sessions );
+
+      // Values left in the stream are only read from it when accessed
+      if( sameStream )
+      {
+        is->str( std::string( os.str().size(), 'x' ) );
+        BOOST_CHECK_THROW( i_sessions.front().attachment.get(), std::exception );
+        is->str( os.str() );
+        deferredLoads = 0;
+      }
+    }
+
+    BOOST_REQUIRE_EQUAL( i_sessions.size(), o_sessions.size() );
+    for( size_t i = 0; i < i_sessions.size(); ++i )
+    {
+      BOOST_CHECK_EQUAL( i_sessions[i].trailer, o_sessions[i].trailer );
+      BOOST_CHECK( !i_sessions[i].attachment.isLoaded() );
+    }
+    BOOST_CHECK_EQUAL( deferredLoads, 0 );
+
+    // Each value keeps the stream alive after the archive and everything else are gone
+    for( size_t i = 0; i < i_sessions.size(); ++i )
+    {
+      BOOST_REQUIRE( i_sessions[i].attachment );
+      BOOST_CHECK_EQUAL( i_sessions[i].attachment->name, o_sessions[i].attachment->name );
+      BOOST_CHECK( i_sessions[i].attachment->data == o_sessions[i].attachment->data );
+      BOOST_CHECK( !i_sessions[i].history );
+    }
+    BOOST_CHECK_EQUAL( deferredLoads, static_cast<int>( o_sessions.size() ) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( binary_deferred_in_stream )
+{
+  test_deferred_in_stream<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_deferred_in_stream )
+{
+  test_deferred_in_stream<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( binary_deferred_options )
+{
+  std::mt19937 gen(std::random_device{}());
+  cereal::Deferred<std::vector<std::string>> o_value( std::vector<std::string>( 10, random_basic_string<char>(gen) + "padding" ) );
+
+  for( std::size_t intern : { std::size_t( 0 ), std::size_t( 64 ) } )
+  {
+    std::ostringstream os;
+    {
+      cereal::BinaryOutputArchive oar( os, cereal::BinaryOutputArchive::Options( false, intern ) );
+      oar( o_value );
+    }
+
+    cereal::SizingOutputArchive sizer( cereal::SizingOutputArchive::Format::Binary, false, intern );
+    sizer( o_value );
+    BOOST_CHECK_EQUAL( sizer.size(), os.str().size() );
+
+    // The value is saved with the options of the archive
+    if( intern )
+    {
+      std::ostringstream plain;
+      {
+        cereal::BinaryOutputArchive oar( plain );
+        oar( o_value );
+      }
+      BOOST_CHECK_LT( os.str().size(), plain.str().size() );
+    }
+
+    std::istringstream is( os.str() );
+    cereal::BinaryInputArchive iar( is );
+    cereal::Deferred<std::vector<std::string>> i_value;
+    iar( i_value );
+    BOOST_CHECK( *i_value == *o_value );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( deferred_resave )
+{
+  std::mt19937 gen(std::random_device{}());
+  cereal::Deferred<std::vector<std::string>> o_value( std::vector<std::string>( 10, random_basic_string<char>(gen) ) );
+
+  std::ostringstream first;
+  {
+    cereal::BinaryOutputArchive oar( first );
+    oar( o_value );
+  }
+
+  // Saving a value that was never decoded decodes it first
+  std::istringstream is( first.str() );
+  cereal::BinaryInputArchive iar( is );
+  cereal::Deferred<std::vector<std::string>> i_value;
+  iar( i_value );
+  BOOST_CHECK( !i_value.isLoaded() );
+
+  std::ostringstream second;
+  {
+    cereal::BinaryOutputArchive oar( second );
+    oar( i_value );
+  }
+  BOOST_CHECK_EQUAL( first.str(), second.str() );
+  BOOST_CHECK( *i_value == *o_value );
+
+  // Corrupt data only fails when decoded, and can be retried
+  auto corrupt = first.str();
+  corrupt.resize( corrupt.size() - 3 );
+  corrupt += std::string( 3, '\0' );
+  corrupt[sizeof(cereal::size_type) + 1] = 0x7f;
+  std::istringstream cs( corrupt );
+  cereal::BinaryInputArchive car( cs );
+  cereal::Deferred<std::vector<std::string>> c_value;
+  car( c_value );
+  BOOST_CHECK_THROW( c_value.get(), cereal::Exception );
+  BOOST_CHECK( !c_value.isLoaded() );
+}
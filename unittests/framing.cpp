@@ -0,0 +1,521 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <cereal/archives/sizing.hpp>
+#include <boost/test/unit_test.hpp>
+
+//! A record as saved by a newer producer, with fields an older reader does not know
+struct FramingRecordNew
+{
+  int32_t id;
+  std::string name;
+  std::vector<double> extra;
+  std::map<std::string, int32_t> moreExtra;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( id, name, extra, moreExtra ); }
+};
+
+//! The same record as known to an older reader
+struct FramingRecordOld
+{
+  int32_t id = -1;
+  std::string name;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( id, name ); }
+};
+
+//! A reader that only understands the first version, skipping newer objects entirely
+struct FramingRecordStrict
+{
+  int32_t id = -1;
+  std::string name;
+
+  template <class Archive>
+  void load( Archive & ar, std::uint32_t const version )
+  {
+    if( version > 1 )
+      return;
+    ar( id, name );
+  }
+
+  template <class Archive>
+  void save( Archive & ar, std::uint32_t const ) const
+  { ar( id, name ); }
+};
+
+//! A reader that expects more than an older producer wrote
+struct FramingRecordGreedy
+{
+  int32_t id;
+  std::string name;
+  int64_t expected;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( id, name, expected ); }
+};
+
+//! A versioned class holding framed objects of another versioned class
+struct FramingOuterNew
+{
+  FramingRecordNew record;
+  int32_t added;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( record, added ); }
+};
+
+struct FramingOuterOld
+{
+  FramingRecordOld record;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( record ); }
+};
+
+CEREAL_CLASS_VERSION( FramingRecordNew, 2 );
+CEREAL_CLASS_VERSION( FramingRecordOld, 1 );
+CEREAL_CLASS_VERSION( FramingRecordStrict, 1 );
+
+//! A stream buffer over a string that cannot seek
+class FramingUnseekableBuffer : public std::stringbuf
+{
+  public:
+    FramingUnseekableBuffer( std::string const & s ) : std::stringbuf( s ) {}
+
+  protected:
+    pos_type seekoff( off_type, std::ios_base::seekdir, std::ios_base::openmode ) override
+    { return pos_type( off_type( -1 ) ); }
+
+    pos_type seekpos( pos_type, std::ios_base::openmode ) override
+    { return pos_type( off_type( -1 ) ); }
+};
+
+std::vector<FramingRecordNew> framing_records( std::mt19937 & gen )
+{
+  std::vector<FramingRecordNew> records( 20 );
+  int32_t id = 0;
+  for( auto & r : records )
+  {
+    r.id = id++;
+    r.name = random_basic_string<char>( gen );
+    r.extra.resize( gen() % 50 );
+    for( auto & e : r.extra )
+      e = random_value<double>( gen );
+    for( int i = 0; i < 3; ++i )
+      r.moreExtra[random_basic_string<char>( gen )] = random_value<int32_t>( gen );
+  }
+  return records;
+}
+
+template <class IArchive, class OArchive>
+void test_framing_trailing_fields()
+{
+  std::random_device rd;
+  std::mt19937 gen( rd() );
+
+  auto const records = framing_records( gen );
+  FramingOuterNew outer;
+  outer.record = records.front();
+  outer.added = 42;
+
+  std::ostringstream os;
+  {
+    OArchive oar( os, typename OArchive::Options( true ) );
+    oar( records, outer, std::string( "trailer" ) );
+  }
+
+  for( int seekable = 0; seekable < 2; ++seekable )
+  {
+    std::vector<FramingRecordOld> loaded;
+    FramingOuterOld loadedOuter;
+    std::string trailer;
+
+    std::istringstream is( os.str() );
+    FramingUnseekableBuffer unseekable( os.str() );
+    std::istream unseekableStream( &unseekable );
+    {
+      IArchive iar( seekable ? static_cast<std::istream &>( is ) : unseekableStream );
+      iar( loaded, loadedOuter, trailer );
+    }
+
+    BOOST_REQUIRE_EQUAL( loaded.size(), records.size() );
+    for( std::size_t i = 0; i < records.size(); ++i )
+    {
+      BOOST_CHECK_EQUAL( loaded[i].id, records[i].id );
+      BOOST_CHECK_EQUAL( loaded[i].name, records[i].name );
+    }
+    BOOST_CHECK_EQUAL( loadedOuter.record.id, outer.record.id );
+    BOOST_CHECK_EQUAL( loadedOuter.record.name, outer.record.name );
+    BOOST_CHECK_EQUAL( trailer, "trailer" );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( binary_framing_trailing_fields )
+{
+  test_framing_trailing_fields<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_framing_trailing_fields )
+{
+  test_framing_trailing_fields<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
+
+template <class IArchive, class OArchive>
+void test_framing_skip_objects()
+{
+  std::random_device rd;
+  std::mt19937 gen( rd() );
+
+  auto const records = framing_records( gen );
+
+  std::ostringstream os;
+  {
+    OArchive oar( os, OArchive::Options::Framed() );
+    oar( records, int32_t( 7 ) );
+  }
+
+  std::vector<FramingRecordStrict> loaded;
+  int32_t trailer = 0;
+  {
+    std::istringstream is( os.str() );
+    IArchive iar( is );
+    iar( loaded, trailer );
+  }
+
+  BOOST_REQUIRE_EQUAL( loaded.size(), records.size() );
+  for( auto const & r : loaded )
+  {
+    BOOST_CHECK_EQUAL( r.id, -1 );
+    BOOST_CHECK( r.name.empty() );
+  }
+  BOOST_CHECK_EQUAL( trailer, 7 );
+}
+
+BOOST_AUTO_TEST_CASE( binary_framing_skip_objects )
+{
+  test_framing_skip_objects<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_framing_skip_objects )
+{
+  test_framing_skip_objects<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
+
+template <class IArchive, class OArchive>
+void test_framing_round_trip( bool framed )
+{
+  std::random_device rd;
+  std::mt19937 gen( rd() );
+
+  auto const records = framing_records( gen );
+  std::vector<FramingRecordStrict> strict( 5 );
+  for( auto & s : strict )
+  {
+    s.id = random_value<int32_t>( gen );
+    s.name = random_basic_string<char>( gen );
+  }
+
+  std::ostringstream os;
+  {
+    OArchive oar( os, typename OArchive::Options( framed ) );
+    oar( records, strict );
+  }
+
+  // Frames are held in memory for streams that cannot seek, with the same result
+  FramingUnseekableBuffer unseekable( "" );
+  {
+    std::ostream us( &unseekable );
+    OArchive oar( us, typename OArchive::Options( framed ) );
+    oar( records, strict );
+  }
+  BOOST_CHECK( unseekable.str() == os.str() );
+
+  std::vector<FramingRecordNew> loaded;
+  std::vector<FramingRecordStrict> loadedStrict;
+  {
+    std::istringstream is( os.str() );
+    IArchive iar( is );
+    iar( loaded, loadedStrict );
+  }
+
+  BOOST_REQUIRE_EQUAL( loaded.size(), records.size() );
+  for( std::size_t i = 0; i < records.size(); ++i )
+  {
+    BOOST_CHECK_EQUAL( loaded[i].id, records[i].id );
+    BOOST_CHECK_EQUAL( loaded[i].name, records[i].name );
+    BOOST_CHECK_EQUAL_COLLECTIONS( loaded[i].extra.begin(), loaded[i].extra.end(), records[i].extra.begin(), records[i].extra.end() );
+    BOOST_CHECK( loaded[i].moreExtra == records[i].moreExtra );
+  }
+  for( std::size_t i = 0; i < strict.size(); ++i )
+  {
+    BOOST_CHECK_EQUAL( loadedStrict[i].id, strict[i].id );
+    BOOST_CHECK_EQUAL( loadedStrict[i].name, strict[i].name );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( binary_framing_round_trip )
+{
+  test_framing_round_trip<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>( false );
+  test_framing_round_trip<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>( true );
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_framing_round_trip )
+{
+  test_framing_round_trip<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>( false );
+  test_framing_round_trip<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>( true );
+}
+
+//! A versioned type that checks how much has reached the stream while it is saved
+struct FramingProbe
+{
+  static std::ostringstream * stream;
+  static std::size_t seen;
+
+  std::string payload;
+
+  template <class Archive>
+  void save( Archive & ar, std::uint32_t const ) const
+  {
+    ar( payload );
+    seen = stream->str().size();
+  }
+
+  template <class Archive>
+  void load( Archive & ar, std::uint32_t const )
+  { ar( payload ); }
+};
+
+std::ostringstream * FramingProbe::stream = nullptr;
+std::size_t FramingProbe::seen = 0;
+
+BOOST_AUTO_TEST_CASE( binary_framing_in_place )
+{
+  FramingProbe o_probe;
+  o_probe.payload.assign( 1000, 'p' );
+
+  // On a seekable stream a frame goes straight to the stream, with its size patched in afterwards
+  std::ostringstream os;
+  FramingProbe::stream = &os;
+  {
+    cereal::BinaryOutputArchive oar( os, cereal::BinaryOutputArchive::Options::Framed() );
+    oar( o_probe );
+  }
+  BOOST_CHECK_GT( FramingProbe::seen, o_probe.payload.size() );
+
+  FramingProbe i_probe;
+  std::istringstream is( os.str() );
+  cereal::BinaryInputArchive iar( is );
+  iar( i_probe );
+  BOOST_CHECK_EQUAL( i_probe.payload, o_probe.payload );
+}
+
+BOOST_AUTO_TEST_CASE( binary_framing_read_past_end )
+{
+  FramingRecordOld record;
+  record.id = 3;
+  record.name = "short";
+
+  std::ostringstream os;
+  {
+    cereal::BinaryOutputArchive oar( os, cereal::BinaryOutputArchive::Options::Framed() );
+    oar( record, std::string( "padding after the frame" ) );
+  }
+
+  std::istringstream is( os.str() );
+  cereal::BinaryInputArchive iar( is );
+  FramingRecordGreedy loaded;
+  BOOST_CHECK_THROW( iar( loaded ), cereal::Exception );
+}
+
+BOOST_AUTO_TEST_CASE( binary_framing_sizing )
+{
+  std::random_device rd;
+  std::mt19937 gen( rd() );
+
+  auto const records = framing_records( gen );
+  FramingOuterNew outer;
+  outer.record = records.back();
+  outer.added = 1;
+
+  std::ostringstream os;
+  {
+    cereal::BinaryOutputArchive oar( os, cereal::BinaryOutputArchive::Options::Framed() );
+    oar( records, outer );
+  }
+
+  cereal::SizingOutputArchive sizer( cereal::SizingOutputArchive::Format::Binary, true );
+  sizer( records, outer );
+  BOOST_CHECK_EQUAL( sizer.size(), os.str().size() );
+}
+
+//! A versioned class first saved within the frame of another
+struct FramingInner
+{
+  int32_t value = -1;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( value ); }
+};
+
+//! Holds the first copies of a class version and a pointer target
+struct FramingHolderNew
+{
+  FramingInner inner;
+  std::shared_ptr<int32_t> shared;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( inner, shared ); }
+};
+
+//! The same holder as known to an older reader, which skips newer versions entirely
+struct FramingHolderStrict
+{
+  FramingInner inner;
+  std::shared_ptr<int32_t> shared;
+
+  template <class Archive>
+  void load( Archive & ar, std::uint32_t const version )
+  {
+    if( version > 1 )
+      return;
+    ar( inner, shared );
+  }
+
+  template <class Archive>
+  void save( Archive & ar, std::uint32_t const ) const
+  { ar( inner, shared ); }
+};
+
+template <class Holder>
+struct FramingHolderOuter
+{
+  Holder holder;
+  FramingInner after;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( holder, after ); }
+};
+
+CEREAL_CLASS_VERSION( FramingInner, 3 );
+CEREAL_CLASS_VERSION( FramingHolderNew, 2 );
+CEREAL_CLASS_VERSION( FramingHolderStrict, 1 );
+
+template <class IArchive, class OArchive>
+void test_framing_skip_first_copies()
+{
+  FramingHolderNew holder;
+  holder.inner.value = 5;
+  holder.shared = std::make_shared<int32_t>( 6 );
+
+  std::ostringstream os;
+  {
+    OArchive oar( os, OArchive::Options::Framed() );
+    oar( holder, holder.inner, holder.shared, holder );
+  }
+
+  // Everything first saved within a skipped outermost frame is saved again after it
+  {
+    FramingHolderStrict strict, strictAgain;
+    FramingInner inner;
+    std::shared_ptr<int32_t> shared;
+
+    std::istringstream is( os.str() );
+    IArchive iar( is );
+    iar( strict, inner, shared, strictAgain );
+
+    BOOST_CHECK_EQUAL( strict.inner.value, -1 );
+    BOOST_CHECK_EQUAL( inner.value, 5 );
+    BOOST_REQUIRE( shared );
+    BOOST_CHECK_EQUAL( *shared, 6 );
+    BOOST_CHECK( !strictAgain.shared );
+  }
+
+  // Those that do not skip see the same values
+  {
+    FramingHolderNew loaded, loadedAgain;
+    FramingInner inner;
+    std::shared_ptr<int32_t> shared;
+
+    std::istringstream is( os.str() );
+    IArchive iar( is );
+    iar( loaded, inner, shared, loadedAgain );
+
+    BOOST_CHECK_EQUAL( loaded.inner.value, 5 );
+    BOOST_CHECK_EQUAL( inner.value, 5 );
+    BOOST_CHECK_EQUAL( *loaded.shared, 6 );
+    BOOST_CHECK_EQUAL( *shared, 6 );
+    BOOST_CHECK_EQUAL( loadedAgain.inner.value, 5 );
+    BOOST_CHECK_EQUAL( *loadedAgain.shared, 6 );
+  }
+
+  // A nested frame holding first copies cannot be skipped
+  FramingHolderOuter<FramingHolderNew> outer;
+  outer.holder = holder;
+  outer.after.value = 7;
+
+  std::ostringstream nested;
+  {
+    OArchive oar( nested, OArchive::Options::Framed() );
+    oar( outer );
+  }
+
+  {
+    FramingHolderOuter<FramingHolderNew> loaded;
+    std::istringstream is( nested.str() );
+    IArchive iar( is );
+    iar( loaded );
+    BOOST_CHECK_EQUAL( loaded.holder.inner.value, 5 );
+    BOOST_CHECK_EQUAL( loaded.after.value, 7 );
+  }
+
+  {
+    FramingHolderOuter<FramingHolderStrict> loaded;
+    std::istringstream is( nested.str() );
+    IArchive iar( is );
+    BOOST_CHECK_THROW( iar( loaded ), cereal::Exception );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( binary_framing_skip_first_copies )
+{
+  test_framing_skip_first_copies<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_framing_skip_first_copies )
+{
+  test_framing_skip_first_copies<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
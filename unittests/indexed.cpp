@@ -0,0 +1,191 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <cereal/archives/indexed.hpp>
+#include <boost/test/unit_test.hpp>
+
+struct IndexedRecord
+{
+  std::string name;
+  std::vector<double> values;
+  std::shared_ptr<int> shared;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( name, values, shared ); }
+
+  bool operator==( IndexedRecord const & other ) const
+  {
+    return name == other.name && values == other.values &&
+           ( shared ? other.shared && *shared == *other.shared : !other.shared );
+  }
+};
+
+CEREAL_CLASS_VERSION(IndexedRecord, 1)
+
+IndexedRecord make_indexed_record( std::mt19937 & gen )
+{
+  IndexedRecord r;
+  r.name = random_basic_string<char>(gen);
+  r.values.resize( gen() % 100 );
+  for( auto & v : r.values )
+    v = random_value<double>(gen);
+  r.shared = std::make_shared<int>( random_value<int>(gen) );
+  return r;
+}
+
+template <class IArchive, class OArchive>
+void test_indexed()
+{
+  std::mt19937 gen(std::random_device{}());
+
+  std::vector<IndexedRecord> o_records;
+  for( int i = 0; i < 20; ++i )
+    o_records.push_back( make_indexed_record( gen ) );
+  std::map<std::string, int> const o_config = { { "threads", 8 }, { "retries", 3 } };
+  int32_t const o_a = random_value<int32_t>(gen);
+  double const o_b = random_value<double>(gen);
+
+  // Indexed data may follow other data in the stream
+  std::string const prefix = "header";
+  std::ostringstream os;
+  os << prefix;
+  {
+    cereal::IndexedOutputArchive<OArchive> oar( os );
+    oar.add( "config", o_config );
+    for( auto const & r : o_records )
+      oar( r );
+    oar.add( "pair", o_a, o_b );
+
+    BOOST_CHECK_EQUAL( oar.entries().size(), 22 );
+    BOOST_CHECK_THROW( oar.add( "config", o_a ), cereal::Exception );
+    BOOST_CHECK_THROW( oar.add( "", o_a ), cereal::Exception );
+  }
+
+  std::istringstream is( os.str() );
+  cereal::IndexedInputArchive<IArchive> iar( is );
+
+  BOOST_REQUIRE_EQUAL( iar.size(), 22 );
+  BOOST_CHECK_EQUAL( iar.entries()[0].name, "config" );
+  BOOST_CHECK_EQUAL( iar.entries()[1].name, "" );
+  BOOST_CHECK_EQUAL( iar.entries()[21].name, "pair" );
+  BOOST_CHECK_EQUAL( iar.find( "pair" ), 21 );
+  BOOST_CHECK_EQUAL( iar.find( "missing" ), 22 );
+
+  // Entries load alone, in any order, and repeatedly
+  for( size_t i : { 15, 3, 15, 1, 20 } )
+  {
+    IndexedRecord i_record;
+    iar.load( i, i_record );
+    BOOST_CHECK( i_record == o_records[i - 1] );
+  }
+
+  int32_t i_a;
+  double i_b;
+  iar.load( "pair", i_a, i_b );
+  BOOST_CHECK_EQUAL( i_a, o_a );
+  BOOST_CHECK_EQUAL( i_b, o_b );
+
+  std::map<std::string, int> i_config;
+  iar.load( "config", i_config );
+  BOOST_CHECK( i_config == o_config );
+
+  BOOST_CHECK_THROW( iar.load( "missing", i_a ), cereal::Exception );
+  BOOST_CHECK_THROW( iar.load( 22, i_a ), cereal::Exception );
+
+  // Reading past the end of an entry fails instead of reading the next one
+  int64_t extra[100];
+  BOOST_CHECK_THROW( iar.load( "pair", cereal::binary_data( extra, sizeof(extra) ) ), cereal::Exception );
+}
+
+BOOST_AUTO_TEST_CASE( binary_indexed )
+{
+  test_indexed<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_indexed )
+{
+  test_indexed<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
+
+//! A stream buffer over a string that accepts at most a fixed number of bytes
+class IndexedLimitedBuffer : public std::stringbuf
+{
+  public:
+    IndexedLimitedBuffer( std::size_t capacity ) : itsCapacity( capacity ) {}
+
+  protected:
+    std::streamsize xsputn( char const * s, std::streamsize n ) override
+    {
+      auto const room = static_cast<std::streamsize>( itsCapacity - str().size() );
+      return std::stringbuf::xsputn( s, std::min( n, room ) );
+    }
+
+    int_type overflow( int_type c ) override
+    {
+      if( str().size() >= itsCapacity )
+        return traits_type::eof();
+      return std::stringbuf::overflow( c );
+    }
+
+  private:
+    std::size_t itsCapacity;
+};
+
+BOOST_AUTO_TEST_CASE( indexed_full_stream )
+{
+  // The table of contents of an empty archive fits, but not the trailer after it
+  IndexedLimitedBuffer buffer( sizeof(std::uint64_t) + 4 );
+  std::ostream os( &buffer );
+  cereal::IndexedOutputArchive<> oar( os );
+  BOOST_CHECK_THROW( oar.finish(), cereal::Exception );
+}
+
+BOOST_AUTO_TEST_CASE( indexed_invalid )
+{
+  {
+    std::istringstream is( "not an indexed archive at all" );
+    BOOST_CHECK_THROW( cereal::IndexedInputArchive<> iar( is ), cereal::Exception );
+  }
+
+  {
+    std::istringstream is( "short" );
+    BOOST_CHECK_THROW( cereal::IndexedInputArchive<> iar( is ), cereal::Exception );
+  }
+
+  // An empty indexed archive is valid
+  std::ostringstream os;
+  {
+    cereal::IndexedOutputArchive<> oar( os );
+    oar.finish();
+    BOOST_CHECK_THROW( oar( 5 ), cereal::Exception );
+  }
+
+  std::istringstream is( os.str() );
+  cereal::IndexedInputArchive<> iar( is );
+  BOOST_CHECK_EQUAL( iar.size(), 0 );
+}
@@ -0,0 +1,231 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <cereal/archives/sizing.hpp>
+#include <boost/test/unit_test.hpp>
+
+struct InterningQuote
+{
+  std::string symbol;
+  std::string venue;
+  double price;
+  std::wstring note;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( symbol, venue, price, note ); }
+};
+
+std::vector<InterningQuote> interning_quotes( std::mt19937 & gen )
+{
+  std::vector<std::string> const symbols = { "AAPL", "MSFT", "GOOG", "", std::string( 100, 'x' ) };
+  std::vector<std::string> const venues = { "NASDAQ", "NYSE" };
+
+  std::vector<InterningQuote> quotes( 500 );
+  for( auto & q : quotes )
+  {
+    q.symbol = symbols[gen() % symbols.size()];
+    q.venue = venues[gen() % venues.size()];
+    q.price = random_value<double>( gen );
+    q.note = gen() % 2 ? L"open" : random_basic_string<wchar_t>( gen );
+  }
+  return quotes;
+}
+
+template <class IArchive, class OArchive>
+void test_interning()
+{
+  std::random_device rd;
+  std::mt19937 gen( rd() );
+
+  auto const quotes = interning_quotes( gen );
+  std::map<std::string, std::string> const keyed = { { "NASDAQ", "NYSE" }, { "NYSE", "NASDAQ" } };
+
+  std::ostringstream plain;
+  {
+    OArchive oar( plain );
+    oar( quotes, keyed );
+  }
+
+  std::ostringstream interned;
+  {
+    OArchive oar( interned, typename OArchive::Options( false, 16 ) );
+    oar( quotes, keyed );
+  }
+
+  BOOST_CHECK_LT( interned.str().size(), plain.str().size() );
+
+  for( auto const & data : { plain.str(), interned.str() } )
+  {
+    std::vector<InterningQuote> loaded;
+    std::map<std::string, std::string> loadedKeyed;
+    {
+      std::istringstream is( data );
+      IArchive iar( is );
+      iar( loaded, loadedKeyed );
+    }
+
+    BOOST_REQUIRE_EQUAL( loaded.size(), quotes.size() );
+    for( std::size_t i = 0; i < quotes.size(); ++i )
+    {
+      BOOST_CHECK_EQUAL( loaded[i].symbol, quotes[i].symbol );
+      BOOST_CHECK_EQUAL( loaded[i].venue, quotes[i].venue );
+      BOOST_CHECK_CLOSE( loaded[i].price, quotes[i].price, 1e-5 );
+      BOOST_CHECK( loaded[i].note == quotes[i].note );
+    }
+    BOOST_CHECK( loadedKeyed == keyed );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( binary_interning )
+{
+  test_interning<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_interning )
+{
+  test_interning<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( binary_interning_sizing )
+{
+  std::random_device rd;
+  std::mt19937 gen( rd() );
+
+  auto const quotes = interning_quotes( gen );
+
+  std::ostringstream os;
+  {
+    cereal::BinaryOutputArchive oar( os, cereal::BinaryOutputArchive::Options( false, 16 ) );
+    oar( quotes );
+  }
+
+  cereal::SizingOutputArchive sizer( cereal::SizingOutputArchive::Format::Binary, false, 16 );
+  sizer( quotes );
+  BOOST_CHECK_EQUAL( sizer.size(), os.str().size() );
+}
+
+BOOST_AUTO_TEST_CASE( binary_interning_unknown_reference )
+{
+  std::ostringstream os;
+  {
+    cereal::BinaryOutputArchive oar( os );
+    oar( cereal::make_size_tag( cereal::detail::interned_reference_flag | 3 ) );
+  }
+
+  std::istringstream is( os.str() );
+  cereal::BinaryInputArchive iar( is );
+  std::string loaded;
+  BOOST_CHECK_THROW( iar( loaded ), cereal::Exception );
+}
+
+//! A versioned record whose strings are interned within its frame
+struct InterningFramedNew
+{
+  std::string venue;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( venue ); }
+};
+
+//! The same record as known to an older reader, which skips newer versions entirely
+struct InterningFramedStrict
+{
+  std::string venue;
+
+  template <class Archive>
+  void load( Archive & ar, std::uint32_t const version )
+  {
+    if( version > 1 )
+      return;
+    ar( venue );
+  }
+
+  template <class Archive>
+  void save( Archive & ar, std::uint32_t const ) const
+  { ar( venue ); }
+};
+
+CEREAL_CLASS_VERSION( InterningFramedNew, 2 );
+CEREAL_CLASS_VERSION( InterningFramedStrict, 1 );
+
+template <class IArchive, class OArchive>
+void test_interning_framed()
+{
+  InterningFramedNew record;
+  record.venue = "NASDAQ";
+  std::vector<std::string> const venues = { "NASDAQ", "NYSE", "NASDAQ" };
+
+  std::ostringstream os;
+  {
+    OArchive oar( os, typename OArchive::Options( true, 16 ) );
+    oar( record, venues, record );
+  }
+
+  // Strings first interned within a skipped frame are written in full again after it
+  {
+    InterningFramedStrict skipped, skippedAgain;
+    std::vector<std::string> loadedVenues;
+
+    std::istringstream is( os.str() );
+    IArchive iar( is );
+    iar( skipped, loadedVenues, skippedAgain );
+
+    BOOST_CHECK( skipped.venue.empty() );
+    BOOST_CHECK( loadedVenues == venues );
+  }
+
+  {
+    InterningFramedNew loaded, loadedAgain;
+    std::vector<std::string> loadedVenues;
+
+    std::istringstream is( os.str() );
+    IArchive iar( is );
+    iar( loaded, loadedVenues, loadedAgain );
+
+    BOOST_CHECK_EQUAL( loaded.venue, record.venue );
+    BOOST_CHECK( loadedVenues == venues );
+    BOOST_CHECK_EQUAL( loadedAgain.venue, record.venue );
+  }
+
+  auto const format = std::is_same<OArchive, cereal::BinaryOutputArchive>::value ?
+    cereal::SizingOutputArchive::Format::Binary : cereal::SizingOutputArchive::Format::PortableBinary;
+  cereal::SizingOutputArchive sizer( format, true, 16 );
+  sizer( record, venues, record );
+  BOOST_CHECK_EQUAL( sizer.size(), os.str().size() );
+}
+
+BOOST_AUTO_TEST_CASE( binary_interning_framed )
+{
+  test_interning_framed<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_interning_framed )
+{
+  test_interning_framed<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
@@ -0,0 +1,100 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <boost/test/unit_test.hpp>
+
+TextArchiveData make_json_archive_data( std::mt19937 & gen, size_t size )
+{
+  return make_text_archive_data( gen, size, "\"escaped\"\n\\ string" );
+}
+
+BOOST_AUTO_TEST_CASE( json_archive_context )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  cereal::JSONContext context( 1024 );
+
+  // Messages of varying size, so the context has to grow, then gets reused
+  for( size_t size : { 1, 10, 1000, 5, 0, 1000, 20 } )
+  {
+    auto const o_data = make_json_archive_data( gen, size );
+
+    std::ostringstream os;
+    {
+      cereal::JSONOutputArchive oar( os );
+      oar( o_data );
+    }
+
+    std::ostringstream os_context;
+    {
+      cereal::JSONOutputArchive oar( os_context, context );
+      oar( o_data );
+    }
+
+    BOOST_CHECK_EQUAL( os.str(), os_context.str() );
+
+    TextArchiveData i_data;
+    std::istringstream is( os_context.str() );
+    {
+      cereal::JSONInputArchive iar( is, context );
+      iar( i_data );
+    }
+
+    BOOST_CHECK_EQUAL( i_data, o_data );
+  }
+
+  // Once large enough, the context keeps its memory instead of growing further
+  auto const capacity = context.capacity();
+  BOOST_CHECK_GT( capacity, 1024u );
+
+  auto const o_data = make_json_archive_data( gen, 1000 );
+  std::ostringstream os;
+  {
+    cereal::JSONOutputArchive oar( os, context );
+    oar( o_data );
+  }
+  {
+    std::istringstream is( os.str() );
+    cereal::JSONInputArchive iar( is, context );
+  }
+
+  BOOST_CHECK_EQUAL( context.capacity(), capacity );
+
+  // A context cannot be shared by archives that are alive at the same time
+  {
+    std::ostringstream first, second;
+    cereal::JSONOutputArchive oar( first, context );
+    BOOST_CHECK_THROW( cereal::JSONOutputArchive( second, context ), cereal::Exception );
+  }
+
+  // ... but is available again once the archive using it is gone
+  {
+    std::ostringstream out;
+    cereal::JSONOutputArchive oar( out, context );
+    oar( o_data );
+  }
+}
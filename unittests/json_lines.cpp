@@ -0,0 +1,118 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <cereal/archives/json_lines.hpp>
+#include <boost/test/unit_test.hpp>
+
+struct JSONLinesRecord
+{
+  int id;
+  std::string text;
+  std::vector<double> values;
+  std::shared_ptr<StructInternalSerialize> shared;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( CEREAL_NVP(id), CEREAL_NVP(text), CEREAL_NVP(values), CEREAL_NVP(shared) );
+  }
+
+  bool operator==( JSONLinesRecord const & other ) const
+  {
+    return id == other.id && text == other.text && values == other.values &&
+           *shared == *other.shared;
+  }
+};
+
+std::ostream& operator<<(std::ostream& os, JSONLinesRecord const & r)
+{
+  return os << "[" << r.id << " " << r.text << " values(" << r.values.size() << ")]";
+}
+
+BOOST_AUTO_TEST_CASE( json_lines_archive )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  // the same pointer in every record, which must be written in full each time
+  auto shared = std::make_shared<StructInternalSerialize>( random_value<int>(gen), random_value<int>(gen) );
+
+  std::vector<JSONLinesRecord> o_records( 100 );
+  for( size_t i = 0; i < o_records.size(); ++i )
+  {
+    auto & record = o_records[i];
+    record.id = static_cast<int>( i );
+    record.text = "line\nbreak " + random_value<std::string>(gen);
+    record.values.resize( random_value<size_t>(gen) % 10 );
+    for( auto & v : record.values )
+      v = random_value<double>(gen);
+    record.shared = shared;
+  }
+
+  std::ostringstream os;
+  {
+    cereal::JSONLinesOutputArchive oar( os );
+    for( auto const & record : o_records )
+      oar( cereal::make_nvp( "record", record ), cereal::make_nvp( "tag", record.id * 2 ) );
+    oar(); // empty record
+  }
+
+  auto const output = os.str();
+  BOOST_CHECK_EQUAL( std::count( output.begin(), output.end(), '\n' ), o_records.size() + 1 );
+  BOOST_CHECK( output.size() >= 3 && output.compare( output.size() - 3, 3, "{}\n" ) == 0 );
+
+  // every line is a document of its own
+  std::istringstream lines( output );
+  std::string line;
+  for( auto const & o_record : o_records )
+  {
+    std::getline( lines, line );
+    BOOST_CHECK( line.find( '\n' ) == std::string::npos );
+
+    JSONLinesRecord i_record;
+    std::istringstream is( line );
+    cereal::JSONInputArchive iar( is );
+    iar( cereal::make_nvp( "record", i_record ) );
+    BOOST_CHECK_EQUAL( i_record, o_record );
+  }
+
+  // blank lines between records are skipped
+  std::istringstream is( "\n" + output + "\r\n  \n" );
+  cereal::JSONLinesInputArchive iar( is );
+  for( auto const & o_record : o_records )
+  {
+    JSONLinesRecord i_record;
+    int tag = 0;
+    BOOST_CHECK( iar( cereal::make_nvp( "tag", tag ), cereal::make_nvp( "record", i_record ) ) );
+    BOOST_CHECK_EQUAL( i_record, o_record );
+    BOOST_CHECK_EQUAL( tag, o_record.id * 2 );
+  }
+
+  BOOST_CHECK( iar() );
+  int unused = -1;
+  BOOST_CHECK( !iar( unused ) );
+  BOOST_CHECK_EQUAL( unused, -1 );
+}
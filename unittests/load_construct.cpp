@@ -193,3 +193,177 @@ BOOST_AUTO_TEST_CASE( json_memory_load_construct )
   test_memory_load_construct<cereal::JSONInputArchive, cereal::JSONOutputArchive>();
 }
 
+// Default constructible, but counts how often that happens
+struct FourLA
+{
+  FourLA() { ++defaultConstructions; }
+  FourLA( int xx ) : x( xx ) {}
+
+  int x = 0;
+  static int defaultConstructions;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( x ); }
+
+  template <class Archive>
+  static void load_and_construct( Archive & ar, cereal::construct<FourLA> & construct )
+  {
+    int xx;
+    ar( xx );
+    construct( xx );
+  }
+
+  bool operator==( FourLA const & other ) const
+  { return x == other.x; }
+};
+
+int FourLA::defaultConstructions = 0;
+
+std::ostream& operator<<(std::ostream& os, FourLA const & s)
+{
+  os << "[" << s.x << "]";
+  return os;
+}
+
+// Cannot be moved, so containers still default construct it and load it in place
+struct FiveLA
+{
+  FiveLA() = default;
+  FiveLA( int xx ) : x( xx ) {}
+  FiveLA( FiveLA const & ) = delete;
+  FiveLA & operator=( FiveLA const & ) = delete;
+
+  int x = 0;
+  bool constructed = false;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( x ); }
+
+  template <class Archive>
+  static void load_and_construct( Archive & ar, cereal::construct<FiveLA> & construct )
+  {
+    int xx;
+    ar( xx );
+    construct( xx );
+    construct->constructed = true;
+  }
+};
+
+template <class IArchive, class OArchive>
+void test_container_load_construct()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for(int ii=0; ii<100; ++ii)
+  {
+    std::vector<OneLA> o_vector;
+    std::deque<TwoLA> o_deque;
+    std::list<OneLA> o_list;
+    std::vector<FourLA> o_vector4;
+    for(int j=0; j<10; ++j)
+    {
+      o_vector.emplace_back( random_value<int>(gen) );
+      o_deque.emplace_back( random_value<int>(gen) );
+      o_list.emplace_back( random_value<int>(gen) );
+      o_vector4.emplace_back( random_value<int>(gen) );
+    }
+
+    std::ostringstream os;
+    {
+      OArchive oar(os);
+
+      oar( o_vector );
+      oar( o_deque );
+      oar( o_list );
+      oar( o_vector4 );
+    }
+
+    std::vector<OneLA> i_vector( 3, OneLA( 0 ) );
+    std::deque<TwoLA> i_deque;
+    std::list<OneLA> i_list;
+    std::vector<FourLA> i_vector4;
+
+    FourLA::defaultConstructions = 0;
+
+    std::istringstream is(os.str());
+    {
+      IArchive iar(is);
+
+      iar( i_vector );
+      iar( i_deque );
+      iar( i_list );
+      iar( i_vector4 );
+    }
+
+    BOOST_CHECK( i_vector == o_vector );
+    BOOST_CHECK( i_deque == o_deque );
+    BOOST_CHECK( i_list == o_list );
+    BOOST_CHECK( i_vector4 == o_vector4 );
+    BOOST_CHECK_EQUAL( FourLA::defaultConstructions, 0 );
+  }
+
+  std::deque<FiveLA> o_deque5;
+  std::list<FiveLA> o_list5;
+  for(int j=0; j<10; ++j)
+  {
+    o_deque5.emplace_back( random_value<int>(gen) );
+    o_list5.emplace_back( random_value<int>(gen) );
+  }
+
+  std::ostringstream os;
+  {
+    OArchive oar(os);
+
+    oar( o_deque5 );
+    oar( o_list5 );
+  }
+
+  std::deque<FiveLA> i_deque5;
+  std::list<FiveLA> i_list5;
+
+  std::istringstream is(os.str());
+  {
+    IArchive iar(is);
+
+    iar( i_deque5 );
+    iar( i_list5 );
+  }
+
+  BOOST_CHECK_EQUAL( i_deque5.size(), o_deque5.size() );
+  for( std::size_t i = 0; i < i_deque5.size(); ++i )
+  {
+    BOOST_CHECK_EQUAL( i_deque5[i].x, o_deque5[i].x );
+    BOOST_CHECK( !i_deque5[i].constructed );
+  }
+
+  BOOST_CHECK_EQUAL( i_list5.size(), o_list5.size() );
+  auto o_iter = o_list5.begin();
+  for( auto const & i : i_list5 )
+  {
+    BOOST_CHECK_EQUAL( i.x, (o_iter++)->x );
+    BOOST_CHECK( !i.constructed );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( binary_container_load_construct )
+{
+  test_container_load_construct<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_container_load_construct )
+{
+  test_container_load_construct<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( xml_container_load_construct )
+{
+  test_container_load_construct<cereal::XMLInputArchive, cereal::XMLOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( json_container_load_construct )
+{
+  test_container_load_construct<cereal::JSONInputArchive, cereal::JSONOutputArchive>();
+}
@@ -0,0 +1,189 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE( thread_pool_chunks )
+{
+  cereal::ThreadPool pool( 3 );
+  BOOST_CHECK_EQUAL( pool.size(), 3 );
+
+  for( size_t size : { 0, 1, 7, 64, 1000, 1023 } )
+  {
+    std::vector<std::atomic<int>> visits( size );
+    for( auto & v : visits )
+      v = 0;
+
+    cereal::parallel_detail::for_each_chunk( &pool, size, 16, [&]( size_t begin, size_t end )
+    {
+      BOOST_REQUIRE( begin < end && end <= size && end - begin <= 16 );
+      for( size_t i = begin; i < end; ++i )
+        ++visits[i];
+    } );
+
+    for( auto & v : visits )
+      BOOST_CHECK_EQUAL( v, 1 );
+  }
+
+  // Exceptions reach the caller once every chunk has finished
+  std::atomic<size_t> finished( 0 );
+  BOOST_CHECK_THROW( cereal::parallel_detail::for_each_chunk( &pool, 100, 1, [&]( size_t begin, size_t )
+  {
+    ++finished;
+    if( begin == 42 )
+      throw cereal::Exception( "chunk failed" );
+  } ), cereal::Exception );
+  BOOST_CHECK_EQUAL( finished, 100 );
+
+  // Nested use from tasks already running on the pool completes
+  std::atomic<size_t> inner( 0 );
+  cereal::parallel_detail::for_each_chunk( &pool, 8, 1, [&]( size_t, size_t )
+  {
+    cereal::parallel_detail::for_each_chunk( &pool, 8, 1, [&]( size_t, size_t ){ ++inner; } );
+  } );
+  BOOST_CHECK_EQUAL( inner, 64 );
+}
+
+BOOST_AUTO_TEST_CASE( transform_chunks_in_order )
+{
+  std::mt19937 gen(std::random_device{}());
+  std::string const input = random_basic_string<char>(gen) + std::string( 10000, 'x' ) + random_basic_string<char>(gen);
+
+  auto const transform = [&]( size_t begin, size_t end, std::string & out )
+  {
+    out.assign( input.begin() + begin, input.begin() + end );
+    std::reverse( out.begin(), out.end() );
+  };
+
+  std::string sequential;
+  cereal::transform_chunks( nullptr, input.size(), 333, transform, [&]( std::string const & out ){ sequential += out; } );
+
+  cereal::ThreadPool pool( 2 );
+  std::string parallel;
+  size_t emitted = 0;
+  cereal::transform_chunks( &pool, input.size(), 333, transform, [&]( std::string const & out ){ parallel += out; ++emitted; } );
+
+  BOOST_CHECK_EQUAL( parallel, sequential );
+  BOOST_CHECK_EQUAL( emitted, ( input.size() + 332 ) / 333 );
+  BOOST_CHECK_EQUAL( parallel.size(), input.size() );
+}
+
+template <class IArchive, class OArchive, class Options>
+void test_parallel_base64( Options const & options )
+{
+  std::mt19937 gen(std::random_device{}());
+  cereal::ThreadPool pool( 3 );
+
+  for( size_t size : { 0, 1, 5, 100, 1001, 4096 } )
+  {
+    std::vector<double> o_values( size );
+    for( auto & v : o_values )
+      v = random_value<double>(gen);
+
+    std::vector<unsigned char> o_bytes( size + 2 );
+    for( auto & b : o_bytes )
+      b = random_value<unsigned char>(gen);
+
+    std::ostringstream sequential;
+    {
+      OArchive oar( sequential, options );
+      oar( o_values );
+      oar.saveBinaryValue( o_bytes.data(), o_bytes.size(), "bytes" );
+    }
+
+    std::ostringstream parallel;
+    {
+      OArchive oar( parallel, options );
+      oar.setThreadPool( &pool, 100 );
+      oar( o_values );
+      oar.saveBinaryValue( o_bytes.data(), o_bytes.size(), "bytes" );
+    }
+
+    BOOST_CHECK_EQUAL( parallel.str(), sequential.str() );
+
+    std::vector<double> i_values;
+    std::vector<unsigned char> i_bytes( o_bytes.size() );
+    {
+      std::istringstream is( parallel.str() );
+      IArchive iar( is );
+      iar.setThreadPool( &pool, 100 );
+      iar( i_values );
+      iar.loadBinaryValue( i_bytes.data(), i_bytes.size(), "bytes" );
+    }
+
+    BOOST_CHECK( i_values == o_values );
+    BOOST_CHECK( i_bytes == o_bytes );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( json_parallel_base64 )
+{
+  test_parallel_base64<cereal::JSONInputArchive, cereal::JSONOutputArchive>(
+    cereal::JSONOutputArchive::Options( 17, cereal::JSONOutputArchive::Options::IndentChar::space, 4, true ) );
+}
+
+BOOST_AUTO_TEST_CASE( xml_parallel_base64 )
+{
+  test_parallel_base64<cereal::XMLInputArchive, cereal::XMLOutputArchive>(
+    cereal::XMLOutputArchive::Options( 17, true, false, false, true ) );
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_parallel_swap )
+{
+  std::mt19937 gen(std::random_device{}());
+  std::vector<uint32_t> o_values( 1000 );
+  for( auto & v : o_values )
+    v = random_value<uint32_t>(gen);
+
+  // Write the values as a machine of the opposite endianness would
+  std::string foreign;
+  {
+    std::ostringstream os;
+    {
+      cereal::PortableBinaryOutputArchive oar( os );
+      oar( o_values );
+    }
+    foreign = os.str();
+  }
+
+  foreign[0] = !foreign[0];
+  std::reverse( foreign.begin() + 1, foreign.begin() + 1 + sizeof(cereal::size_type) );
+  for( size_t i = 1 + sizeof(cereal::size_type); i < foreign.size(); i += sizeof(uint32_t) )
+    std::reverse( foreign.begin() + i, foreign.begin() + i + sizeof(uint32_t) );
+
+  cereal::ThreadPool pool( 2 );
+  for( auto * p : { static_cast<cereal::ThreadPool *>( nullptr ), &pool } )
+  {
+    std::istringstream is( foreign );
+    cereal::PortableBinaryInputArchive iar( is );
+    iar.setThreadPool( p, 64 );
+
+    std::vector<uint32_t> i_values;
+    iar( i_values );
+    BOOST_CHECK( i_values == o_values );
+  }
+}
@@ -0,0 +1,304 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <cereal/types/parallel.hpp>
+#include <cereal/archives/sizing.hpp>
+#include <boost/test/unit_test.hpp>
+
+struct ParallelShape
+{
+  virtual ~ParallelShape() {}
+  virtual double area() const = 0;
+};
+
+struct ParallelSquare : ParallelShape
+{
+  double side;
+
+  double area() const { return side * side; }
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( side ); }
+};
+
+CEREAL_REGISTER_TYPE(ParallelSquare)
+
+struct ParallelRecord
+{
+  std::string name;
+  std::vector<int32_t> values;
+  std::map<std::string, double> attributes;
+  std::shared_ptr<ParallelShape> shape;
+  std::shared_ptr<ParallelShape> sameShape;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( name, values, attributes, shape, sameShape ); }
+
+  bool operator==( ParallelRecord const & other ) const
+  {
+    return name == other.name && values == other.values && attributes == other.attributes &&
+           ( shape ? other.shape && shape->area() == other.shape->area() : !other.shape ) &&
+           sameShape == shape && other.sameShape == other.shape;
+  }
+};
+
+CEREAL_CLASS_VERSION(ParallelRecord, 2)
+
+std::vector<ParallelRecord> make_parallel_records( std::mt19937 & gen, size_t count )
+{
+  std::vector<ParallelRecord> records( count );
+  for( auto & r : records )
+  {
+    r.name = random_basic_string<char>(gen);
+    r.values.resize( gen() % 20 );
+    for( auto & v : r.values )
+      v = random_value<int32_t>(gen);
+    r.attributes[random_basic_string<char>(gen)] = random_value<double>(gen);
+
+    if( gen() % 4 )
+    {
+      auto square = std::make_shared<ParallelSquare>();
+      square->side = random_value<double>(gen);
+      r.shape = r.sameShape = square;
+    }
+  }
+  return records;
+}
+
+template <class IArchive, class OArchive>
+void test_parallel_container()
+{
+  std::mt19937 gen(std::random_device{}());
+  cereal::ThreadPool pool( 3 );
+
+  for( size_t count : { 0, 1, 10, 1000 } )
+  {
+    auto const o_records = make_parallel_records( gen, count );
+    int32_t const o_after = random_value<int32_t>(gen);
+
+    std::ostringstream sequential;
+    {
+      OArchive oar( sequential );
+      oar( cereal::make_parallel( nullptr, o_records, 16 ), o_after );
+    }
+
+    std::ostringstream parallel;
+    {
+      OArchive oar( parallel );
+      oar( cereal::make_parallel( &pool, o_records, 16 ), o_after );
+    }
+
+    // The layout only depends on the range size
+    BOOST_CHECK( parallel.str() == sequential.str() );
+
+    for( auto * p : { static_cast<cereal::ThreadPool *>( nullptr ), &pool } )
+    {
+      std::vector<ParallelRecord> i_records( 3 );
+      int32_t i_after = 0;
+      {
+        std::istringstream is( parallel.str() );
+        IArchive iar( is );
+        iar( cereal::make_parallel( p, i_records ), i_after );
+      }
+
+      BOOST_CHECK( i_records == o_records );
+      BOOST_CHECK_EQUAL( i_after, o_after );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( binary_parallel_container )
+{
+  test_parallel_container<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_parallel_container )
+{
+  test_parallel_container<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( json_parallel_container )
+{
+  test_parallel_container<cereal::JSONInputArchive, cereal::JSONOutputArchive>();
+}
+
+template <class IArchive, class OArchive>
+void test_parallel_container_options( cereal::SizingOutputArchive::Format format )
+{
+  std::mt19937 gen(std::random_device{}());
+  cereal::ThreadPool pool( 3 );
+
+  auto o_records = make_parallel_records( gen, 200 );
+  for( auto & r : o_records )
+    r.name = "a name that is repeated in every record";
+
+  for( bool framed : { false, true } )
+    for( std::size_t intern : { std::size_t( 0 ), std::size_t( 64 ) } )
+    {
+      std::ostringstream os;
+      {
+        OArchive oar( os, typename OArchive::Options( framed, intern ) );
+        oar( cereal::make_parallel( &pool, o_records, 16 ) );
+      }
+
+      cereal::SizingOutputArchive sizer( format, framed, intern );
+      sizer( cereal::make_parallel( &pool, o_records, 16 ) );
+      BOOST_CHECK_EQUAL( sizer.size(), os.str().size() );
+
+      // Ranges are saved with the options of the archive.  Each framed record
+      // interns its strings separately, so only unframed records share them
+      std::ostringstream plain;
+      {
+        OArchive oar( plain, typename OArchive::Options( framed ) );
+        oar( cereal::make_parallel( &pool, o_records, 16 ) );
+      }
+      if( intern && !framed )
+        BOOST_CHECK_LT( os.str().size(), plain.str().size() );
+
+      std::vector<ParallelRecord> i_records;
+      {
+        std::istringstream is( os.str() );
+        IArchive iar( is );
+        iar( cereal::make_parallel( &pool, i_records ) );
+      }
+      BOOST_CHECK( i_records == o_records );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( binary_parallel_container_options )
+{
+  test_parallel_container_options<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>(
+    cereal::SizingOutputArchive::Format::Binary );
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_parallel_container_options )
+{
+  test_parallel_container_options<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>(
+    cereal::SizingOutputArchive::Format::PortableBinary );
+}
+
+//! A versioned type without CEREAL_CLASS_VERSION, whose version is looked up on first use
+struct ParallelUnregistered
+{
+  int32_t value;
+  std::string name;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( value, name ); }
+
+  bool operator==( ParallelUnregistered const & other ) const
+  { return value == other.value && name == other.name; }
+};
+
+BOOST_AUTO_TEST_CASE( parallel_container_unregistered_version )
+{
+  std::mt19937 gen(std::random_device{}());
+  cereal::ThreadPool pool( 4 );
+
+  // every range looks the version up at the same time
+  std::vector<ParallelUnregistered> o_values( 20000 );
+  for( auto & v : o_values )
+  {
+    v.value = random_value<int32_t>(gen);
+    v.name = random_basic_string<char>(gen);
+  }
+
+  std::ostringstream os;
+  {
+    cereal::BinaryOutputArchive oar( os );
+    oar( cereal::make_parallel( &pool, o_values, 10 ) );
+  }
+
+  std::vector<ParallelUnregistered> i_values;
+  {
+    std::istringstream is( os.str() );
+    cereal::BinaryInputArchive iar( is );
+    iar( cereal::make_parallel( &pool, i_values ) );
+  }
+
+  BOOST_CHECK( i_values == o_values );
+}
+
+BOOST_AUTO_TEST_CASE( parallel_container_shared_pointers )
+{
+  std::mt19937 gen(std::random_device{}());
+  cereal::ThreadPool pool( 2 );
+
+  auto records = make_parallel_records( gen, 100 );
+  auto shared = std::make_shared<ParallelSquare>();
+  shared->side = 2;
+
+  // Shared between ranges
+  records.front().shape = records.front().sameShape = shared;
+  records.back().shape = records.back().sameShape = shared;
+  {
+    std::ostringstream os;
+    cereal::BinaryOutputArchive oar( os );
+    BOOST_CHECK_THROW( oar( cereal::make_parallel( &pool, records, 10 ) ), cereal::Exception );
+  }
+
+  // Shared within a single range
+  records.back().shape = records.back().sameShape = nullptr;
+  records[1].shape = records[1].sameShape = shared;
+  {
+    std::ostringstream os;
+    cereal::BinaryOutputArchive oar( os );
+    BOOST_CHECK_NO_THROW( oar( cereal::make_parallel( &pool, records, 10 ) ) );
+  }
+
+  // Shared with something saved earlier
+  {
+    std::ostringstream os;
+    cereal::BinaryOutputArchive oar( os );
+    oar( std::shared_ptr<ParallelShape>( shared ) );
+    BOOST_CHECK_THROW( oar( cereal::make_parallel( &pool, records, 10 ) ), cereal::Exception );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( parallel_container_corrupt )
+{
+  std::mt19937 gen(std::random_device{}());
+  cereal::ThreadPool pool( 2 );
+  auto const o_records = make_parallel_records( gen, 50 );
+
+  std::ostringstream os;
+  {
+    cereal::BinaryOutputArchive oar( os );
+    oar( cereal::make_parallel( &pool, o_records, 7 ) );
+  }
+
+  auto truncated = os.str();
+  truncated.resize( truncated.size() - 5 );
+
+  std::istringstream is( truncated );
+  cereal::BinaryInputArchive iar( is );
+  std::vector<ParallelRecord> i_records;
+  BOOST_CHECK_THROW( iar( cereal::make_parallel( &pool, i_records ) ), cereal::Exception );
+}
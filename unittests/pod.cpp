@@ -162,3 +162,147 @@ BOOST_AUTO_TEST_CASE( json_pod )
 {
   test_pod<cereal::JSONInputArchive, cereal::JSONOutputArchive>();
 }
+
+template <class T>
+T random_finite_bits(std::mt19937_64 & gen)
+{
+  T value;
+  do
+  {
+    auto bits = gen();
+    std::memcpy( &value, &bits, sizeof(value) );
+  } while( !std::isfinite( value ) );
+
+  return value;
+}
+
+template <class IArchive, class OArchive>
+void test_floating_point_round_trip()
+{
+  std::mt19937_64 gen(std::random_device{}());
+
+  std::vector<double> o_doubles = {0.1, 1.0/3.0, -0.0, 1e21, 1e-7, 5e-324, 2.2250738585072014e-308,
+                                   std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
+  std::vector<float> o_floats = {0.1f, 1.0f/3.0f, -0.0f, 1e-45f, std::numeric_limits<float>::max()};
+
+  for(size_t i=0; i<1000; ++i)
+  {
+    o_doubles.push_back( random_finite_bits<double>(gen) );
+    o_floats.push_back( random_finite_bits<float>(gen) );
+  }
+
+  std::ostringstream os;
+  {
+    OArchive oar(os);
+    for( auto const & d : o_doubles ) oar( d );
+    for( auto const & f : o_floats ) oar( f );
+  }
+
+  std::istringstream is(os.str());
+  {
+    IArchive iar(is);
+    for( auto const & o_double : o_doubles )
+    {
+      double i_double;
+      iar( i_double );
+      BOOST_CHECK_EQUAL( std::memcmp( &i_double, &o_double, sizeof(double) ), 0 );
+    }
+
+    for( auto const & o_float : o_floats )
+    {
+      float i_float;
+      iar( i_float );
+      BOOST_CHECK_EQUAL( std::memcmp( &i_float, &o_float, sizeof(float) ), 0 );
+    }
+  }
+}
+
+template <class OArchive>
+std::string shortest_float_output()
+{
+  std::ostringstream os;
+  {
+    OArchive oar(os);
+    oar( 0.1, 0.1f );
+  }
+  return os.str();
+}
+
+BOOST_AUTO_TEST_CASE( xml_floating_point_round_trip )
+{
+  test_floating_point_round_trip<cereal::XMLInputArchive, cereal::XMLOutputArchive>();
+
+  auto const output = shortest_float_output<cereal::XMLOutputArchive>();
+  BOOST_CHECK( output.find("<value0>0.1</value0>") != std::string::npos );
+  BOOST_CHECK( output.find("<value1>0.1</value1>") != std::string::npos );
+}
+
+BOOST_AUTO_TEST_CASE( json_floating_point_round_trip )
+{
+  test_floating_point_round_trip<cereal::JSONInputArchive, cereal::JSONOutputArchive>();
+
+  auto const output = shortest_float_output<cereal::JSONOutputArchive>();
+  BOOST_CHECK( output.find("\"value0\": 0.1,\n") != std::string::npos );
+  BOOST_CHECK( output.find("\"value1\": 0.1\n") != std::string::npos );
+}
+
+BOOST_AUTO_TEST_CASE( xml_pod_parsing )
+{
+  std::istringstream is(
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+    "<cereal>\n"
+    "  <value0>-128</value0>\n"
+    "  <value1>65535</value1>\n"
+    "  <value2>-9223372036854775808</value2>\n"
+    "  <value3>18446744073709551615</value3>\n"
+    "  <value4>1</value4>\n"
+    "  <value5>false</value5>\n"
+    "  <value6>-1.25e-3</value6>\n"
+    "  <value7>3.4028235e38</value7>\n"
+    "  <value8>-inf</value8>\n"
+    "  <value9>nan</value9>\n"
+    "  <value10>4.9406564584124654e-324</value10>\n"
+    "  <value11> padded string </value11>\n"
+    "</cereal>\n" );
+
+  int8_t i_int8; uint16_t i_uint16; int64_t i_int64; uint64_t i_uint64;
+  bool i_true, i_false;
+  double i_double, i_inf, i_nan, i_denorm;
+  float i_float;
+  std::string i_string;
+
+  {
+    cereal::XMLInputArchive iar(is);
+    iar( i_int8, i_uint16, i_int64, i_uint64, i_true, i_false,
+         i_double, i_float, i_inf, i_nan, i_denorm, i_string );
+  }
+
+  BOOST_CHECK_EQUAL( i_int8, std::numeric_limits<int8_t>::min() );
+  BOOST_CHECK_EQUAL( i_uint16, std::numeric_limits<uint16_t>::max() );
+  BOOST_CHECK_EQUAL( i_int64, std::numeric_limits<int64_t>::min() );
+  BOOST_CHECK_EQUAL( i_uint64, std::numeric_limits<uint64_t>::max() );
+  BOOST_CHECK_EQUAL( i_true, true );
+  BOOST_CHECK_EQUAL( i_false, false );
+  BOOST_CHECK_EQUAL( i_double, -1.25e-3 );
+  BOOST_CHECK_EQUAL( i_float, std::numeric_limits<float>::max() );
+  BOOST_CHECK_EQUAL( i_inf, -std::numeric_limits<double>::infinity() );
+  BOOST_CHECK( std::isnan( i_nan ) );
+  BOOST_CHECK_EQUAL( i_denorm, std::numeric_limits<double>::denorm_min() );
+  BOOST_CHECK_EQUAL( i_string, "padded string" );
+
+  auto load_from = []( std::string const & intValue, std::string const & floatValue )
+  {
+    std::istringstream bad( "<?xml version=\"1.0\" encoding=\"utf-8\"?><cereal><value0>" + intValue +
+                            "</value0><value1>" + floatValue + "</value1></cereal>" );
+    cereal::XMLInputArchive iar(bad);
+    int16_t i; float f;
+    iar( i, f );
+  };
+
+  BOOST_CHECK_NO_THROW( load_from( "-32768", "1e-7" ) );
+  BOOST_CHECK_THROW( load_from( "32768", "0" ), cereal::Exception );
+  BOOST_CHECK_THROW( load_from( "12abc", "0" ), cereal::Exception );
+  BOOST_CHECK_THROW( load_from( "", "0" ), cereal::Exception );
+  BOOST_CHECK_THROW( load_from( "0", "1e39" ), cereal::Exception );
+  BOOST_CHECK_THROW( load_from( "0", "1.5.2" ), cereal::Exception );
+}
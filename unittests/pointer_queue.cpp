@@ -0,0 +1,364 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <boost/test/unit_test.hpp>
+
+struct PointerQueueNode
+{
+  int32_t value = 0;
+  std::shared_ptr<PointerQueueNode> next;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( value, next ); }
+};
+
+//! A node that can only be loaded through load_and_construct
+struct PointerQueueConstructedNode
+{
+  PointerQueueConstructedNode( int32_t v ) : value( v ) {}
+
+  int32_t value;
+  std::shared_ptr<PointerQueueConstructedNode> next;
+  std::weak_ptr<PointerQueueConstructedNode> previous;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( value, next, previous ); }
+
+  template <class Archive>
+  static void load_and_construct( Archive & ar, cereal::construct<PointerQueueConstructedNode> & construct )
+  {
+    int32_t value;
+    ar( value );
+    construct( value );
+    ar( construct->next, construct->previous );
+  }
+};
+
+//! A node of a graph with shared children and back references
+struct PointerQueueGraphNode
+{
+  int32_t value = 0;
+  std::vector<std::shared_ptr<PointerQueueGraphNode>> children;
+  std::weak_ptr<PointerQueueGraphNode> parent;
+  std::unique_ptr<int32_t> owned;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( value, children, parent, owned ); }
+};
+
+//! Releases a chain one node at a time, since destroying its head would recurse through all of it
+template <class T>
+void pointer_queue_release( std::shared_ptr<T> & head )
+{
+  while( head )
+    head = std::move( head->next );
+}
+
+template <class IArchive, class OArchive>
+void test_pointer_queue_chain()
+{
+  std::size_t const length = 300000;
+
+  auto head = std::make_shared<PointerQueueNode>();
+  auto tail = head;
+  for( std::size_t i = 1; i < length; ++i )
+  {
+    tail->next = std::make_shared<PointerQueueNode>();
+    tail = tail->next;
+    tail->value = static_cast<int32_t>( i );
+  }
+
+  std::ostringstream os;
+  {
+    OArchive oar( os, typename OArchive::Options( false, 0, true ) );
+    oar( head, tail );
+  }
+
+  std::shared_ptr<PointerQueueNode> loadedHead, loadedTail;
+  {
+    std::istringstream is( os.str() );
+    IArchive iar( is );
+    iar( loadedHead, loadedTail );
+  }
+
+  std::size_t count = 0;
+  bool matches = true;
+  std::shared_ptr<PointerQueueNode> last;
+  for( auto node = loadedHead; node; node = node->next )
+  {
+    matches = matches && node->value == static_cast<int32_t>( count );
+    last = node;
+    ++count;
+  }
+
+  BOOST_CHECK_EQUAL( count, length );
+  BOOST_CHECK( matches );
+  BOOST_CHECK( last == loadedTail );
+
+  last.reset();
+  tail.reset();
+  loadedTail.reset();
+  pointer_queue_release( head );
+  pointer_queue_release( loadedHead );
+}
+
+BOOST_AUTO_TEST_CASE( binary_pointer_queue_chain )
+{
+  test_pointer_queue_chain<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_pointer_queue_chain )
+{
+  test_pointer_queue_chain<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
+
+template <class IArchive, class OArchive>
+void test_pointer_queue_constructed( bool queue )
+{
+  std::vector<std::shared_ptr<PointerQueueConstructedNode>> nodes;
+  for( int32_t i = 0; i < 100; ++i )
+  {
+    nodes.push_back( std::make_shared<PointerQueueConstructedNode>( i ) );
+    if( i )
+    {
+      nodes[i - 1]->next = nodes[i];
+      nodes[i]->previous = nodes[i - 1];
+    }
+  }
+
+  std::ostringstream os;
+  {
+    OArchive oar( os, typename OArchive::Options( false, 0, queue ) );
+    oar( nodes.front(), nodes[50] );
+  }
+
+  std::shared_ptr<PointerQueueConstructedNode> head, middle;
+  {
+    std::istringstream is( os.str() );
+    IArchive iar( is );
+    iar( head, middle );
+  }
+
+  int32_t expected = 0;
+  std::shared_ptr<PointerQueueConstructedNode> previous;
+  for( auto node = head; node; node = node->next, ++expected )
+  {
+    BOOST_CHECK_EQUAL( node->value, expected );
+    BOOST_CHECK( node->previous.lock() == previous );
+    if( expected == 50 )
+      BOOST_CHECK( node == middle );
+    previous = node;
+  }
+  BOOST_CHECK_EQUAL( expected, 100 );
+}
+
+BOOST_AUTO_TEST_CASE( binary_pointer_queue_constructed )
+{
+  test_pointer_queue_constructed<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>( false );
+  test_pointer_queue_constructed<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>( true );
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_pointer_queue_constructed )
+{
+  test_pointer_queue_constructed<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>( false );
+  test_pointer_queue_constructed<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>( true );
+}
+
+//! Checks that two graphs, listing all of their nodes in the same order, have the same values and sharing
+void pointer_queue_check_graph( std::vector<std::shared_ptr<PointerQueueGraphNode>> const & a,
+                                std::vector<std::shared_ptr<PointerQueueGraphNode>> const & b )
+{
+  BOOST_REQUIRE_EQUAL( a.size(), b.size() );
+
+  std::map<PointerQueueGraphNode const *, std::size_t> indexA, indexB;
+  for( std::size_t i = 0; i < a.size(); ++i )
+  {
+    indexA[a[i].get()] = i;
+    indexB[b[i].get()] = i;
+  }
+  BOOST_REQUIRE_EQUAL( indexB.size(), b.size() );
+
+  for( std::size_t i = 0; i < a.size(); ++i )
+  {
+    BOOST_CHECK_EQUAL( a[i]->value, b[i]->value );
+    BOOST_REQUIRE_EQUAL( static_cast<bool>( a[i]->owned ), static_cast<bool>( b[i]->owned ) );
+    if( a[i]->owned )
+      BOOST_CHECK_EQUAL( *a[i]->owned, *b[i]->owned );
+
+    auto const parentA = a[i]->parent.lock();
+    auto const parentB = b[i]->parent.lock();
+    BOOST_REQUIRE_EQUAL( static_cast<bool>( parentA ), static_cast<bool>( parentB ) );
+    if( parentA )
+      BOOST_CHECK_EQUAL( indexA[parentA.get()], indexB[parentB.get()] );
+
+    BOOST_REQUIRE_EQUAL( a[i]->children.size(), b[i]->children.size() );
+    for( std::size_t c = 0; c < a[i]->children.size(); ++c )
+      BOOST_CHECK_EQUAL( indexA[a[i]->children[c].get()], indexB[b[i]->children[c].get()] );
+  }
+}
+
+template <class IArchive, class OArchive>
+void test_pointer_queue_graph()
+{
+  std::random_device rd;
+  std::mt19937 gen( rd() );
+
+  std::vector<std::shared_ptr<PointerQueueGraphNode>> nodes( 200 );
+  for( auto & n : nodes )
+  {
+    n = std::make_shared<PointerQueueGraphNode>();
+    n->value = random_value<int32_t>( gen );
+    if( gen() % 2 )
+      n->owned.reset( new int32_t( random_value<int32_t>( gen ) ) );
+  }
+  for( std::size_t i = 1; i < nodes.size(); ++i )
+  {
+    auto & parent = nodes[gen() % i];
+    parent->children.push_back( nodes[i] );
+    nodes[i]->parent = parent;
+    parent->children.push_back( nodes[gen() % nodes.size()] ); // shared, possibly cyclic
+  }
+
+  for( int queue = 0; queue < 2; ++queue )
+  {
+    std::ostringstream os;
+    {
+      OArchive oar( os, typename OArchive::Options( false, 0, queue != 0 ) );
+      oar( nodes );
+    }
+
+    std::vector<std::shared_ptr<PointerQueueGraphNode>> loaded;
+    {
+      std::istringstream is( os.str() );
+      IArchive iar( is );
+      iar( loaded );
+    }
+
+    pointer_queue_check_graph( nodes, loaded );
+
+    for( auto & n : loaded )
+      n->children.clear();
+  }
+
+  for( auto & n : nodes )
+    n->children.clear();
+}
+
+BOOST_AUTO_TEST_CASE( binary_pointer_queue_graph )
+{
+  test_pointer_queue_graph<cereal::BinaryInputArchive, cereal::BinaryOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( portable_binary_pointer_queue_graph )
+{
+  test_pointer_queue_graph<cereal::PortableBinaryInputArchive, cereal::PortableBinaryOutputArchive>();
+}
+
+//! A versioned holder of a pointer, saved within a frame
+struct PointerQueueFramedHolder
+{
+  std::shared_ptr<int32_t> value;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( value ); }
+};
+
+//! The same holder as known to an older reader, which skips newer versions entirely
+struct PointerQueueFramedStrict
+{
+  std::shared_ptr<int32_t> value;
+
+  template <class Archive>
+  void load( Archive & ar, std::uint32_t const version )
+  {
+    if( version > 1 )
+      return;
+    ar( value );
+  }
+
+  template <class Archive>
+  void save( Archive & ar, std::uint32_t const ) const
+  { ar( value ); }
+};
+
+CEREAL_CLASS_VERSION( PointerQueueFramedHolder, 2 );
+CEREAL_CLASS_VERSION( PointerQueueFramedStrict, 1 );
+
+template <class Holder>
+struct PointerQueueFramedWrapper
+{
+  Holder holder;
+  int32_t after = 0;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( holder, after ); }
+};
+
+// A frame saved while the queue is being worked through keeps its targets within it
+BOOST_AUTO_TEST_CASE( binary_pointer_queue_framed )
+{
+  auto wrapper = std::make_shared<PointerQueueFramedWrapper<PointerQueueFramedHolder>>();
+  wrapper->holder.value = std::make_shared<int32_t>( 3 );
+  wrapper->after = 4;
+
+  std::ostringstream os;
+  {
+    cereal::BinaryOutputArchive oar( os, cereal::BinaryOutputArchive::Options( true, 0, true ) );
+    oar( wrapper, int32_t( 5 ) );
+  }
+
+  {
+    std::shared_ptr<PointerQueueFramedWrapper<PointerQueueFramedHolder>> loaded;
+    int32_t trailer = 0;
+    std::istringstream is( os.str() );
+    cereal::BinaryInputArchive iar( is );
+    iar( loaded, trailer );
+
+    BOOST_REQUIRE( loaded && loaded->holder.value );
+    BOOST_CHECK_EQUAL( *loaded->holder.value, 3 );
+    BOOST_CHECK_EQUAL( loaded->after, 4 );
+    BOOST_CHECK_EQUAL( trailer, 5 );
+  }
+
+  {
+    std::shared_ptr<PointerQueueFramedWrapper<PointerQueueFramedStrict>> loaded;
+    int32_t trailer = 0;
+    std::istringstream is( os.str() );
+    cereal::BinaryInputArchive iar( is );
+    iar( loaded, trailer );
+
+    BOOST_REQUIRE( loaded );
+    BOOST_CHECK( !loaded->holder.value );
+    BOOST_CHECK_EQUAL( loaded->after, 4 );
+    BOOST_CHECK_EQUAL( trailer, 5 );
+  }
+}
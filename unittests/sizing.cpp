@@ -0,0 +1,166 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <cereal/archives/sizing.hpp>
+#include <boost/test/unit_test.hpp>
+
+struct SizingBase
+{
+  virtual ~SizingBase() {}
+  int32_t x;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( x ); }
+};
+
+struct SizingDerived : SizingBase
+{
+  std::string name;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( cereal::base_class<SizingBase>( this ), name ); }
+};
+
+CEREAL_REGISTER_TYPE(SizingDerived)
+
+struct SizingVersioned
+{
+  std::vector<std::pair<int16_t, double>> values;
+  std::map<std::string, std::vector<int32_t>> index;
+
+  template <class Archive>
+  void serialize( Archive & ar, std::uint32_t const )
+  { ar( values, index ); }
+};
+
+CEREAL_CLASS_VERSION(SizingVersioned, 3)
+
+struct SizingMessage
+{
+  std::string subject;
+  SizingVersioned body;
+  SizingVersioned trailer;
+  std::shared_ptr<SizingBase> first;
+  std::shared_ptr<SizingBase> second;
+  std::array<std::complex<float>, 4> samples;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  { ar( subject, body, trailer, first, second, samples ); }
+};
+
+SizingMessage make_sizing_message( std::mt19937 & gen )
+{
+  SizingMessage m;
+  m.subject = random_basic_string<char>(gen);
+
+  for( auto * v : { &m.body, &m.trailer } )
+  {
+    for( size_t i = 0; i < 50; ++i )
+      v->values.emplace_back( random_value<int16_t>(gen), random_value<double>(gen) );
+    for( size_t i = 0; i < 10; ++i )
+      v->index[random_basic_string<char>(gen)].resize( i );
+  }
+
+  auto derived = std::make_shared<SizingDerived>();
+  derived->x = random_value<int32_t>(gen);
+  derived->name = random_basic_string<char>(gen);
+  m.first = derived;
+  m.second = derived;
+
+  for( auto & s : m.samples )
+    s = { random_value<float>(gen), random_value<float>(gen) };
+
+  return m;
+}
+
+template <class OArchive>
+size_t written_size( SizingMessage const & m )
+{
+  std::ostringstream os;
+  {
+    OArchive oar( os );
+    oar( m, m.body );
+  }
+  return os.str().size();
+}
+
+BOOST_AUTO_TEST_CASE( sizing_matches_binary )
+{
+  std::mt19937 gen(std::random_device{}());
+
+  for( int i = 0; i < 20; ++i )
+  {
+    auto const m = make_sizing_message( gen );
+
+    cereal::SizingOutputArchive sizer;
+    sizer( m, m.body );
+    BOOST_CHECK_EQUAL( sizer.size(), written_size<cereal::BinaryOutputArchive>( m ) );
+
+    cereal::SizingOutputArchive portableSizer( cereal::SizingOutputArchive::Format::PortableBinary );
+    portableSizer( m, m.body );
+    BOOST_CHECK_EQUAL( portableSizer.size(), written_size<cereal::PortableBinaryOutputArchive>( m ) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( sizing_fixed_size_types )
+{
+  static_assert( cereal::fixed_binary_size<int32_t>::value == 4, "" );
+  static_assert( cereal::fixed_binary_size<std::pair<int16_t, double>>::value == 10, "" );
+  static_assert( cereal::fixed_binary_size<std::tuple<char, std::array<uint32_t, 3>, std::complex<double>>>::value == 29, "" );
+  static_assert( !cereal::sizing_detail::has_fixed_binary_size<std::string>::value, "" );
+  static_assert( !cereal::sizing_detail::has_fixed_binary_size<std::pair<int, std::vector<int>>>::value, "" );
+  static_assert( !cereal::sizing_detail::has_fixed_binary_size<SizingVersioned>::value, "" );
+
+  std::mt19937 gen(std::random_device{}());
+  auto const a = random_value<int64_t>(gen);
+  std::pair<int16_t, double> const b( random_value<int16_t>(gen), random_value<double>(gen) );
+  std::array<std::complex<float>, 7> const c{};
+
+  std::ostringstream os;
+  {
+    cereal::BinaryOutputArchive oar( os );
+    oar( a, b, c );
+  }
+  BOOST_CHECK_EQUAL( cereal::serialized_size( a, b, c ), os.str().size() );
+
+  cereal::SizingOutputArchive sizer;
+  sizer( a, b, c );
+  BOOST_CHECK_EQUAL( sizer.size(), os.str().size() );
+
+  // Mixing in a value without a fixed size falls back to serializing everything
+  std::vector<std::string> const d( 3, random_basic_string<char>(gen) );
+  std::ostringstream os2;
+  {
+    cereal::BinaryOutputArchive oar( os2 );
+    oar( a, d, b );
+  }
+  BOOST_CHECK_EQUAL( cereal::serialized_size( a, d, b ), os2.str().size() );
+  BOOST_CHECK_EQUAL( cereal::serialized_size(), 0 );
+}
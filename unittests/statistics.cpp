@@ -0,0 +1,221 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#define CEREAL_ENABLE_STATISTICS
+#include "common.hpp"
+#include <boost/test/unit_test.hpp>
+
+struct StatisticsInner
+{
+  int32_t x;
+  double y;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( CEREAL_NVP(x), CEREAL_NVP(y) );
+  }
+};
+
+struct StatisticsOuter
+{
+  std::vector<StatisticsInner> inners;
+  std::string name;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( CEREAL_NVP(inners), CEREAL_NVP(name) );
+  }
+};
+
+cereal::Statistics::Entry find_entry( cereal::Statistics const & statistics, std::string const & name )
+{
+  for( auto const & e : statistics.entries() )
+    if( e.name == name )
+      return e;
+
+  BOOST_FAIL( "No statistics for " + name );
+  return {};
+}
+
+StatisticsOuter make_statistics_outer( std::mt19937 & gen, size_t size )
+{
+  StatisticsOuter outer;
+  for( size_t i = 0; i < size; ++i )
+    outer.inners.push_back( { random_value<int32_t>(gen), random_value<double>(gen) } );
+  outer.name = random_basic_string<char>(gen);
+  return outer;
+}
+
+BOOST_AUTO_TEST_CASE( binary_statistics )
+{
+  std::mt19937 gen(std::random_device{}());
+  auto const o_outer = make_statistics_outer( gen, 100 );
+
+  std::stringstream ss;
+  cereal::Statistics saveStatistics( ss, std::ios::out );
+  {
+    cereal::BinaryOutputArchive oar( ss );
+    oar.setStatistics( &saveStatistics );
+    oar( o_outer );
+  }
+
+  auto const outer = find_entry( saveStatistics, "StatisticsOuter" );
+  auto const inner = find_entry( saveStatistics, "StatisticsInner" );
+
+  BOOST_CHECK_EQUAL( outer.count, 1 );
+  BOOST_CHECK_EQUAL( inner.count, 100 );
+  BOOST_CHECK_EQUAL( outer.bytes, ss.str().size() );
+  BOOST_CHECK_EQUAL( inner.bytes, 100 * ( sizeof(int32_t) + sizeof(double) ) );
+  BOOST_CHECK_EQUAL( find_entry( saveStatistics, "int" ).count, 100 );
+  BOOST_CHECK_EQUAL( find_entry( saveStatistics, "double" ).count, 100 );
+
+  // Names and sizes only wrap other values, and are not recorded themselves
+  for( auto const & e : saveStatistics.entries() )
+  {
+    BOOST_CHECK( e.name.find( "NameValuePair" ) == std::string::npos );
+    BOOST_CHECK( e.name.find( "SizeTag" ) == std::string::npos );
+    BOOST_CHECK_LE( e.exclusiveSeconds, e.inclusiveSeconds * 1.0001 );
+  }
+
+  // The outermost type accounts for all of the time
+  double exclusiveTotal = 0;
+  for( auto const & e : saveStatistics.entries() )
+    exclusiveTotal += e.exclusiveSeconds;
+  BOOST_CHECK_CLOSE( exclusiveTotal, outer.inclusiveSeconds, 0.01 );
+  BOOST_CHECK_EQUAL( saveStatistics.entries().front().name, "StatisticsOuter" );
+
+  StatisticsOuter i_outer;
+  cereal::Statistics loadStatistics( ss, std::ios::in );
+  {
+    cereal::BinaryInputArchive iar( ss );
+    iar.setStatistics( &loadStatistics );
+    iar( i_outer );
+  }
+
+  BOOST_CHECK_EQUAL( find_entry( loadStatistics, "StatisticsInner" ).count, 100 );
+  BOOST_CHECK_EQUAL( find_entry( loadStatistics, "StatisticsOuter" ).bytes, ss.str().size() );
+  BOOST_CHECK_EQUAL( i_outer.inners.size(), o_outer.inners.size() );
+}
+
+BOOST_AUTO_TEST_CASE( statistics_detach_and_clear )
+{
+  std::mt19937 gen(std::random_device{}());
+  auto const o_outer = make_statistics_outer( gen, 10 );
+
+  std::ostringstream os;
+  cereal::Statistics statistics;
+  cereal::BinaryOutputArchive oar( os );
+
+  oar.setStatistics( &statistics );
+  oar( o_outer );
+  oar.setStatistics( nullptr );
+  oar( o_outer );
+
+  auto const outer = find_entry( statistics, "StatisticsOuter" );
+  BOOST_CHECK_EQUAL( outer.count, 1 );
+  BOOST_CHECK_EQUAL( outer.bytes, 0 );
+
+  statistics.clear();
+  BOOST_CHECK( statistics.entries().empty() );
+}
+
+struct StatisticsTree
+{
+  std::vector<StatisticsTree> children;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( CEREAL_NVP(children) );
+  }
+};
+
+BOOST_AUTO_TEST_CASE( statistics_recursive_types )
+{
+  // A type nested within itself only counts its outermost call towards inclusive totals
+  StatisticsTree tree;
+  tree.children.resize( 4 );
+  for( auto & child : tree.children )
+    child.children.resize( 4 );
+
+  std::ostringstream os;
+  cereal::Statistics statistics( os );
+  {
+    cereal::JSONOutputArchive oar( os );
+    oar.setStatistics( &statistics );
+    oar( tree );
+  }
+
+  auto const node = find_entry( statistics, "StatisticsTree" );
+  BOOST_CHECK_EQUAL( node.count, 1 + 4 + 16 );
+  // The archive writes the end of the document outside of any type
+  BOOST_CHECK_GT( node.bytes, 0 );
+  BOOST_CHECK_LE( node.bytes, os.str().size() );
+
+  double exclusiveTotal = 0;
+  for( auto const & e : statistics.entries() )
+    exclusiveTotal += e.exclusiveSeconds;
+  BOOST_CHECK_CLOSE( exclusiveTotal, node.inclusiveSeconds, 0.01 );
+}
+
+BOOST_AUTO_TEST_CASE( statistics_reports )
+{
+  std::mt19937 gen(std::random_device{}());
+  auto const o_outer = make_statistics_outer( gen, 10 );
+
+  std::ostringstream os;
+  cereal::Statistics statistics( os );
+  {
+    cereal::JSONOutputArchive oar( os );
+    oar.setStatistics( &statistics );
+    oar( o_outer );
+  }
+
+  std::ostringstream table;
+  statistics.writeTable( table );
+  BOOST_CHECK( table.str().find( "StatisticsOuter" ) != std::string::npos );
+  BOOST_CHECK( table.str().find( "StatisticsInner" ) != std::string::npos );
+
+  std::ostringstream json;
+  statistics.writeJSON( json );
+
+  rapidjson::Document document;
+  document.Parse<0>( json.str().c_str() );
+  BOOST_REQUIRE( !document.HasParseError() );
+  BOOST_REQUIRE( document.IsArray() );
+  BOOST_CHECK_EQUAL( document.Size(), statistics.entries().size() );
+
+  bool found = false;
+  for( rapidjson::SizeType i = 0; i < document.Size(); ++i )
+    if( std::string( document[i]["type"].GetString() ) == "StatisticsInner" )
+    {
+      found = true;
+      BOOST_CHECK_EQUAL( document[i]["count"].GetUint(), 10 );
+    }
+  BOOST_CHECK( found );
+}
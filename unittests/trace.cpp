@@ -0,0 +1,233 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#define CEREAL_ENABLE_TRACING
+#include "common.hpp"
+#include <boost/test/unit_test.hpp>
+
+struct TraceInner
+{
+  int32_t x;
+  double y;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( CEREAL_NVP(x), CEREAL_NVP(y) );
+  }
+};
+
+struct TraceOuter
+{
+  std::vector<TraceInner> inners;
+  std::string name;
+
+  template <class Archive>
+  void serialize( Archive & ar )
+  {
+    ar( CEREAL_NVP(inners), CEREAL_NVP(name) );
+  }
+};
+
+TraceOuter make_trace_outer( std::mt19937 & gen, size_t size )
+{
+  TraceOuter outer;
+  for( size_t i = 0; i < size; ++i )
+    outer.inners.push_back( { random_value<int32_t>(gen), random_value<double>(gen) } );
+  outer.name = random_basic_string<char>(gen);
+  return outer;
+}
+
+size_t count_events( cereal::Tracer const & tracer, std::string const & name, std::string const & category )
+{
+  size_t count = 0;
+  for( auto const & e : tracer.events() )
+    if( e.name == name && e.category == category )
+      ++count;
+  return count;
+}
+
+template <class IArchive, class OArchive>
+void test_trace_nodes()
+{
+  std::mt19937 gen(std::random_device{}());
+  auto const o_outer = make_trace_outer( gen, 10 );
+
+  std::stringstream ss;
+  cereal::Tracer saveTracer( ss, std::ios::out );
+  {
+    OArchive oar( ss );
+    oar.setTracer( &saveTracer );
+    oar( cereal::make_nvp( "outer", o_outer ) );
+  }
+
+  BOOST_CHECK_EQUAL( count_events( saveTracer, "TraceOuter", "type" ), 1 );
+  BOOST_CHECK_EQUAL( count_events( saveTracer, "TraceInner", "type" ), 10 );
+  BOOST_CHECK_EQUAL( count_events( saveTracer, "outer", "node" ), 1 );
+  BOOST_CHECK_EQUAL( count_events( saveTracer, "inners", "node" ), 1 );
+
+  // Events finish innermost first, and every child lies within its parent
+  auto const & events = saveTracer.events();
+  BOOST_REQUIRE( !events.empty() );
+  for( auto const & e : events )
+  {
+    BOOST_CHECK_GE( e.startMicroseconds, 0 );
+    BOOST_CHECK_GE( e.microseconds, 0 );
+  }
+
+  for( auto const & e : events )
+    if( e.name == "TraceInner" )
+      for( auto const & p : events )
+        if( p.name == "TraceOuter" )
+        {
+          BOOST_CHECK_GE( e.startMicroseconds, p.startMicroseconds );
+          BOOST_CHECK_LE( e.startMicroseconds + e.microseconds, p.startMicroseconds + p.microseconds + 1e-3 );
+          BOOST_CHECK_LE( e.bytes, p.bytes );
+        }
+
+  ss.seekg( 0 );
+  TraceOuter i_outer;
+  cereal::Tracer loadTracer( ss, std::ios::in );
+  {
+    IArchive iar( ss );
+    iar.setTracer( &loadTracer );
+    iar( cereal::make_nvp( "outer", i_outer ) );
+  }
+
+  BOOST_CHECK_EQUAL( count_events( loadTracer, "TraceOuter", "type" ), 1 );
+  BOOST_CHECK_EQUAL( count_events( loadTracer, "TraceInner", "type" ), 10 );
+  BOOST_CHECK_EQUAL( count_events( loadTracer, "outer", "node" ), 1 );
+  BOOST_CHECK_EQUAL( count_events( loadTracer, "inners", "node" ), 1 );
+  BOOST_CHECK_EQUAL( i_outer.name, o_outer.name );
+}
+
+BOOST_AUTO_TEST_CASE( json_trace_nodes )
+{
+  test_trace_nodes<cereal::JSONInputArchive, cereal::JSONOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( xml_trace_nodes )
+{
+  test_trace_nodes<cereal::XMLInputArchive, cereal::XMLOutputArchive>();
+}
+
+BOOST_AUTO_TEST_CASE( binary_trace_types )
+{
+  std::mt19937 gen(std::random_device{}());
+  auto const o_outer = make_trace_outer( gen, 10 );
+
+  std::stringstream ss;
+  cereal::Tracer tracer( ss, std::ios::out );
+  {
+    cereal::BinaryOutputArchive oar( ss );
+    oar.setTracer( &tracer );
+    oar( o_outer );
+  }
+
+  BOOST_CHECK_EQUAL( count_events( tracer, "TraceInner", "type" ), 10 );
+  BOOST_CHECK_EQUAL( count_events( tracer, "TraceOuter", "type" ), 1 );
+  for( auto const & e : tracer.events() )
+    BOOST_CHECK_EQUAL( std::string( e.category ), "type" );
+
+  for( auto const & e : tracer.events() )
+    if( e.name == "TraceOuter" )
+      BOOST_CHECK_EQUAL( e.bytes, ss.str().size() );
+}
+
+BOOST_AUTO_TEST_CASE( trace_thresholds )
+{
+  std::mt19937 gen(std::random_device{}());
+  auto const o_outer = make_trace_outer( gen, 100 );
+
+  // Only the outer object and the vector holding all of the inner objects are this large
+  std::stringstream ss;
+  cereal::Tracer tracer( ss, std::ios::out, cereal::Tracer::Options( 0, 100 * sizeof(int32_t) ) );
+  {
+    cereal::BinaryOutputArchive oar( ss );
+    oar.setTracer( &tracer );
+    oar( o_outer );
+    oar.setTracer( nullptr );
+    oar( o_outer );
+  }
+
+  BOOST_CHECK_EQUAL( count_events( tracer, "TraceInner", "type" ), 0 );
+  BOOST_CHECK_EQUAL( count_events( tracer, "TraceOuter", "type" ), 1 );
+  for( auto const & e : tracer.events() )
+    BOOST_CHECK_GE( e.bytes, 100 * sizeof(int32_t) );
+
+  // An unreachable time threshold alongside keeps nothing that fails both
+  cereal::Tracer slow( cereal::Tracer::Options( 1e12 ) );
+  {
+    std::ostringstream os;
+    cereal::BinaryOutputArchive oar( os );
+    oar.setTracer( &slow );
+    oar( o_outer );
+  }
+  BOOST_CHECK( slow.events().empty() );
+
+  tracer.clear();
+  BOOST_CHECK( tracer.events().empty() );
+}
+
+BOOST_AUTO_TEST_CASE( trace_chrome_json )
+{
+  std::mt19937 gen(std::random_device{}());
+  auto const o_outer = make_trace_outer( gen, 5 );
+
+  std::stringstream ss;
+  cereal::Tracer tracer( ss, std::ios::out );
+  {
+    cereal::JSONOutputArchive oar( ss );
+    oar.setTracer( &tracer );
+    oar( cereal::make_nvp( "quoted \"name\"", o_outer ) );
+  }
+
+  std::ostringstream trace;
+  tracer.writeJSON( trace );
+
+  rapidjson::Document doc;
+  doc.Parse<0>( trace.str().c_str() );
+  BOOST_REQUIRE( !doc.HasParseError() );
+  BOOST_REQUIRE( doc.IsObject() );
+  BOOST_REQUIRE( doc.HasMember( "traceEvents" ) );
+
+  auto const & events = doc["traceEvents"];
+  BOOST_REQUIRE( events.IsArray() );
+  BOOST_CHECK_EQUAL( events.Size(), tracer.events().size() );
+
+  bool foundQuoted = false;
+  for( rapidjson::SizeType i = 0; i < events.Size(); ++i )
+  {
+    auto const & e = events[i];
+    BOOST_CHECK_EQUAL( std::string( e["ph"].GetString() ), "X" );
+    BOOST_CHECK( e["ts"].IsNumber() );
+    BOOST_CHECK( e["dur"].IsNumber() );
+    BOOST_CHECK( e["args"]["bytes"].IsNumber() );
+    if( std::string( e["name"].GetString() ) == "quoted \"name\"" )
+      foundQuoted = true;
+  }
+  BOOST_CHECK( foundQuoted );
+}
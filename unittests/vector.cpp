@@ -127,3 +127,87 @@ BOOST_AUTO_TEST_CASE( json_vector )
 }
 
 
+template <class IArchive, class OArchive, class Options>
+void test_vector_compact_arithmetic( Options const & compact, Options const & regular )
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for(int ii=0; ii<100; ++ii)
+  {
+    std::vector<double> o_doublevector(random_value<size_t>(gen) % 100);
+    for(auto & elem : o_doublevector)
+      elem = random_value<double>(gen);
+
+    std::vector<int8_t> o_charvector(random_value<size_t>(gen) % 100);
+    for(auto & elem : o_charvector)
+      elem = random_value<int8_t>(gen);
+
+    std::vector<uint32_t> o_emptyvector;
+
+    std::ostringstream os;
+    {
+      OArchive oar(os, compact);
+
+      oar(o_doublevector);
+      oar(o_charvector);
+      oar(o_emptyvector);
+    }
+
+    BOOST_CHECK( os.str().find("base64") != std::string::npos );
+
+    std::vector<double>   i_doublevector;
+    std::vector<int8_t>   i_charvector;
+    std::vector<uint32_t> i_emptyvector(3);
+
+    std::istringstream is(os.str());
+    {
+      IArchive iar(is);
+
+      iar(i_doublevector);
+      iar(i_charvector);
+      iar(i_emptyvector);
+    }
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(i_doublevector.begin(), i_doublevector.end(), o_doublevector.begin(), o_doublevector.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(i_charvector.begin(),   i_charvector.end(),   o_charvector.begin(),   o_charvector.end());
+    BOOST_CHECK(i_emptyvector.empty());
+
+    // the same archive type must still read vectors saved one element at a time
+    std::ostringstream os_regular;
+    {
+      OArchive oar(os_regular, regular);
+      oar(o_doublevector);
+    }
+
+    BOOST_CHECK( os_regular.str().find("base64") == std::string::npos );
+
+    std::vector<double> i_regularvector;
+    std::istringstream is_regular(os_regular.str());
+    {
+      IArchive iar(is_regular);
+      iar(i_regularvector);
+    }
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(i_regularvector.begin(), i_regularvector.end(), o_doublevector.begin(), o_doublevector.end());
+  }
+}
+
+BOOST_AUTO_TEST_CASE( xml_vector_compact_arithmetic )
+{
+  using Options = cereal::XMLOutputArchive::Options;
+  test_vector_compact_arithmetic<cereal::XMLInputArchive, cereal::XMLOutputArchive>(
+      Options( std::numeric_limits<double>::max_digits10, true, false, false, true ),
+      Options( std::numeric_limits<double>::max_digits10, true, false, false, false ) );
+  test_vector_compact_arithmetic<cereal::XMLInputArchive, cereal::XMLOutputArchive>(
+      Options( std::numeric_limits<double>::max_digits10, true, false, true, true ),
+      Options( std::numeric_limits<double>::max_digits10, true, false, true, false ) );
+}
+
+BOOST_AUTO_TEST_CASE( json_vector_compact_arithmetic )
+{
+  using Options = cereal::JSONOutputArchive::Options;
+  test_vector_compact_arithmetic<cereal::JSONInputArchive, cereal::JSONOutputArchive>(
+      Options( std::numeric_limits<double>::max_digits10, Options::IndentChar::space, 4, true ),
+      Options( std::numeric_limits<double>::max_digits10, Options::IndentChar::space, 4, false ) );
+}
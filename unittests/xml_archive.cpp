@@ -0,0 +1,271 @@
+/*
+  Copyright (c) 2014, Randolph Voorhies, Shane Grant
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+      * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+      * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+      * Neither the name of cereal nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL RANDOLPH VOORHIES AND SHANE GRANT BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "common.hpp"
+#include <boost/test/unit_test.hpp>
+
+//! A stream buffer that cannot seek and hands out its data a few characters at a time
+class NonSeekableBuffer : public std::streambuf
+{
+  public:
+    NonSeekableBuffer( std::string const & data ) : itsData( data ), itsPosition( 0 ) {}
+
+  protected:
+    int_type underflow() override
+    {
+      if( itsPosition >= itsData.size() )
+        return traits_type::eof();
+
+      auto const count = std::min<size_t>( 7, itsData.size() - itsPosition );
+      auto begin = &itsData[itsPosition];
+      setg( begin, begin, begin + count );
+      itsPosition += count;
+      return traits_type::to_int_type( *begin );
+    }
+
+  private:
+    std::string itsData;
+    size_t itsPosition;
+};
+
+//! A stream buffer that only accepts a limited number of characters
+class FullBuffer : public std::streambuf
+{
+  public:
+    FullBuffer( size_t capacity ) : itsCapacity( capacity ) {}
+
+  protected:
+    int_type overflow( int_type c ) override
+    {
+      if( traits_type::eq_int_type( c, traits_type::eof() ) || !itsCapacity )
+        return traits_type::eof();
+
+      --itsCapacity;
+      return c;
+    }
+
+  private:
+    size_t itsCapacity;
+};
+
+TextArchiveData make_xml_archive_data()
+{
+  std::mt19937 gen(std::random_device{}());
+  return make_text_archive_data( gen, 2000, " &lt; <escaped> & padded " );
+}
+
+std::string save_xml_archive_data( TextArchiveData const & data )
+{
+  std::ostringstream os;
+  {
+    cereal::XMLOutputArchive oar(os);
+    oar( data );
+  }
+  return os.str();
+}
+
+template <class Loader>
+void check_xml_archive_load( TextArchiveData const & o_data, Loader && load )
+{
+  TextArchiveData i_data;
+  load( i_data );
+  BOOST_CHECK_EQUAL( i_data, o_data );
+}
+
+BOOST_AUTO_TEST_CASE( xml_archive_constructors )
+{
+  auto const o_data = make_xml_archive_data();
+  auto const xml = save_xml_archive_data( o_data );
+
+  // seekable stream, starting part way through
+  check_xml_archive_load( o_data, [&]( TextArchiveData & i_data )
+  {
+    std::istringstream is( "ignored" + xml );
+    is.seekg( 7 );
+    cereal::XMLInputArchive iar(is);
+    iar( i_data );
+  } );
+
+  // non seekable stream
+  check_xml_archive_load( o_data, [&]( TextArchiveData & i_data )
+  {
+    NonSeekableBuffer buffer( xml );
+    std::istream is( &buffer );
+    cereal::XMLInputArchive iar(is);
+    iar( i_data );
+  } );
+
+  // owned buffer, without a null terminator
+  check_xml_archive_load( o_data, [&]( TextArchiveData & i_data )
+  {
+    cereal::XMLInputArchive iar( std::vector<char>( xml.begin(), xml.end() ) );
+    iar( i_data );
+  } );
+
+  // borrowed buffer
+  check_xml_archive_load( o_data, [&]( TextArchiveData & i_data )
+  {
+    std::vector<char> buffer( xml.c_str(), xml.c_str() + xml.size() + 1 );
+    cereal::XMLInputArchive iar( buffer.data() );
+    iar( i_data );
+  } );
+
+  std::vector<char> empty;
+  BOOST_CHECK_THROW( cereal::XMLInputArchive iar( std::move( empty ) ), cereal::Exception );
+}
+
+template <class Archive>
+void save_streaming_test_data( Archive & ar, TextArchiveData const & data )
+{
+  std::vector<int> empty_vector;
+  std::string empty_string;
+  std::map<int, std::string> specials = { {1, "quotes \" and ' and <tags> & more"}, {2, " padded "} };
+  auto shared = std::make_shared<StructInternalSplit>( 1, 2 );
+  std::unique_ptr<double> null_ptr;
+  std::array<char, 4> binary = {{ 'a', '\0', '<', '"' }};
+
+  ar( data, CEREAL_NVP(empty_vector), CEREAL_NVP(empty_string), specials, shared, shared, null_ptr );
+  ar.saveBinaryValue( binary.data(), binary.size(), "binary" );
+  ar.setNextName( "attributes" );
+  ar.startNode();
+  ar.appendAttribute( "quoted", "say \"hi\"" );
+  ar.appendAttribute( "plain", "<&>" );
+  ar.finishNode();
+}
+
+BOOST_AUTO_TEST_CASE( xml_archive_streaming )
+{
+  auto const o_data = make_xml_archive_data();
+
+  for( bool indent : {true, false} )
+    for( bool outputType : {true, false} )
+    {
+      std::ostringstream dom, streaming;
+      {
+        cereal::XMLOutputArchive oar( dom, cereal::XMLOutputArchive::Options( 17, indent, outputType ) );
+        save_streaming_test_data( oar, o_data );
+      }
+      {
+        cereal::XMLOutputArchive oar( streaming, cereal::XMLOutputArchive::Options( 17, indent, outputType, true ) );
+        save_streaming_test_data( oar, o_data );
+      }
+
+      BOOST_CHECK_EQUAL( dom.str(), streaming.str() );
+
+      TextArchiveData i_data;
+      std::istringstream is( streaming.str() );
+      {
+        cereal::XMLInputArchive iar(is);
+        iar( i_data );
+      }
+      BOOST_CHECK_EQUAL( i_data, o_data );
+    }
+
+  // nothing is buffered, output starts right away
+  std::ostringstream os;
+  {
+    cereal::XMLOutputArchive oar( os, cereal::XMLOutputArchive::Options( 17, true, false, true ) );
+    oar( 5 );
+    BOOST_CHECK( os.str().find( "<value0>5</value0>" ) != std::string::npos );
+
+    oar.setNextName( "late" );
+    oar.startNode();
+    oar( 1 );
+    BOOST_CHECK_THROW( oar.appendAttribute( "too", "late" ), cereal::Exception );
+    oar.finishNode();
+  }
+}
+
+BOOST_AUTO_TEST_CASE( xml_archive_streaming_failure )
+{
+  auto const o_data = make_xml_archive_data();
+
+  // a stream that fills up is marked bad, whether it fills while streaming or on destruction
+  for( size_t capacity : { 0, 10, 1000 } )
+    for( bool streaming : {true, false} )
+    {
+      FullBuffer buffer( capacity );
+      std::ostream os( &buffer );
+      {
+        cereal::XMLOutputArchive oar( os, cereal::XMLOutputArchive::Options( 17, true, false, streaming ) );
+        oar( o_data );
+      }
+      BOOST_CHECK( os.bad() );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( xml_archive_context )
+{
+  cereal::XMLContext context;
+
+  for( int i = 0; i < 3; ++i )
+  {
+    auto const o_data = make_xml_archive_data();
+
+    for( bool outputType : {true, false} )
+    {
+      std::ostringstream os, os_context;
+      {
+        cereal::XMLOutputArchive oar( os, cereal::XMLOutputArchive::Options( 17, true, outputType ) );
+        save_streaming_test_data( oar, o_data );
+      }
+      {
+        cereal::XMLOutputArchive oar( os_context, context, cereal::XMLOutputArchive::Options( 17, true, outputType ) );
+        save_streaming_test_data( oar, o_data );
+      }
+
+      BOOST_CHECK_EQUAL( os.str(), os_context.str() );
+
+      check_xml_archive_load( o_data, [&]( TextArchiveData & i_data )
+      {
+        std::istringstream is( os_context.str() );
+        cereal::XMLInputArchive iar( is, context );
+        iar( i_data );
+      } );
+    }
+  }
+
+  // names that do not outlive the archive are still safe to use
+  std::ostringstream os;
+  {
+    cereal::XMLOutputArchive oar( os, context );
+    for( int i = 0; i < 2; ++i )
+    {
+      std::string name = "temporary" + std::to_string( i );
+      oar( cereal::make_nvp( name.c_str(), i ) );
+      name.assign( name.size(), 'x' );
+    }
+  }
+  BOOST_CHECK( os.str().find( "<temporary0>0</temporary0>" ) != std::string::npos );
+  BOOST_CHECK( os.str().find( "<temporary1>1</temporary1>" ) != std::string::npos );
+
+  // a context cannot be shared by archives that are alive at the same time
+  {
+    std::ostringstream first, second;
+    cereal::XMLOutputArchive oar( first, context );
+    BOOST_CHECK_THROW( cereal::XMLOutputArchive( second, context ), cereal::Exception );
+  }
+}